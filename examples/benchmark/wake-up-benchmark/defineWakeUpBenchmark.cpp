@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <benchmark/benchmark.h>
+#include <anira/anira.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64)
+#include <immintrin.h>
+#endif
+
+/* ============================================================ *
+ * ========================= Configs ========================== *
+ * ============================================================ */
+
+#define NUM_ITERATIONS 200
+#define NUM_REPETITIONS 5
+// The time between two wake-ups, long enough for the waiting thread to reach its idle phase
+#define IDLE_TIME_US 2000
+
+/* ============================================================ *
+ * ===================== WAITING THREADS ====================== *
+ * ============================================================ */
+
+// Waits for a flag like an idle InferenceThread waits for new work and stamps the time it noticed it
+class WaitingThread : public anira::HighPriorityThread {
+public:
+    void signal() {
+        m_start = std::chrono::steady_clock::now();
+        m_flag.store(true, std::memory_order::release);
+        notify();
+    }
+
+    std::chrono::steady_clock::duration wait_for_ack() {
+        while (!m_ack.exchange(false, std::memory_order::acquire)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+        }
+        return m_end - m_start;
+    }
+
+protected:
+    virtual void notify() {}
+
+    bool try_take() {
+        if (m_flag.exchange(false, std::memory_order::acquire)) {
+            m_end = std::chrono::steady_clock::now();
+            m_ack.store(true, std::memory_order::release);
+            return true;
+        }
+        return false;
+    }
+
+    std::atomic<bool> m_flag{false};
+
+private:
+    std::atomic<bool> m_ack{false};
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_end;
+};
+
+// The backoff the InferenceThread used before parking: spin, pause and then poll every 100us
+class BackoffThread : public WaitingThread {
+public:
+    ~BackoffThread() override { stop(); }
+
+    void run() override {
+        while (!should_exit()) {
+            for (int i = 0; i < 4; i++) {
+                if (try_take()) break;
+            }
+            for (int i = 0; i < 32; i++) {
+                if (try_take()) break;
+#if defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64)
+                _mm_pause();
+                _mm_pause();
+#elif __aarch64__
+                asm volatile("isb sy");
+                asm volatile("isb sy");
+#endif
+            }
+            while (!should_exit()) {
+                if (try_take()) break;
+                std::this_thread::yield();
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+};
+
+// Parks on an EventCount like the InferenceThread does now
+class ParkingThread : public WaitingThread {
+public:
+    ~ParkingThread() override { stop(); }
+
+    void run() override {
+        while (!should_exit()) {
+            if (try_take()) continue;
+            uint32_t key = m_event_count.prepare_wait();
+            if (should_exit() || m_flag.load(std::memory_order::acquire)) {
+                m_event_count.cancel_wait();
+                continue;
+            }
+            m_event_count.wait(key);
+        }
+    }
+
+protected:
+    void notify() override { m_event_count.notify_one(); }
+    void wake_up() override { m_event_count.notify_all(); }
+
+private:
+    anira::EventCount m_event_count;
+};
+
+/* ============================================================ *
+ * ================== BENCHMARK DEFINITIONS =================== *
+ * ============================================================ */
+
+template <typename T>
+static void measure_wake_up(::benchmark::State& state) {
+    T waiting_thread;
+    waiting_thread.start();
+
+    for (auto _ : state) {
+        std::this_thread::sleep_for(std::chrono::microseconds(IDLE_TIME_US));
+        waiting_thread.signal();
+        auto latency = waiting_thread.wait_for_ack();
+        state.SetIterationTime(std::chrono::duration<double>(latency).count());
+    }
+
+    waiting_thread.stop();
+}
+
+static void BM_WAKE_UP_BACKOFF(::benchmark::State& state) {
+    measure_wake_up<BackoffThread>(state);
+}
+
+static void BM_WAKE_UP_EVENTCOUNT(::benchmark::State& state) {
+    measure_wake_up<ParkingThread>(state);
+}
+
+// /* ============================================================ *
+//  * ================== BENCHMARK REGISTRATION ================== *
+//  * ============================================================ */
+
+BENCHMARK(BM_WAKE_UP_BACKOFF)
+->Unit(benchmark::kMicrosecond)
+->Iterations(NUM_ITERATIONS)->Repetitions(NUM_REPETITIONS)
+->UseManualTime();
+
+BENCHMARK(BM_WAKE_UP_EVENTCOUNT)
+->Unit(benchmark::kMicrosecond)
+->Iterations(NUM_ITERATIONS)->Repetitions(NUM_REPETITIONS)
+->UseManualTime();
@@ -38,7 +38,18 @@ struct ANIRA_API ContextConfig {
     std::string m_anira_version = ANIRA_VERSION;
     std::vector<InferenceBackend> m_enabled_backends;
     bool m_use_controlled_blocking;
-    
+
+    // Cores the inference threads are pinned to, one core per thread in round robin. Empty means all cores.
+    std::vector<int> m_thread_cores;
+    // Cores the inference threads must not run on, e.g. those the audio thread is pinned to, see CpuAffinity::get_caller_cores
+    std::vector<int> m_excluded_cores;
+    // Keeps the inference threads on the cores of this NUMA node, -1 means no preference
+    int m_numa_node = -1;
+
+    // Locks the buffers of all sessions into RAM, so that the real-time threads never page-fault on them
+    bool m_lock_memory = false;
+    // Backs the large ring buffers of the sessions with huge pages
+    bool m_use_huge_pages = false;
 
     bool operator==(const ContextConfig& other) const {
         return
@@ -46,7 +57,12 @@ struct ANIRA_API ContextConfig {
             m_use_host_threads == other.m_use_host_threads &&
             m_anira_version == other.m_anira_version &&
             m_enabled_backends == other.m_enabled_backends &&
-            m_use_controlled_blocking == other.m_use_controlled_blocking;
+            m_use_controlled_blocking == other.m_use_controlled_blocking &&
+            m_thread_cores == other.m_thread_cores &&
+            m_excluded_cores == other.m_excluded_cores &&
+            m_numa_node == other.m_numa_node &&
+            m_lock_memory == other.m_lock_memory &&
+            m_use_huge_pages == other.m_use_huge_pages;
 
     }
 
@@ -20,6 +20,13 @@ enum IndexAudioData : size_t {
 
 typedef std::vector<std::vector<int64_t>> TensorShapeList;
 
+enum class WarmUpPolicy {
+    // Every parallel processor runs the warm up inferences
+    PerInstance,
+    // Only the first parallel processor runs them, which is enough when the instances share the model and its caches, like the ONNX Runtime instances share their session
+    Shared
+};
+
 struct ModelData {
     ModelData(void* data, size_t size, InferenceBackend backend, bool is_binary = true) : m_data(data), m_size(size), m_backend(backend), m_is_binary(is_binary) {}
     ModelData(std::string model_path, InferenceBackend backend, bool is_binary = false) : m_size(model_path.size()), m_backend(backend), m_is_binary(is_binary) {
@@ -144,8 +151,13 @@ public:
     TensorShapeList get_input_shape(InferenceBackend backend);
     TensorShapeList get_output_shape(InferenceBackend backend);
     void set_model_path(const std::string& model_path, InferenceBackend backend);
+    // Replaces the model of its backend or adds it, a model without tensor shape of its own gets the universal one
+    void set_model_data(const ModelData& model_data);
     void set_input_shape(const TensorShapeList& input_shape, InferenceBackend backend);
     void set_output_shape(const TensorShapeList& output_shape, InferenceBackend backend);
+    // Resizes the time axis, given by m_time_axis, of the audio tensors of all backends, so that an inference outputs chunk_size samples per channel. Returns false and keeps the shapes if a dimension would become empty.
+    bool set_chunk_size(size_t chunk_size);
+    size_t get_chunk_size() const;
 
     std::vector<ModelData> m_model_data;
     std::vector<TensorShape> m_tensor_shape;
@@ -160,6 +172,34 @@ public:
 #ifdef USE_CONTROLLED_BLOCKING
     float m_wait_in_process_block;
 #endif
+
+    // The following options have no constructor parameter and are set after construction
+    // Runs pre_process and post_process on the inference threads, so that the real-time thread only pushes and pops raw samples
+    bool m_offload_pre_post_processing = false;
+    // Maximum number of inferences of sessions sharing a processor that are stacked along the first dimension and processed in one backend call, 1 disables batching
+    unsigned int m_max_batch_size = 1;
+    // Number of inferences a session can have in flight, 0 derives it from the latency
+    unsigned int m_num_inference_structs = 0;
+    // Capacity of the send and receive ring buffers in samples per channel, 0 derives it from the latency. Capacities below the derived ones are raised to them.
+    size_t m_ring_buffer_capacity = 0;
+    // Maps the send buffer twice in virtual memory, so that mono model inputs point into its history instead of copying it. Only supported on Linux.
+    bool m_mirrored_ring_buffer = false;
+    // Number of inferences prepare runs on the thread pool to measure the inference time, which then replaces m_max_inference_time for the latency. 0 disables the calibration.
+    unsigned int m_calibration_runs = 0;
+    // Percentile of the measured inference times that is used, also by the latency monitor
+    float m_calibration_percentile = 99.f;
+    // Factor applied to the measured percentile as safety margin
+    float m_calibration_headroom = 1.5f;
+    // Which of the parallel processors run the m_warm_up inferences, they are built and warmed up on temporary threads in parallel
+    WarmUpPolicy m_warm_up_policy = WarmUpPolicy::PerInstance;
+    // Candidate numbers of samples per channel and inference for models with a dynamic time axis. prepare benchmarks them and resizes the audio tensors to the smallest that keeps up with the host buffer. Empty keeps the tensor shapes.
+    std::vector<size_t> m_chunk_sizes;
+    // Index of the time axis in the audio input and output tensor, which set_chunk_size resizes. Negative indices count from the last dimension.
+    std::array<int, 2> m_time_axis = {-1, -1};
+    // Pairs of input and output tensor indices of a recurrent state. The session keeps the state and feeds the output of one inference to the input of the next, so stateful models can share processors between sessions.
+    std::vector<std::array<size_t, 2>> m_state_indices;
+    // Sample rate the model was trained at. The session resamples its audio from the host sample rate to this rate and back, so the PrePostProcessor and the model run at it. 0 runs the model at the host sample rate.
+    double m_model_sample_rate = 0.;
     
     std::vector<size_t> m_input_sizes;
     std::vector<size_t> m_output_sizes;
@@ -178,6 +218,19 @@ public:
 #ifdef USE_CONTROLLED_BLOCKING
             std::abs(m_wait_in_process_block - other.m_wait_in_process_block) < 1e-6 &&
 #endif
+            m_offload_pre_post_processing == other.m_offload_pre_post_processing &&
+            m_max_batch_size == other.m_max_batch_size &&
+            m_num_inference_structs == other.m_num_inference_structs &&
+            m_ring_buffer_capacity == other.m_ring_buffer_capacity &&
+            m_mirrored_ring_buffer == other.m_mirrored_ring_buffer &&
+            m_calibration_runs == other.m_calibration_runs &&
+            std::abs(m_calibration_percentile - other.m_calibration_percentile) < 1e-6 &&
+            std::abs(m_calibration_headroom - other.m_calibration_headroom) < 1e-6 &&
+            m_warm_up_policy == other.m_warm_up_policy &&
+            m_state_indices == other.m_state_indices &&
+            m_chunk_sizes == other.m_chunk_sizes &&
+            m_time_axis == other.m_time_axis &&
+            std::abs(m_model_sample_rate - other.m_model_sample_rate) < 1e-6 &&
             m_input_sizes == other.m_input_sizes &&
             m_output_sizes == other.m_output_sizes;
     }
@@ -186,6 +239,8 @@ public:
         return !(*this == other);
     }
 
+private:
+    void update_sizes();
 };
 
 } // namespace anira
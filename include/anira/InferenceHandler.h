@@ -20,10 +20,32 @@ public:
 
     void prepare(HostAudioConfig new_audio_config);
 
+    // Renders offline with the next prepare, e.g. for bounces. process then waits for the inferences instead of dropping samples, splits large blocks into inferences for the whole thread pool and runs as fast as the CPU allows.
+    // The output equals the real-time output, but the latency no longer includes the inference time.
+    void set_non_realtime(bool non_realtime);
+    bool is_non_realtime();
+
     void process(float* const* data, size_t num_samples); // data[channel][index]
     void process(const float* const* input_data, float* const* output_data, size_t num_samples); // data[channel][index]
 
     int get_latency();
+    // Samples per channel and inference, the candidate of InferenceConfig::m_chunk_sizes that the last prepare selected
+    size_t get_chunk_size();
+
+    // Telemetry of this session, meant to be polled from a non real-time thread
+    InferenceStats get_stats();
+    void reset_stats();
+
+    // Called from a background thread when the measured inference times drift so far that another latency is required. Takes effect with the next prepare, which must not be called from within the callback.
+    void set_latency_change_callback(std::function<void(int requested_latency)> callback);
+
+    // Loads the model on a background thread and swaps it in at an inference boundary, while the audio keeps running through the previous model. The model must have the tensor shapes of the config.
+    // With crossfade_samples > 0, the output fades from the previous to the new model over that many samples, rounded up to whole inferences. Returns false if the previous swap is still in progress.
+    bool load_model_async(const ModelData& model_data, size_t crossfade_samples = 0);
+    // Same for a prepared custom processor, the previous custom processor must stay alive until is_swapping_model returns false
+    bool set_custom_processor_async(BackendBase& custom_processor, size_t crossfade_samples = 0);
+    // True until the new model took over and the previous one is no longer used
+    bool is_swapping_model();
 
     void exec_inference();
 
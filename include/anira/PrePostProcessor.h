@@ -3,6 +3,7 @@
 
 #include "utils/RingBuffer.h"
 #include "utils/InferenceBackend.h"
+#include "utils/TensorBlock.h"
 #include "anira/system/AniraWinExports.h"
 #include "InferenceConfig.h"
 #include <atomic>
@@ -26,9 +27,16 @@ public:
     float get_input(size_t i, size_t j);
     float get_output(size_t i, size_t j);
 
+    // Copy whole non-audio tensors at once, a reader always gets a snapshot of one complete write
+    void set_input_tensor(const float* input, size_t i);
+    void set_output_tensor(const float* output, size_t i);
+    void get_input_tensor(float* input, size_t i);
+    void get_output_tensor(float* output, size_t i);
+
 public:
     void pop_samples_from_buffer(RingBuffer& input, AudioBufferF& output);
 
+    // If the input is mirrored and the output is a mono buffer of num_new_samples + num_old_samples, the output becomes a view of the window instead of a copy
     void pop_samples_from_buffer(RingBuffer& input, AudioBufferF& output, size_t num_new_samples, size_t num_old_samples);
 
     void pop_samples_from_buffer(RingBuffer& input, AudioBufferF& output, size_t num_new_samples, size_t num_old_samples, size_t offset);
@@ -36,8 +44,8 @@ public:
     void push_samples_to_buffer(const AudioBufferF& input, RingBuffer& output);
 
 private:
-    std::vector<MemoryBlock<std::atomic<float>>> m_inputs;
-    std::vector<MemoryBlock<std::atomic<float>>> m_outputs;
+    std::vector<TensorBlock> m_inputs;
+    std::vector<TensorBlock> m_outputs;
 
     std::array<size_t, 2> m_index_audio_data;
 };
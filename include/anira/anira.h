@@ -11,10 +11,24 @@
 #include "scheduler/InferenceThread.h"
 #include "scheduler/Context.h"
 #include "scheduler/SessionElement.h"
+#include "scheduler/DeadlineQueue.h"
+#include "scheduler/WorkerQueues.h"
+#include "utils/Allocator.h"
 #include "utils/AudioBuffer.h"
+#include "utils/FreeList.h"
+#include "utils/Resampler.h"
 #include "utils/HostAudioConfig.h"
 #include "utils/InferenceBackend.h"
+#include "utils/InferenceStats.h"
+#include "utils/LatencyHistogram.h"
+#include "utils/MirroredMemory.h"
+#include "utils/ModelCache.h"
+#include "utils/ParallelFor.h"
 #include "utils/RingBuffer.h"
+#include "utils/TensorBlock.h"
 #include "system/HighPriorityThread.h"
+#include "system/EventCount.h"
+#include "system/CpuAffinity.h"
+#include "system/RealtimeLogger.h"
 
 #endif // ANIRA_H
\ No newline at end of file
@@ -3,20 +3,59 @@
 
 #include "../InferenceConfig.h"
 #include "../utils/AudioBuffer.h"
+#include "../utils/FreeList.h"
 #include "../system/AniraWinExports.h"
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace anira {
 
-class SessionElement; // Forward declaration as we have a circular dependency
+// Forward declarations as we have a circular dependency
+class SessionElement;
+struct InferenceData;
+class WorkerQueues;
 
 class ANIRA_API BackendBase {
 public:
     BackendBase(InferenceConfig& inference_config);
+    virtual ~BackendBase();
     virtual void prepare();
+    // Called before the inferences of a session reach the processor, i.e. whenever the session was prepared or the processor is swapped in, and before the session is released. Other sessions may be processing meanwhile.
+    virtual void prepare_session(SessionElement& session);
+    virtual void release_session(int session_id);
     virtual void process(AudioBufferF& input, AudioBufferF& output, [[maybe_unused]] std::shared_ptr<SessionElement> session);
+    // Processes the inferences of several sessions sharing this processor, the default implementation processes them one after another
+    virtual void process_batch(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions);
+    // Return false without processing when all instances of the processor are busy, so that the inference waits on the processor instead of blocking the inference thread, see release_instance. The default implementations always process.
+    virtual bool try_process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session);
+    virtual bool try_process_batch(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions);
+
+    // Called by the inference threads. Like try_process, but an inference that finds all instances busy waits on the processor until the next instance is released, which resubmits it to the queues.
+    bool try_process_or_wait(AudioBufferF& input, AudioBufferF& output, const InferenceData& inference_data, WorkerQueues& queues);
+    bool try_process_batch_or_wait(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions, const std::vector<InferenceData>& batch, WorkerQueues& queues);
+    // Set by the inference threads around processing. A release that cannot resubmit a waiting inference because the queues are full appends it to the vector, and the thread processes it afterwards. It stays counted as active until then.
+    static void set_unsubmitted_inferences(std::vector<InferenceData>* unsubmitted_inferences);
 
     InferenceConfig& m_inference_config;
+    // Cleared at construction by the backends whose model cannot run batches in one call, e.g. because its first dimension is not dynamic. The inference threads then do not collect batches for the processor.
+    bool m_batching_supported = true;
+
+protected:
+    // Backends that return false from try_process must release their instances through this, otherwise the inferences waiting for an instance are never resubmitted
+    void release_instance(FreeList& free_instances, size_t index);
+
+private:
+    void wait_for_instance(const InferenceData* inference_data, size_t num_inferences, WorkerQueues& queues, uint64_t num_released_instances);
+    void resubmit_waiting_inference();
+
+    // Only taken by inferences that found all instances busy and by releases while some of them wait
+    std::mutex m_waiting_mutex;
+    std::vector<InferenceData> m_waiting_inferences;
+    WorkerQueues* m_waiting_queues = nullptr;
+    std::atomic<size_t> m_num_waiting_inferences{0};
+    std::atomic<uint64_t> m_num_released_instances{0};
 };
 
 } // namespace anira
@@ -18,6 +18,10 @@
 #include "../utils/AudioBuffer.h"
 #include "BackendBase.h"
 #include "../scheduler/SessionElement.h"
+#include "../utils/ModelCache.h"
+#include "../utils/ParallelFor.h"
+#include "../utils/FreeList.h"
+#include "../system/RealtimeLogger.h"
 #include <stdlib.h>
 #include <memory>
 
@@ -48,12 +52,20 @@ public:
 
     void prepare() override;
     void process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) override;
+    bool try_process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) override;
+    void process_batch(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions) override;
+    bool try_process_batch(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions) override;
 
 private:
     struct Instance {
-        Instance(InferenceConfig& inference_config);
+        Instance(InferenceConfig& inference_config, const torch::jit::script::Module& module);
+        void warm_up();
         void prepare();
         void process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session);
+        void process_batch(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions);
+        // TorchScript modules do not declare their shapes, so a batch of two is run once to find out whether the first dimension is dynamic
+        bool check_batching();
+        torch::Tensor get_output_tensor(const c10::IValue& outputs, size_t index);
 
         torch::jit::script::Module m_module;
 
@@ -62,11 +74,20 @@ private:
         std::vector<c10::IValue> m_inputs;
         c10::IValue m_outputs;
 
+        // Only allocated when batching is enabled, the inputs are stacked along the first dimension
+        std::vector<MemoryBlock<float>> m_batch_input_data;
+        std::vector<std::vector<int64_t>> m_batch_input_shapes;
+        std::vector<c10::IValue> m_batch_inputs;
+
         InferenceConfig& m_inference_config;
-        std::atomic<bool> m_processing {false};
     };
     
+    // The model is loaded once and shared through the ModelCache, the instances hold clones of it that share its parameters
+    std::shared_ptr<torch::jit::script::Module> m_module;
+
     std::vector<std::shared_ptr<Instance>> m_instances;
+    // Indices of the instances that are not processing
+    FreeList m_free_instances;
 };
 
 } // namespace anira
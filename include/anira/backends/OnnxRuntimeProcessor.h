@@ -7,8 +7,13 @@
 #include "../InferenceConfig.h"
 #include "../utils/AudioBuffer.h"
 #include "../scheduler/SessionElement.h"
+#include "../utils/ModelCache.h"
+#include "../utils/ParallelFor.h"
+#include "../utils/FreeList.h"
+#include "../system/RealtimeLogger.h"
 
 #include <onnxruntime_cxx_api.h>
+#include <unordered_map>
 
 namespace anira {
 
@@ -18,38 +23,82 @@ public:
     ~OnnxRuntimeProcessor();
 
     void prepare() override;
+    // Creates the tensors over the buffers of the session in every instance, see Instance::m_session_tensors
+    void prepare_session(SessionElement& session) override;
+    void release_session(int session_id) override;
     void process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) override;
+    bool try_process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) override;
+    void process_batch(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions) override;
+    bool try_process_batch(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions) override;
 
 private:
     struct Instance {
-        Instance(InferenceConfig& inference_config);
-        ~Instance();
+        Instance(InferenceConfig& inference_config, Ort::Session& session, const std::vector<const char*>& input_names, const std::vector<const char*>& output_names, bool batching);
 
+        void warm_up();
         void prepare();
+        void prepare_session(SessionElement& session);
         void process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session);
+        void process_batch(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions);
+        // Tensor over the audio data of the buffer, nullptr if the session has none for it, e.g. for the copies of a crossfade
+        OrtValue* get_session_tensor(int session_id, AudioBufferF& buffer, bool input);
 
         Ort::MemoryInfo m_memory_info;
-        Ort::Env m_env;
-        Ort::AllocatorWithDefaultOptions m_ort_alloc;
-        Ort::SessionOptions m_session_options;
-
-        std::unique_ptr<Ort::Session> m_session;
+        Ort::Session& m_session;
+        const std::vector<const char*>& m_input_names;
+        const std::vector<const char*>& m_output_names;
 
+        // The tensors are created once over these buffers, so that Run writes into them instead of allocating new tensors. The audio tensors are only used for buffers the session has no tensors for, see get_session_tensor.
         std::vector<MemoryBlock<float>> m_input_data;
         std::vector<Ort::Value> m_inputs;
+        std::vector<MemoryBlock<float>> m_output_data;
         std::vector<Ort::Value> m_outputs;
+        // Passed to Run, the audio slots point to the tensors over the session buffers of the current inference
+        std::vector<const OrtValue*> m_input_values;
+        std::vector<OrtValue*> m_output_values;
+
+        // Only allocated when batching is enabled, the inputs are stacked along the first dimension. The tensors are indexed by the batch size.
+        std::vector<MemoryBlock<float>> m_batch_input_data;
+        std::vector<std::vector<Ort::Value>> m_batch_inputs;
+        std::vector<MemoryBlock<float>> m_batch_output_data;
+        std::vector<std::vector<Ort::Value>> m_batch_outputs;
+
+        // Tensors over the audio buffers of the structs and over the windows of a mirrored send buffer, keyed by their data, so that Run reads and writes the session buffers in place.
+        // Only the thread that holds the instance touches them. The backends may swap the buffers of a struct with their own, which is why the tensors are looked up by the data of the buffer.
+        struct SessionTensors {
+            std::unordered_map<const float*, Ort::Value> m_inputs;
+            std::unordered_map<const float*, Ort::Value> m_outputs;
+        };
+        std::unordered_map<int, SessionTensors> m_session_tensors;
+
+        InferenceConfig& m_inference_config;
+    };
+
+    // The model is loaded once and shared through the ModelCache by all instances and all processors of the same model, Run can be called concurrently on one session. The instances only hold the buffers of their inferences.
+    struct Model {
+        Model(InferenceConfig& inference_config);
+        ~Model();
+
+        std::shared_ptr<Ort::Env> m_env;
+        Ort::AllocatorWithDefaultOptions m_ort_alloc;
+        Ort::SessionOptions m_session_options;
+        std::unique_ptr<Ort::Session> m_session;
 
         std::vector<Ort::AllocatedStringPtr> m_input_name;
         std::vector<Ort::AllocatedStringPtr> m_output_name;
-
-        std::vector<const char *> m_output_names;
         std::vector<const char *> m_input_names;
-
-        InferenceConfig& m_inference_config;
-        std::atomic<bool> m_processing {false};
+        std::vector<const char *> m_output_names;
+        // Whether the first dimension of all inputs and outputs is dynamic, so that batches can be stacked along it
+        bool m_dynamic_batch = true;
     };
 
+    // One environment for the whole process, it lives as long as any model uses it
+    static std::shared_ptr<Ort::Env> get_env();
+
+    std::shared_ptr<Model> m_model;
     std::vector<std::shared_ptr<Instance>> m_instances;
+    // Indices of the instances that are not processing
+    FreeList m_free_instances;
 };
 
 } // namespace anira
@@ -7,6 +7,9 @@
 #include "../InferenceConfig.h"
 #include "../utils/AudioBuffer.h"
 #include "../scheduler/SessionElement.h"
+#include "../utils/ModelCache.h"
+#include "../utils/ParallelFor.h"
+#include "../utils/FreeList.h"
 #include <tensorflow/lite/c_api.h>
 #include <memory>
 
@@ -19,16 +22,17 @@ public:
 
     void prepare() override;
     void process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) override;
+    bool try_process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) override;
 
 private:
     struct Instance {
-        Instance(InferenceConfig& inference_config);
+        Instance(InferenceConfig& inference_config, TfLiteModel* model);
         ~Instance();
         
+        void warm_up();
         void prepare();
         void process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session);
 
-        TfLiteModel* m_model;
         TfLiteInterpreterOptions* m_options;
         TfLiteInterpreter* m_interpreter;
 
@@ -38,10 +42,14 @@ private:
         std::vector<const TfLiteTensor*> m_outputs;
 
         InferenceConfig& m_inference_config;
-        std::atomic<bool> m_processing {false};
     };
 
+    // The model is loaded once and shared through the ModelCache by the interpreters of all instances and processors
+    std::shared_ptr<TfLiteModel> m_model;
+
     std::vector<std::shared_ptr<Instance>> m_instances;
+    // Indices of the instances that are not processing
+    FreeList m_free_instances;
 };
 
 } // namespace anira
@@ -3,14 +3,15 @@
 
 #include <atomic>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "../ContextConfig.h"
 #include "SessionElement.h"
 #include "InferenceThread.h"
+#include "WorkerQueues.h"
 #include "../PrePostProcessor.h"
 #include "../utils/HostAudioConfig.h"
-#include <concurrentqueue.h>
 
 #ifdef USE_LIBTORCH
     #include "../backends/LibTorchProcessor.h"
@@ -22,8 +23,8 @@
     #include "../backends/TFLiteProcessor.h"
 #endif
 
-#define MIN_CAPACITY_INFERENCE_QUEUE 10000
-#define MAX_NUM_INSTANCES 1000
+#define CAPACITY_WORKER_QUEUE 1024
+#define MAX_NUM_WORKERS 256
 
 namespace anira {
 
@@ -34,10 +35,16 @@ public:
     static std::shared_ptr<Context> get_instance(const ContextConfig& context_config);
     static std::shared_ptr<SessionElement> create_session(PrePostProcessor& pp_processor, InferenceConfig& inference_config, BackendBase* custom_processor);
     static void release_session(std::shared_ptr<SessionElement> session);
+    // Builds and prepares a processor for the model of the backend that is not shared with other sessions, nullptr for the custom backend
+    static std::shared_ptr<BackendBase> create_processor(InferenceConfig& inference_config, InferenceBackend backend);
     static void release_instance();
     static void release_thread_pool();
 
-    void prepare(std::shared_ptr<SessionElement> session, HostAudioConfig new_config);
+    void prepare(std::shared_ptr<SessionElement> session, HostAudioConfig new_config, int latency);
+    // Builds new processors for the session after the tensor shapes of its config changed, the session is idle afterwards until it is prepared
+    void reset_processors(std::shared_ptr<SessionElement> session, InferenceConfig& previous_config);
+    // Runs num_runs inferences of the prepared session one after another on the thread pool, their times are recorded in the histograms of the session
+    void calibrate(std::shared_ptr<SessionElement> session, unsigned int num_runs);
 
     static int get_num_sessions();
 
@@ -47,6 +54,8 @@ public:
     static void exec_inference();
 
     static std::vector<std::shared_ptr<SessionElement>>& get_sessions();
+    // Time each inference thread spent on inferences since it was created
+    static std::vector<std::chrono::nanoseconds> get_worker_busy_times();
 
 private:
     inline static std::shared_ptr<Context> m_context = nullptr; 
@@ -54,11 +63,19 @@ private:
 
     static int get_available_session_id();
     static void new_num_threads(unsigned int new_num_threads);
+    static void resolve_thread_cores();
+    static std::vector<int> get_thread_cores(unsigned int thread_index);
 
     static bool pre_process(std::shared_ptr<SessionElement> session);
+    static bool submit_inference(std::shared_ptr<SessionElement> session);
+    static bool has_free_struct(std::shared_ptr<SessionElement> session);
     static void post_process(std::shared_ptr<SessionElement> session, std::shared_ptr<SessionElement::ThreadSafeStruct> next_buffer);
 
     static void start_thread_pool();
+    // Has to be called whenever the processors of a session change
+    static void update_shared_processors();
+    // Processors of all backends of the idle session, including those of its current model swaps
+    static std::vector<BackendBase*> get_session_processors(std::shared_ptr<SessionElement> session);
 
     inline static std::vector<std::shared_ptr<SessionElement>> m_sessions;
     inline static std::atomic<int> m_next_id{-1};
@@ -66,6 +83,9 @@ private:
     inline static bool m_thread_pool_should_exit = false;
 
     inline static std::vector<std::unique_ptr<InferenceThread>> m_thread_pool;
+    // Guards resizing the thread pool against readers on other threads, e.g. the telemetry. The real-time and inference threads never take it.
+    inline static std::mutex m_thread_pool_mutex;
+    inline static std::vector<int> m_thread_cores;
 
     template <typename T> static void set_processor(std::shared_ptr<SessionElement> session, InferenceConfig& inference_config, std::vector<std::shared_ptr<T>>& processors, InferenceBackend backend);
     template <typename T> static void release_processor(InferenceConfig& inference_config, std::vector<std::shared_ptr<T>>& processors, std::shared_ptr<T>& processor);
@@ -82,7 +102,7 @@ private:
 
     inline static std::atomic<bool> m_host_threads_active{false};
 
-    inline static moodycamel::ConcurrentQueue<InferenceData> m_next_inference = moodycamel::ConcurrentQueue<InferenceData>(MIN_CAPACITY_INFERENCE_QUEUE, 0, MAX_NUM_INSTANCES);
+    inline static WorkerQueues m_next_inference{MAX_NUM_WORKERS, CAPACITY_WORKER_QUEUE};
 };
 
 } // namespace anira
@@ -0,0 +1,46 @@
+#ifndef ANIRA_DEADLINEQUEUE_H
+#define ANIRA_DEADLINEQUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "SessionElement.h"
+#include "../utils/FreeList.h"
+
+namespace anira {
+
+// Hands out the pending inferences earliest deadline first.
+// The inferences are kept in a preallocated array of slots without any lock, so the real-time threads can push into it and every inference thread can take from it. A FreeList hands out the empty slots and a second bitset marks the filled ones, which the consumers scan for the earliest deadline.
+class ANIRA_API DeadlineQueue {
+public:
+    DeadlineQueue(size_t capacity);
+
+    // Returns false when all slots are taken
+    bool try_push(InferenceData inference_data);
+    bool try_dequeue(InferenceData& inference_data);
+
+    // Removes all pending inferences of the session, must not be called from a real-time thread
+    void remove_session(std::shared_ptr<SessionElement> session);
+
+    size_t size_approx() const;
+    size_t get_capacity() const;
+
+private:
+    static constexpr size_t BITS_PER_WORD = 64;
+
+    struct Slot {
+        InferenceData m_inference_data;
+        // Read by the consumers that compare the deadlines before they own the slot
+        std::atomic<int64_t> m_deadline{0};
+    };
+
+    std::vector<Slot> m_slots;
+    FreeList m_free_slots;
+    std::vector<std::atomic<uint64_t>> m_filled_slots;
+    std::atomic<size_t> m_size{0};
+};
+
+} // namespace anira
+
+#endif //ANIRA_DEADLINEQUEUE_H
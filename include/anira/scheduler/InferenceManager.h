@@ -1,17 +1,41 @@
 #ifndef ANIRA_INFERENCEMANAGER_H
 #define ANIRA_INFERENCEMANAGER_H
 
+#include <array>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
 #include "InferenceThread.h"
 #include "../ContextConfig.h"
 #include "Context.h"
 #include "../utils/HostAudioConfig.h"
 #include "../InferenceConfig.h"
 #include "../PrePostProcessor.h"
+#include "../utils/InferenceStats.h"
+#include "../utils/Resampler.h"
 
 namespace anira {
     
 class ANIRA_API InferenceManager {
 public:
+    static constexpr std::chrono::milliseconds LATENCY_MONITOR_INTERVAL{1000};
+    // The latency monitor skips windows with fewer inferences, their percentiles are not meaningful
+    static constexpr size_t LATENCY_MONITOR_MIN_INFERENCES = 100;
+    // How often the background thread of a model swap checks whether the previous model is still in use
+    static constexpr std::chrono::milliseconds MODEL_SWAP_POLL_INTERVAL{1};
+    // Timed inferences per candidate of InferenceConfig::m_chunk_sizes, after one untimed inference
+    static constexpr unsigned int CHUNK_SIZE_BENCHMARK_RUNS = 10;
+
+    // Chunk size selected for a host config and backend, so that a later prepare with the same host config does not benchmark again
+    struct ChunkSizeSelection {
+        HostAudioConfig m_spec;
+        InferenceBackend m_backend;
+        size_t m_chunk_size;
+        float m_inference_time;
+    };
+
     InferenceManager() = delete;
     InferenceManager(PrePostProcessor& pp_processor, InferenceConfig& inference_config, BackendBase* custom_processor, const ContextConfig& context_config);
     ~InferenceManager();
@@ -19,10 +43,16 @@ public:
     void prepare(HostAudioConfig config);
     void process(const float* const* input_data, float* const* output_data, size_t num_samples);
 
+    // Takes effect with the next prepare
+    void set_non_realtime(bool non_realtime);
+    bool is_non_realtime() const;
+
     void set_backend(InferenceBackend new_inference_backend);
     InferenceBackend get_backend() const;
 
     int get_latency() const;
+    // Samples per channel and inference of the session, which is the selected candidate of InferenceConfig::m_chunk_sizes after prepare
+    size_t get_chunk_size() const;
 
     // Required for unit test
     size_t get_num_received_samples() const;
@@ -31,14 +61,48 @@ public:
     int get_missing_blocks() const;
     int get_session_id() const;
 
+    InferenceStats get_stats();
+    void reset_stats();
+
+    // Starts a monitor with the next prepare, that calls back from a background thread when the measured inference times require another latency
+    void set_latency_change_callback(std::function<void(int requested_latency)> callback);
+
+    // Load the model, or take the prepared custom processor, and swap it in from a background thread while the audio keeps running
+    bool load_model_async(const ModelData& model_data, size_t crossfade_samples);
+    bool set_custom_processor_async(BackendBase& custom_processor, size_t crossfade_samples);
+    bool is_swapping_model() const;
+
     void exec_inference() const;
 
 private:
+    void process_non_realtime(const float* const* input_data, float* const* output_data, size_t num_samples);
     void process_input(const float* const* input_data, size_t num_samples);
     void process_output(float* const* output_data, size_t num_samples);
     void clear_data(float* const* data, size_t input_samples, size_t num_channels);
-    int calculate_latency();
+    void prepare_session();
+    void prepare_resamplers();
+    void prepare_non_realtime();
+    void select_chunk_size();
+    // Inference time in ms for the chunk size, negative if the processor could not be built
+    float benchmark_chunk_size(size_t chunk_size, InferenceBackend backend);
+    // Resizes the tensors of the session to the chunk size and rebuilds its processors if it changed
+    void apply_chunk_size(size_t chunk_size, float inference_time);
+    int calculate_latency(float inference_time);
+    // Latency in samples at the model sample rate, which the session pushes as zeros
+    int calculate_model_latency(float inference_time);
+    int calculate_inference_caused_latency(float inference_time);
+    float calculate_inference_time(const LatencyHistogram& histogram) const;
+    void start_latency_monitor();
+    void stop_latency_monitor();
+    void monitor_latency();
+    bool start_model_swap();
+    void swap_processor(std::shared_ptr<SessionElement::ModelSwap> model_swap, InferenceBackend backend, size_t crossfade_samples);
+    bool is_model_swap_finished(const SessionElement::ModelSwap& model_swap) const;
+    bool has_model_swap_users() const;
+    void release_previous_processors();
+    void stop_model_swap();
     int calculate_buffer_adaptation(int m_host_buffer_size, int model_output_size);
+    int calculate_resampled_buffer_adaptation(int model_output_size);
     int max_num_inferences(int m_host_buffer_size, int model_output_size);
     int greatest_common_divisor(int a, int b);
     int leat_common_multiple(int a, int b);
@@ -46,12 +110,52 @@ private:
 private:
     std::shared_ptr<Context> m_context;
 
-    InferenceConfig& m_inference_config;
     std::shared_ptr<SessionElement> m_session;
+    // The config of the session, which is a copy with the selected tensor shapes if the user config has chunk sizes
+    InferenceConfig& m_inference_config;
+    // Chunk size of the user config, which the session returns to if no candidate can be benchmarked
+    size_t m_configured_chunk_size;
+    std::vector<ChunkSizeSelection> m_chunk_size_selections;
     HostAudioConfig m_spec;
+    // The host config as seen by the session, the buffer size is the maximum number of model samples per host buffer
+    HostAudioConfig m_model_spec;
+
+    bool m_resampling = false;
+    Resampler m_input_resampler;
+    Resampler m_output_resampler;
+    AudioBufferF m_resampled_input;
+    AudioBufferF m_resampled_output;
 
+    bool m_non_realtime = false;
+    // Host buffers that are submitted ahead when rendering offline, as many as the ring buffers of the session hold
+    size_t m_num_non_realtime_buffers = 1;
+    std::vector<const float*> m_non_realtime_input;
+    std::vector<float*> m_non_realtime_output;
     size_t m_init_samples = 0;
+    size_t m_model_latency = 0;
+    // Inference time in ms the latency is based on, either m_max_inference_time or the calibrated time
+    float m_inference_time = 0.f;
     std::atomic<int> m_inference_counter {0};
+    std::atomic<size_t> m_num_missed_blocks {0};
+    std::atomic<size_t> m_num_caught_up_blocks {0};
+
+    // Busy times of the inference threads at the previous get_stats call, to calculate the utilisation in between
+    std::chrono::steady_clock::time_point m_last_stats_time = std::chrono::steady_clock::now();
+    std::vector<std::chrono::nanoseconds> m_last_busy_times;
+
+    std::function<void(int)> m_latency_change_callback;
+    std::thread m_monitor_thread;
+    std::mutex m_monitor_mutex;
+    std::condition_variable m_monitor_condition;
+    bool m_monitor_should_exit = false;
+
+    std::thread m_model_swap_thread;
+    std::atomic<bool> m_swapping_model{false};
+    std::atomic<bool> m_model_swap_should_exit{false};
+    // Latest swap of each backend, the session only holds raw pointers to them
+    std::array<std::shared_ptr<SessionElement::ModelSwap>, SessionElement::NUM_BACKENDS> m_model_swaps;
+    // Replaced swaps, which inferences may still have acquired. They lose their processors once unused and are destroyed when the session is idle.
+    std::vector<std::shared_ptr<SessionElement::ModelSwap>> m_retired_model_swaps;
 };
 
 } // namespace anira
@@ -1,14 +1,16 @@
 #ifndef ANIRA_INFERENCETHREAD_H
 #define ANIRA_INFERENCETHREAD_H
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <vector>
 
 #include "../system/HighPriorityThread.h"
+#include "../system/RealtimeLogger.h"
 #include "../utils/AudioBuffer.h"
 #include "SessionElement.h"
-#include <concurrentqueue.h>
+#include "WorkerQueues.h"
 #ifdef __x86_64__
 #include <immintrin.h>
 #endif
@@ -17,21 +19,50 @@ namespace anira {
     
 class ANIRA_API InferenceThread : public HighPriorityThread {
 public:
-    InferenceThread(moodycamel::ConcurrentQueue<InferenceData>& next_inference);
+    InferenceThread(WorkerQueues& next_inference, size_t worker_index);
     ~InferenceThread() override;
 
     bool execute();
+    std::chrono::nanoseconds get_busy_time() const;
 
 private:
+    // Inferences collected by one call of execute. Kept per calling thread, since the host threads may call execute concurrently through Context::exec_inference.
+    struct Batch {
+        std::vector<InferenceData> m_inferences;
+        SessionElement::ModelSwap* m_swap = nullptr;
+        BackendBase* m_processor = nullptr;
+        std::vector<AudioBufferF*> m_inputs;
+        std::vector<AudioBufferF*> m_outputs;
+        std::vector<std::shared_ptr<SessionElement>> m_sessions;
+    };
+
     void run() override;
 
-    void do_inference(std::shared_ptr<SessionElement> session, std::shared_ptr<SessionElement::ThreadSafeStruct> thread_safe_struct);
-    void inference(std::shared_ptr<SessionElement> session, AudioBufferF& input, AudioBufferF& output);
-    void exponential_backoff(std::array<int, 2> iterations);
+    void process_inference_data(const InferenceData& inference_data);
+    void do_inference(const InferenceData& inference_data, bool wait_for_instance);
+    // Return false when all instances of the processor are busy, the waiting inference is resubmitted by the processor then. Without a waiting inference, they wait for a free instance.
+    bool inference(std::shared_ptr<SessionElement> session, AudioBufferF& input, AudioBufferF& output, unsigned long time_stamp, const InferenceData* waiting_inference);
+    bool swap_inference(std::shared_ptr<SessionElement> session, SessionElement::ModelSwap& model_swap, AudioBufferF& input, AudioBufferF& output, unsigned long time_stamp, const InferenceData* waiting_inference);
+    bool run_processor(BackendBase& processor, AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session, const InferenceData* waiting_inference);
+    void crossfade(std::shared_ptr<SessionElement> session, SessionElement::ModelSwap& model_swap, AudioBufferF& input, AudioBufferF& output, size_t crossfade_index);
+    void pre_process(std::shared_ptr<SessionElement> session, std::shared_ptr<SessionElement::ThreadSafeStruct> thread_safe_struct);
+    void post_process(std::shared_ptr<SessionElement> session, std::shared_ptr<SessionElement::ThreadSafeStruct> thread_safe_struct);
+    bool is_state_turn(const InferenceData& inference_data);
+    void finish_state_turn(const InferenceData& inference_data);
+    bool spin(std::array<int, 2> iterations);
+    void park();
+    void wake_up() override;
+
+    void collect_batch(const InferenceData& inference_data, Batch& batch);
+    void do_batched_inference(Batch& batch);
+    BackendBase* get_processor(std::shared_ptr<SessionElement> session, SessionElement::ModelSwap* model_swap);
 
 private:
-    moodycamel::ConcurrentQueue<InferenceData>& m_next_inference;
-    InferenceData m_inference_data;
+    WorkerQueues& m_next_inference;
+    size_t m_worker_index;
+
+    // Accumulated by execute, which the host threads may call concurrently through Context::exec_inference
+    std::atomic<int64_t> m_busy_time_ns{0};
  };
 
 } // namespace anira
@@ -4,13 +4,20 @@
 #ifdef USE_CONTROLLED_BLOCKING
     #include <semaphore>
 #endif
+#include <array>
 #include <atomic>
+#include <climits>
+#include <memory>
 #include <queue>
+#include <mutex>
+#include <chrono>
 
 #include "../utils/AudioBuffer.h"
 #include "../utils/RingBuffer.h"
 #include "../utils/InferenceBackend.h"
 #include "../utils/HostAudioConfig.h"
+#include "../utils/LatencyHistogram.h"
+#include "../system/EventCount.h"
 #include "../backends/BackendBase.h"
 #include "../PrePostProcessor.h"
 #include "../InferenceConfig.h"
@@ -44,12 +51,28 @@ public:
     SessionElement(int newSessionID, PrePostProcessor& pp_processor, InferenceConfig& inference_config);
 
     void clear();
-    void prepare(HostAudioConfig new_config);
+    void prepare(HostAudioConfig new_config, int latency);
 
     template <typename T> void set_processor(std::shared_ptr<T>& processor);
+    // Processor of the config for the backend, nullptr if the config has no model for it
+    BackendBase* get_processor(InferenceBackend backend);
+    // Number of inferences from the reference to the time stamp, negative for earlier time stamps
+    long get_time_stamp_distance(unsigned long time_stamp, unsigned long reference) const;
+
+    // The backends get the non-audio tensors through these, they are the recurrent state of the session for the state indices and the tensors of the PrePostProcessor otherwise
+    void get_input_tensor(float* data, size_t i);
+    void set_output_tensor(const float* data, size_t i);
+    // Set on the calling thread while the previous processor of a crossfade runs, nullptr afterwards. The state tensors are then those in previous_states and the other outputs of the previous processor are dropped.
+    static void set_crossfade_states(std::vector<MemoryBlock<float>>* previous_states);
+
+    // A stateful session passes its state from one inference to the next, so its inferences run one after another in the order of their time stamps
+    bool is_stateful() const;
+    bool is_state_turn(unsigned long time_stamp) const;
 
     RingBuffer m_send_buffer;
     RingBuffer m_receive_buffer;
+    // Samples behind the read position of the send buffer that the model input still needs, they must not be overwritten
+    size_t m_num_past_samples = 0;
 
     struct ThreadSafeStruct {
         ThreadSafeStruct(size_t num_input_samples, size_t num_output_samples, size_t num_input_channels, size_t num_output_channels);
@@ -59,29 +82,118 @@ public:
 #else
         std::atomic<bool> m_done{false};
 #endif
-        unsigned long m_time_stamp;
+        // Read by the InferenceManager to find out when a model swap completed
+        std::atomic<unsigned long> m_time_stamp{0};
+        // Set by the inference thread that offloads the pre-processing, so that a resubmitted inference is not pre-processed twice
+        bool m_pre_processed = false;
+        // Set while the inference waits for the state turn, the deadline and submit time are kept for its resubmission
+        std::atomic<bool> m_parked{false};
+        std::chrono::steady_clock::time_point m_parked_deadline;
+        std::chrono::steady_clock::time_point m_parked_submit_time;
         AudioBufferF m_processed_model_input = AudioBufferF();
         AudioBufferF m_raw_model_output = AudioBufferF();
     };
 
     std::vector<std::shared_ptr<ThreadSafeStruct>> m_inference_queue;
 
+    // Parks the inference of the struct until the inference before it finished, instead of requeueing it. Returns false if the turn came meanwhile, the caller runs the inference then.
+    bool park_for_state_turn(const std::shared_ptr<ThreadSafeStruct>& thread_safe_struct, std::chrono::steady_clock::time_point deadline, std::chrono::steady_clock::time_point submit_time);
+    // Passes the turn on and returns the struct of the parked inference that has the next turn, if any. The caller submits it again.
+    std::shared_ptr<ThreadSafeStruct> finish_state_turn();
+
     std::atomic<InferenceBackend> m_currentBackend {CUSTOM};
+    // Set by prepare, when rendering offline no samples are dropped and the caller waits for the inferences instead
+    bool m_non_realtime = false;
+    // Called by the inference threads once the result of an inference was handed over. When rendering offline, this wakes the caller of wait_for_inference.
+    void notify_inference_finished();
+    // Blocks until the number of finished inferences differs from num_finished, which the caller loaded from m_num_finished_inferences before it checked for results
+    void wait_for_inference(size_t num_finished);
+    std::atomic<size_t> m_num_finished_inferences{0};
     unsigned long m_current_queue = 0;
     std::vector<unsigned long> m_time_stamps;
 
+    // Only used when the pre- and post-processing is offloaded to the inference threads
+    size_t m_num_pending_samples = 0; // samples pushed by the real-time thread that are not yet claimed by an inference
+    unsigned long m_next_pre_process_stamp = 0;
+    unsigned long m_next_post_process_stamp = 0;
+    std::vector<std::atomic<ThreadSafeStruct*>> m_finished_inferences; // indexed by time stamp modulo the number of structs
+    std::mutex m_pre_process_mutex;
+    std::mutex m_post_process_mutex;
+
     const int m_session_id;
 
     std::atomic<bool> m_initialized{false};
+    EventCount m_inference_finished;
     std::atomic<int> m_active_inferences{0};
 
     PrePostProcessor& m_pp_processor;
+    // Copy of the config of a session with InferenceConfig::m_chunk_sizes, which gets the selected tensor shapes. The config of the user keeps its shapes. Declared before m_inference_config, which refers to it then.
+    std::unique_ptr<InferenceConfig> m_chunk_config;
     InferenceConfig& m_inference_config;
 
     BackendBase m_default_processor;
     BackendBase* m_custom_processor;
 
     HostAudioConfig m_host_config;
+    // Time between the submission of an inference and the moment its result is needed, derived from the inference caused latency
+    std::chrono::nanoseconds m_inference_budget{0};
+    // Inference time the latency is based on, which is the configured, calibrated or benchmarked one
+    std::chrono::nanoseconds m_expected_inference_time{0};
+
+    // Recorded by the inference threads for InferenceHandler::get_stats
+    LatencyHistogram m_queue_wait_time;
+    LatencyHistogram m_inference_time;
+    // Same as m_inference_time for the latency monitor. The inference threads record into the histogram of m_monitored_index, while the monitor evaluates the other one.
+    std::array<LatencyHistogram, 2> m_monitored_inference_time;
+    std::atomic<size_t> m_monitored_index{0};
+    // Called by the inference threads after every inference
+    void record_inference_time(std::chrono::nanoseconds inference_time);
+    // Resets the histogram that nobody recorded into since the last call and lets the inference threads record into it. Returns the other one, which holds the inference times since the last call. Must not be called concurrently.
+    const LatencyHistogram& swap_monitored_inference_time();
+    // While prepare calibrates, inferences skip the offloaded pre- and post-processing, so that they do not touch the ring buffers
+    std::atomic<bool> m_calibrating{false};
+
+    // One block per pair of m_inference_config.m_state_indices, zeroed by prepare
+    std::vector<MemoryBlock<float>> m_states;
+    // Time stamp of the inference that may use the state next
+    std::atomic<unsigned long> m_next_state_stamp{0};
+
+    // Replaces the processor of a backend while the session keeps running, see InferenceHandler::load_model_async
+    struct ModelSwap {
+        static constexpr unsigned long NO_TIME_STAMP = ULONG_MAX;
+
+        // Config of a loaded model, which its processor refers to. Declared first, so that it is destroyed after the processor.
+        std::unique_ptr<InferenceConfig> m_inference_config;
+        std::shared_ptr<BackendBase> m_processor;
+        // Processes the inferences before the swap and is faded out during the crossfade. Released by the InferenceManager once no inference uses it anymore.
+        std::shared_ptr<BackendBase> m_previous_processor;
+        size_t m_num_crossfade_inferences = 0;
+        // Recurrent state of the previous processor during the crossfade, while the new processor starts from a cleared state in m_states. Sized by the InferenceManager and dropped with the previous processor.
+        std::vector<MemoryBlock<float>> m_previous_states;
+        // Set by the first inference with the new processor, which is the only one holding the state turn
+        bool m_states_split = false;
+
+        // Time stamp of the first inference with the new processor, set by the thread that stamps the inferences when it first sees the swap
+        std::atomic<unsigned long> m_time_stamp{NO_TIME_STAMP};
+        std::atomic<size_t> m_num_finished_crossfades{0};
+        // Set once no inference uses the previous processor anymore
+        std::atomic<bool> m_complete{false};
+        // Inference threads that are using the processors of the swap, see acquire_model_swap
+        std::atomic<int> m_num_users{0};
+    };
+    // Returns the swap of the backend, or nullptr, and counts the caller as its user until release_model_swap. The processors of the swap stay alive meanwhile.
+    ModelSwap* acquire_model_swap(InferenceBackend backend);
+    void release_model_swap(ModelSwap* model_swap);
+    // Called with the time stamp of every new inference, which is the first one of the swaps that were published since the last call
+    void start_model_swaps(unsigned long time_stamp);
+    // Called by the first inference with the new processor of the swap. The previous processor continues with a copy of the state, the new one starts from a cleared state.
+    void split_states(ModelSwap& model_swap);
+
+    static constexpr size_t NUM_BACKENDS = (size_t) CUSTOM + 1;
+    // Published by the InferenceManager, which owns the swaps and keeps replaced ones until the session is idle. A completed swap stays in place until the next one.
+    std::array<std::atomic<ModelSwap*>, NUM_BACKENDS> m_model_swaps{};
+    // Set by the Context if another session uses the same processor for the backend. Only then it is worth waiting for the inferences of other sessions to batch them.
+    std::array<std::atomic<bool>, NUM_BACKENDS> m_shares_processor{};
 
 #ifdef USE_LIBTORCH
     std::shared_ptr<LibtorchProcessor> m_libtorch_processor = nullptr;
@@ -97,6 +209,8 @@ public:
 struct InferenceData {
     std::shared_ptr<SessionElement> m_session;
     std::shared_ptr<SessionElement::ThreadSafeStruct> m_thread_safe_struct;
+    std::chrono::steady_clock::time_point m_deadline;
+    std::chrono::steady_clock::time_point m_submit_time;
 };
 
 } // namespace anira
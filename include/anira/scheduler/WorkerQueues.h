@@ -0,0 +1,67 @@
+#ifndef ANIRA_WORKERQUEUES_H
+#define ANIRA_WORKERQUEUES_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "DeadlineQueue.h"
+#include "SessionElement.h"
+#include "../system/CacheLine.h"
+#include "../system/EventCount.h"
+
+namespace anira {
+
+// One DeadlineQueue and one EventCount per inference thread. Every session has a home worker, so that its inferences stay on the same core and the weights of the model remain in its cache.
+// The producers push into the queue of the home worker and wake only that worker. The other workers steal from it when the home worker is busy with another inference or did not take the inference within STEAL_GRACE_PERIOD.
+class ANIRA_API WorkerQueues {
+public:
+    // The queues are created by set_num_workers, each with queue_capacity slots
+    WorkerQueues(size_t max_num_workers, size_t queue_capacity);
+
+    // The inference thread parks on the event count of its own queue
+    EventCount& get_event_count(size_t worker_index);
+    void notify_all();
+
+    // Creates the missing queues and distributes the sessions over the first num_workers queues
+    void set_num_workers(size_t num_workers);
+
+    bool try_enqueue(const InferenceData& inference_data);
+    // Takes from the queue of the worker first and steals from the other queues otherwise
+    bool try_dequeue(size_t worker_index, InferenceData& inference_data);
+    // Whether try_dequeue would find an inference for the worker, checked before it parks
+    bool has_work(size_t worker_index) const;
+
+    void remove_session(std::shared_ptr<SessionElement> session);
+
+    size_t size_approx() const;
+
+    static constexpr std::chrono::microseconds STEAL_GRACE_PERIOD{100};
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Worker {
+        Worker(size_t queue_capacity);
+
+        DeadlineQueue m_queue;
+        EventCount m_event_count;
+        // Set while the worker processes an inference, its queue can be stolen from meanwhile
+        std::atomic<bool> m_busy{false};
+        // Submit time of the first inference that was pushed since the worker last looked at its queue, zero if there is none
+        std::atomic<int64_t> m_pending_since{0};
+    };
+
+    size_t get_home_worker(const std::shared_ptr<SessionElement>& session) const;
+    bool may_steal(size_t victim_index, std::chrono::steady_clock::time_point& now) const;
+    void wake_up(size_t worker_index);
+
+    // The queues are never removed, so that the inferences left in the queue of a stopped worker are still stolen by the others
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<size_t> m_num_queues{0};
+    std::atomic<size_t> m_num_workers{1};
+    size_t m_queue_capacity;
+};
+
+} // namespace anira
+
+#endif //ANIRA_WORKERQUEUES_H
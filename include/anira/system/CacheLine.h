@@ -0,0 +1,17 @@
+#ifndef ANIRA_SYSTEM_CACHELINE_H
+#define ANIRA_SYSTEM_CACHELINE_H
+
+#include <cstddef>
+
+namespace anira {
+
+// Used to pad data that is written by different threads onto separate cache lines and thereby avoid false sharing
+#if defined(__APPLE__) && defined(__aarch64__)
+inline constexpr size_t CACHE_LINE_SIZE = 128;
+#else
+inline constexpr size_t CACHE_LINE_SIZE = 64;
+#endif
+
+} // namespace anira
+
+#endif // ANIRA_SYSTEM_CACHELINE_H
@@ -0,0 +1,35 @@
+#ifndef ANIRA_SYSTEM_CPUAFFINITY_H
+#define ANIRA_SYSTEM_CPUAFFINITY_H
+
+#if WIN32
+    #include <windows.h>
+#elif __linux__
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+#include "AniraWinExports.h"
+
+namespace anira {
+
+// Helpers to pin threads to cores. Pinning is supported on linux and windows, NUMA lookups only on linux. On macOS threads cannot be pinned, so all functions fall back to not pinning.
+class ANIRA_API CpuAffinity {
+public:
+    // Parses the linux cpulist format, e.g. "0-3,8,10-11"
+    static std::vector<int> parse_cpu_list(const std::string& cpu_list);
+
+    static std::vector<int> get_online_cores();
+    static std::vector<int> get_numa_node_cores(int numa_node);
+    // The cores the calling thread is pinned to, empty if it may run on all cores or the affinity cannot be queried. Called from the audio thread, the result can be passed to ContextConfig::m_excluded_cores.
+    static std::vector<int> get_caller_cores();
+
+    static bool set_thread_affinity(std::thread::native_handle_type thread_native_handle, const std::vector<int>& cores);
+};
+
+} // namespace anira
+
+#endif // ANIRA_SYSTEM_CPUAFFINITY_H
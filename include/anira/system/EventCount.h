@@ -0,0 +1,35 @@
+#ifndef ANIRA_SYSTEM_EVENTCOUNT_H
+#define ANIRA_SYSTEM_EVENTCOUNT_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "AniraWinExports.h"
+
+namespace anira {
+
+// Lets threads sleep until a condition they check themselves becomes true, without a mutex on the notifying side. It is built on a futex on linux, on WaitOnAddress on windows and on C++20 atomic wait/notify elsewhere.
+// A waiting thread calls prepare_wait, checks its condition again and then either calls cancel_wait or wait with the returned key. A notification between prepare_wait and wait is never lost, because wait returns immediately when the key is outdated.
+class ANIRA_API EventCount {
+public:
+    uint32_t prepare_wait();
+    void cancel_wait();
+    void wait(uint32_t key);
+    // Like wait, but returns false if the deadline passed without a notification. Where only C++20 atomic wait is available, which has no timeout, it sleeps in steps of 50 us until it is notified or the deadline passes.
+    bool wait_until(uint32_t key, std::chrono::steady_clock::time_point deadline);
+
+    // Cheap when nobody waits, so it can be called from the real-time thread after every enqueue. Returns whether a thread was waiting.
+    bool notify_one();
+    void notify_all();
+
+private:
+    void wake(bool all);
+
+    std::atomic<uint32_t> m_epoch{0};
+    std::atomic<uint32_t> m_num_waiters{0};
+};
+
+} // namespace anira
+
+#endif // ANIRA_SYSTEM_EVENTCOUNT_H
@@ -11,9 +11,11 @@
     #include <sys/qos.h>
 #endif
 #include <thread>
+#include <vector>
 #include <iostream>
 
 #include "AniraWinExports.h"
+#include "CpuAffinity.h"
 
 namespace anira {
 
@@ -28,15 +30,21 @@ public:
     virtual void run() = 0;
 
     static void elevate_priority(std::thread::native_handle_type thread_native_handle, bool is_main_process = false);
+    // Restricts the thread to the given cores, an empty list lets it run on all cores. Applied on start if the thread is not running yet.
+    void set_cpu_affinity(const std::vector<int>& cores);
     bool should_exit();
     bool is_running();
 
 protected:
+    // Called by stop after should_exit is set, a thread that blocks in run has to be woken up here
+    virtual void wake_up() {}
+
     std::atomic<bool> m_is_running;
     
 private:
     std::thread m_thread;
     std::atomic<bool> m_should_exit;
+    std::vector<int> m_cpu_affinity;
 };
 
 } // namespace anira
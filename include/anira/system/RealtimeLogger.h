@@ -0,0 +1,35 @@
+#ifndef ANIRA_SYSTEM_REALTIMELOGGER_H
+#define ANIRA_SYSTEM_REALTIMELOGGER_H
+
+#include <chrono>
+#include <cstddef>
+
+#include "AniraWinExports.h"
+
+namespace anira {
+
+enum class LogLevel {
+    Info,
+    Warning,
+    Error
+};
+
+// Logging for the real-time threads. log only copies a small record into a fixed ring and never blocks, allocates or locks. A background thread prints the records.
+// Repeated messages of the same session are printed at most once per RATE_LIMIT_INTERVAL, followed by the number of suppressed repetitions. When the ring is full, records are dropped and counted.
+class ANIRA_API RealtimeLogger {
+public:
+    static constexpr size_t CAPACITY = 1024;
+    static constexpr std::chrono::milliseconds RATE_LIMIT_INTERVAL{1000};
+
+    // Only the pointer of the message is stored, so it has to be a string literal. The output reads "[LEVEL] message in session: session_id!" or "[LEVEL] message!" for a negative session id.
+    static void log(LogLevel level, const char* message, int session_id = -1);
+
+    static void start();
+    static void stop();
+    // Prints all pending records and suppressed repetitions right away
+    static void flush();
+};
+
+} // namespace anira
+
+#endif // ANIRA_SYSTEM_REALTIMELOGGER_H
@@ -0,0 +1,46 @@
+#ifndef ANIRA_ALLOCATOR_H
+#define ANIRA_ALLOCATOR_H
+
+#include <cstddef>
+#include "../system/CacheLine.h"
+#include "../system/AniraWinExports.h"
+
+namespace anira {
+
+// Process wide options for the allocators below, they apply to all allocations made after they are set
+class ANIRA_API MemoryOptions {
+public:
+    // Locked blocks below this size, including their header, share locked chunks of LOCKED_ARENA_CHUNK_SIZE bytes instead of being locked on their own pages
+    static constexpr size_t LOCKED_ARENA_THRESHOLD = 16 * 1024;
+    static constexpr size_t LOCKED_ARENA_CHUNK_SIZE = 256 * 1024;
+
+    // Locks new allocations into RAM, so that the real-time threads never page-fault on them. Larger locked blocks are rounded up to whole pages, since pages are the unit of locking.
+    static void set_lock_memory(bool lock_memory);
+    static bool get_lock_memory();
+    // Backs large allocations of the HugePageAllocator with huge pages
+    static void set_use_huge_pages(bool use_huge_pages);
+    static bool get_use_huge_pages();
+};
+
+// Allocation policies for MemoryBlock. Memory is always aligned to the cache line size, which also satisfies the alignment the SIMD kernels of the backends prefer.
+// Every block is preceded by a header of one cache line that records how it was allocated, so the options may change while blocks are alive.
+// Blocks from different policies must never be swapped, which the MemoryBlock template parameter enforces.
+struct ANIRA_API AlignedAllocator {
+    static constexpr size_t ALIGNMENT = CACHE_LINE_SIZE;
+
+    static void* allocate(size_t num_bytes);
+    static void deallocate(void* data, size_t num_bytes);
+};
+
+// For the large session buffers. With huge pages enabled, blocks of at least one huge page are mapped with MAP_HUGETLB or, if no huge pages are reserved, advised to use transparent huge pages. Smaller blocks and other platforms fall back to aligned allocation.
+struct ANIRA_API HugePageAllocator {
+    static constexpr size_t ALIGNMENT = CACHE_LINE_SIZE;
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    static void* allocate(size_t num_bytes);
+    static void deallocate(void* data, size_t num_bytes);
+};
+
+} // namespace anira
+
+#endif // ANIRA_ALLOCATOR_H
@@ -8,7 +8,7 @@
 
 namespace anira {
 
-template <typename T>
+template <typename T, typename Allocator = AlignedAllocator>
 class ANIRA_API AudioBuffer
 {
 public:
@@ -32,7 +32,7 @@ public:
 
     // Move constructor takes an rvalue reference to another buffer and moves the data from the other buffer to the new buffer, then the other buffer is left in a valid but null state
     // marked as noexcept since it is not supposed to throw exceptions and if it does, the program will terminate, this is because the move constructor could corrupt the data in the other buffer if it fails
-    AudioBuffer(AudioBuffer&& other) noexcept : m_num_channels(other.m_num_channels), m_size(other.m_size), m_data(std::move(other.m_data)), m_channels(other.m_channels) {
+    AudioBuffer(AudioBuffer&& other) noexcept : m_num_channels(other.m_num_channels), m_size(other.m_size), m_channels(other.m_channels), m_data(std::move(other.m_data)) {
         other.m_num_channels = 0;
         other.m_size = 0;
         other.m_channels = nullptr;
@@ -120,11 +120,25 @@ public:
     }
 
     // Returns a pointer to the raw data in the buffer as a contiguous block of memory with first the samples of the first channel, then the samples of the second channel and so on
+    // For a view, the external memory it points to
     T* data() {
-        return m_data.data();
+        return is_view() ? m_channels[0] : m_data.data();
     }
 
-    MemoryBlock<T>& get_memory_block() {
+    // Lets a single channel buffer point to external memory instead of its own data, e.g. to a window of a mirrored RingBuffer. The view lasts until reset_channel_ptr is called.
+    void set_view(T* data) {
+        if (m_num_channels != 1) {
+            std::cerr << "Only single channel buffers can be views!" << std::endl;
+            return;
+        }
+        m_channels[0] = data;
+    }
+
+    bool is_view() const {
+        return m_num_channels == 1 && m_channels[0] != m_data.data();
+    }
+
+    MemoryBlock<T, Allocator>& get_memory_block() {
         return m_data;
     }
 
@@ -141,7 +155,7 @@ public:
         }
     }
 
-    void swap_data(MemoryBlock<T>& other) {
+    void swap_data(MemoryBlock<T, Allocator>& other) {
         if (other.size() == m_num_channels * m_size) {
             m_data.swap_data(other);
             reset_channel_ptr();
@@ -198,7 +212,7 @@ private:
     size_t m_size = 0;
     T** m_channels = nullptr;
 
-    MemoryBlock<T> m_data;
+    MemoryBlock<T, Allocator> m_data;
 };
 
 
@@ -0,0 +1,38 @@
+#ifndef ANIRA_FREELIST_H
+#define ANIRA_FREELIST_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../system/AniraWinExports.h"
+
+namespace anira {
+
+// Lock-free set of free indices, e.g. of the instances of a backend processor, stored as one bit per index.
+// Acquiring takes the lowest free index with a single compare and swap per 64 indices, so the first instances are used most and stay warm in the cache.
+class ANIRA_API FreeList {
+public:
+    FreeList(size_t size = 0);
+
+    // Marks all indices as free, must not be called while the list is in use
+    void resize(size_t size);
+    size_t get_size() const;
+
+    bool try_acquire(size_t& index);
+    // Yields until an index is free
+    size_t acquire();
+    // Yields until the given index is free, e.g. to update the data of one instance while the others keep processing
+    void acquire_index(size_t index);
+    void release(size_t index);
+
+private:
+    static constexpr size_t BITS_PER_WORD = 64;
+
+    std::vector<std::atomic<uint64_t>> m_words;
+    size_t m_size = 0;
+};
+
+} // namespace anira
+
+#endif // ANIRA_FREELIST_H
@@ -0,0 +1,30 @@
+#ifndef ANIRA_INFERENCESTATS_H
+#define ANIRA_INFERENCESTATS_H
+
+#include <vector>
+#include "LatencyHistogram.h"
+
+namespace anira {
+
+// Snapshot of the telemetry of a session, see InferenceHandler::get_stats
+struct InferenceStats {
+    // From submitting an inference until an inference thread starts it
+    LatencyStatistics m_queue_wait_time;
+    // Execution time of the backend, for batched inferences the time of the whole batch
+    LatencyStatistics m_inference_time;
+
+    // Blocks that were returned as zeros, because the inference was not finished in time
+    size_t m_missed_blocks = 0;
+    // Blocks that were discarded to catch up after missed blocks
+    size_t m_caught_up_blocks = 0;
+
+    size_t m_free_inference_structs = 0;
+    size_t m_num_inference_structs = 0;
+
+    // Share of the time each inference thread was busy, since the previous call of get_stats
+    std::vector<float> m_worker_utilisation;
+};
+
+} // namespace anira
+
+#endif // ANIRA_INFERENCESTATS_H
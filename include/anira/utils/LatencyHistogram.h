@@ -0,0 +1,51 @@
+#ifndef ANIRA_LATENCYHISTOGRAM_H
+#define ANIRA_LATENCYHISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "../system/AniraWinExports.h"
+
+namespace anira {
+
+struct ANIRA_API LatencyStatistics {
+    size_t m_count = 0;
+    std::chrono::nanoseconds m_mean{0};
+    std::chrono::nanoseconds m_p50{0};
+    std::chrono::nanoseconds m_p90{0};
+    std::chrono::nanoseconds m_p99{0};
+    std::chrono::nanoseconds m_max{0};
+};
+
+// Histogram of durations with logarithmic buckets, each power of two is split into SUB_BUCKETS linear buckets like in an HDR histogram. Percentiles are therefore accurate to 1 / SUB_BUCKETS of the value.
+// Recording is wait-free and can happen from any thread. Reading while recording gives a snapshot that may miss the latest values.
+class ANIRA_API LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr size_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    // Durations above 2^MAX_EXPONENT ns (about 18 minutes) are counted in the last bucket
+    static constexpr int MAX_EXPONENT = 40;
+    static constexpr size_t NUM_BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    void record(std::chrono::nanoseconds duration);
+    void reset();
+
+    size_t get_count() const;
+    // Upper bound of the bucket that holds the given percentile (0 to 100), zero if nothing was recorded
+    std::chrono::nanoseconds get_percentile(double percentile) const;
+    LatencyStatistics get_statistics() const;
+
+private:
+    static size_t get_bucket_index(uint64_t value);
+    static uint64_t get_bucket_upper_bound(size_t index);
+
+    std::array<std::atomic<uint64_t>, NUM_BUCKETS> m_buckets{};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sum{0};
+    std::atomic<uint64_t> m_max{0};
+};
+
+} // namespace anira
+
+#endif // ANIRA_LATENCYHISTOGRAM_H
@@ -2,59 +2,52 @@
 #define ANIRA_MEMORYBLOCK_H
 
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 #include <type_traits>
+#include "Allocator.h"
 
 namespace anira {
 
-template <typename T>
+// The Allocator is a policy with static allocate and deallocate functions, see Allocator.h
+template <typename T, typename Allocator = AlignedAllocator>
 class MemoryBlock {
 public:
     MemoryBlock(std::size_t size = 0) : m_size(size) {
-        void* data = malloc(sizeof(T) * m_size);
-        if (data != nullptr) {
-            m_data = (T*) data;
-        } else {
-            std::cerr << "Failed to allocate memory!" << std::endl;
-        }
+        m_data = (T*) Allocator::allocate(sizeof(T) * m_size);
     }
 
     ~MemoryBlock() noexcept {
-        free(m_data);
+        Allocator::deallocate(m_data, sizeof(T) * m_size);
     }
 
     MemoryBlock(const MemoryBlock& other) : m_size(other.m_size) {
-        void* data = malloc(sizeof(T) * m_size);
-        if (data != nullptr) {
-            m_data = (T*) data;
+        m_data = (T*) Allocator::allocate(sizeof(T) * m_size);
+        if (m_data != nullptr) {
             memcpy(m_data, other.m_data, sizeof(T) * m_size);
-        } else {
-            std::cerr << "Failed to allocate memory!" << std::endl;
         }
     }
 
     MemoryBlock& operator=(const MemoryBlock& other) {
         if (this != &other) {
-            free(m_data);
+            Allocator::deallocate(m_data, sizeof(T) * m_size);
             m_size = other.m_size;
-            void* data = malloc(sizeof(T) * m_size);
-            if (data != nullptr) {
-                m_data = (T*) data;
+            m_data = (T*) Allocator::allocate(sizeof(T) * m_size);
+            if (m_data != nullptr) {
                 memcpy(m_data, other.m_data, sizeof(T) * m_size);
-            } else {
-                std::cerr << "Failed to allocate memory!" << std::endl;
             }
         }
         return *this;
     }
 
-    MemoryBlock(MemoryBlock&& other) noexcept : m_size(other.m_size), m_data(other.m_data) {
+    MemoryBlock(MemoryBlock&& other) noexcept : m_data(other.m_data), m_size(other.m_size) {
         other.m_size = 0;
         other.m_data = nullptr;
     }
 
     MemoryBlock& operator=(MemoryBlock&& other) noexcept {
         if (this != &other) {
-            free(m_data);
+            Allocator::deallocate(m_data, sizeof(T) * m_size);
             m_size = other.m_size;
             m_data = other.m_data;
             other.m_size = 0;
@@ -75,25 +68,26 @@ public:
         return m_data;
     }
 
+    const T* data() const {
+        return m_data;
+    }
+
     size_t size() const {
         return m_size;
     }
 
+    // Keeps the data up to the smaller of both sizes, like realloc
     void resize(size_t size) {
-        m_size = size;
-        void* data;
-        if (m_size > 0) {
-            data = realloc(m_data, sizeof(T) * size);
-        } else {
-            free(m_data);
-            data = malloc(sizeof(T) * size);
+        T* data = (T*) Allocator::allocate(sizeof(T) * size);
+        if (data == nullptr && size > 0) {
+            return;
         }
-
-        if (data != nullptr) {
-            m_data = (T*) data;
-        } else {
-            std::cerr << "Failed to reallocate memory!" << std::endl;
+        if (m_data != nullptr && data != nullptr) {
+            memcpy(data, m_data, sizeof(T) * std::min(size, m_size));
         }
+        Allocator::deallocate(m_data, sizeof(T) * m_size);
+        m_data = data;
+        m_size = size;
     }
 
     void clear() {
@@ -114,6 +108,7 @@ public:
         }
     }
 
+    // The data has to be allocated by the same Allocator with the same size
     void swap_data(T*& data, size_t size) {
         if (m_size == size) {
             std::swap(m_data, data);
@@ -0,0 +1,41 @@
+#ifndef ANIRA_MIRROREDMEMORY_H
+#define ANIRA_MIRROREDMEMORY_H
+
+#include <cstddef>
+#include "../system/AniraWinExports.h"
+
+namespace anira {
+
+// Memory that is mapped twice back to back, so that data()[i] and data()[i + get_size()] are the same byte.
+// A ring buffer in this memory can access any range of up to get_size() bytes as one contiguous block, even across the wrap-around.
+// Only supported on Linux, where the mappings share a memfd.
+class ANIRA_API MirroredMemory {
+public:
+    MirroredMemory() = default;
+    ~MirroredMemory();
+
+    MirroredMemory(const MirroredMemory&) = delete;
+    MirroredMemory& operator=(const MirroredMemory&) = delete;
+    MirroredMemory(MirroredMemory&& other) noexcept;
+    MirroredMemory& operator=(MirroredMemory&& other) noexcept;
+
+    // Maps num_bytes rounded up to the page size twice, the memory is zeroed. Returns false if the platform does not support it or mapping failed.
+    bool allocate(size_t num_bytes);
+    void deallocate();
+
+    void* data() const;
+    // Size of one mapping in bytes
+    size_t get_size() const;
+
+    static bool is_supported();
+    static size_t get_page_size();
+
+private:
+    void* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_locked = false;
+};
+
+} // namespace anira
+
+#endif // ANIRA_MIRROREDMEMORY_H
@@ -0,0 +1,103 @@
+#ifndef ANIRA_MODELCACHE_H
+#define ANIRA_MODELCACHE_H
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "../InferenceConfig.h"
+#include "../system/AniraWinExports.h"
+
+namespace anira {
+
+// Process wide cache of loaded models, so that processors of different sessions and configs share the same weights.
+// The cache only holds weak references, a model is released as soon as no processor uses it anymore.
+class ANIRA_API ModelCache {
+public:
+    // Identifies the model of a backend by the size and SHA-256 digest of its bytes for binary models, or by path, modification time and size for model files, together with its tensor shapes
+    static std::string get_key(InferenceConfig& inference_config, InferenceBackend backend);
+
+    // Returns the model cached under the key, or loads and caches it. A model is never loaded twice, callers that ask for a model while it is loaded wait for it. Models with other keys load in parallel.
+    template <typename T>
+    static std::shared_ptr<T> get(const std::string& key, const std::function<std::shared_ptr<T>()>& load) {
+        std::promise<std::shared_ptr<T>> promise;
+        std::shared_future<std::shared_ptr<T>> loading;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            erase_expired<T>();
+            Entry<T>& entry = m_models<T>[key];
+            if (std::shared_ptr<T> model = entry.m_model.lock()) {
+                return model;
+            }
+            if (entry.m_loading.valid()) {
+                loading = entry.m_loading;
+            } else {
+                entry.m_loading = promise.get_future().share();
+            }
+        }
+        if (loading.valid()) {
+            return loading.get();
+        }
+
+        std::shared_ptr<T> model;
+        try {
+            model = load();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_models<T>[key].m_loading = {};
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Entry<T>& entry = m_models<T>[key];
+            entry.m_model = model;
+            entry.m_loading = {};
+        }
+        promise.set_value(model);
+        return model;
+    }
+
+    // Number of models of the type that are currently loaded
+    template <typename T>
+    static size_t get_num_models() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t num_models = 0;
+        for (auto& [key, entry] : m_models<T>) {
+            if (!entry.m_model.expired()) {
+                num_models++;
+            }
+        }
+        return num_models;
+    }
+
+private:
+    template <typename T>
+    struct Entry {
+        std::weak_ptr<T> m_model;
+        // Only valid while the model is loaded
+        std::shared_future<std::shared_ptr<T>> m_loading;
+    };
+
+    // Removes the entries of released models, has to be called under the lock
+    template <typename T>
+    static void erase_expired() {
+        for (auto it = m_models<T>.begin(); it != m_models<T>.end();) {
+            if (it->second.m_model.expired() && !it->second.m_loading.valid()) {
+                it = m_models<T>.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    inline static std::mutex m_mutex;
+    template <typename T>
+    inline static std::unordered_map<std::string, Entry<T>> m_models;
+};
+
+} // namespace anira
+
+#endif // ANIRA_MODELCACHE_H
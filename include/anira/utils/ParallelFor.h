@@ -0,0 +1,17 @@
+#ifndef ANIRA_PARALLELFOR_H
+#define ANIRA_PARALLELFOR_H
+
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include "../system/AniraWinExports.h"
+
+namespace anira {
+
+// Calls task for every index from 0 to count - 1 on up to max_threads threads, including the calling thread, and returns when all calls finished.
+// The threads only live for the call, so it is meant for setup work like building backend instances and not for the real-time path. The first exception thrown by a task is rethrown after all threads finished.
+ANIRA_API void parallel_for(size_t count, const std::function<void(size_t index)>& task, unsigned int max_threads = std::thread::hardware_concurrency());
+
+} // namespace anira
+
+#endif // ANIRA_PARALLELFOR_H
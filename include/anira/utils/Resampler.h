@@ -0,0 +1,66 @@
+#ifndef ANIRA_RESAMPLER_H
+#define ANIRA_RESAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AudioBuffer.h"
+#include "../system/AniraWinExports.h"
+
+namespace anira {
+
+// Streaming polyphase resampler for the rational ratio of two sample rates.
+// A windowed sinc lowpass at the upsampled rate is split into one filter per phase, so every output sample is a single vectorized dot product over the input history.
+class ANIRA_API Resampler {
+public:
+    // Zero crossings of the sinc on each side of its center, the filter spans about this many samples of the lower sample rate before and after its center
+    static constexpr size_t NUM_ZERO_CROSSINGS = 16;
+    // Cutoff of the lowpass as fraction of the lower Nyquist frequency
+    static constexpr double CUTOFF = 0.85;
+    // Upper limit for both factors of the ratio, e.g. 44.1 kHz to 48 kHz needs 160 / 147
+    static constexpr int64_t MAX_FACTOR = 1024;
+
+    // Allocates the filters and the history. Returns false if the ratio of the sample rates needs a factor above MAX_FACTOR.
+    bool prepare(double input_sample_rate, double output_sample_rate, size_t num_channels, size_t max_num_input_samples);
+    // Clears the history, so that the resampler starts from silence
+    void reset();
+
+    // Resamples the input of all channels and returns the number of output samples per channel. When max_num_output_samples limits the output, the input must not hold more samples than get_num_input_samples(max_num_output_samples).
+    size_t process(const float* const* input, size_t num_input_samples, float* const* output, size_t max_num_output_samples = SIZE_MAX);
+
+    // Number of output samples the next num_input_samples produce
+    size_t get_num_output_samples(size_t num_input_samples) const;
+    // Number of input samples that the next num_output_samples need
+    size_t get_num_input_samples(size_t num_output_samples) const;
+    // Upper bound of get_num_output_samples for the given number of input samples, in any state
+    size_t get_max_num_output_samples(size_t num_input_samples) const;
+    // Upper bound of get_num_input_samples for the given number of output samples, in any state
+    size_t get_max_num_input_samples(size_t num_output_samples) const;
+    // Group delay of the filter in input samples
+    double get_delay() const;
+
+    int64_t get_up_factor() const;
+    int64_t get_down_factor() const;
+
+    // Uses AVX and FMA if the CPU supports them, SSE on other x86 CPUs and NEON on ARM
+    static float dot_product(const float* a, const float* b, size_t size);
+
+private:
+    size_t process_block(const float* const* input, size_t input_offset, size_t num_input_samples, float* const* output, size_t output_offset, size_t max_num_output_samples);
+
+    int64_t m_up = 1;
+    int64_t m_down = 1;
+    size_t m_num_taps = 0;
+    size_t m_num_channels = 0;
+    size_t m_max_num_input_samples = 0;
+    // m_up filters of m_num_taps coefficients, each reversed so that it runs forwards over the history
+    std::vector<float> m_filters;
+    // Per channel the last m_num_taps input samples followed by the current input block
+    AudioBufferF m_buffer;
+    // Position of the next output sample at the upsampled rate, relative to the first sample of the next input block. It lies at most one input sample before it.
+    int64_t m_position = 0;
+};
+
+} // namespace anira
+
+#endif // ANIRA_RESAMPLER_H
@@ -3,26 +3,78 @@
 
 #include <vector>
 #include <cmath>
+#include <atomic>
 #include "AudioBuffer.h"
+#include "MirroredMemory.h"
+#include "../system/CacheLine.h"
 
 namespace anira {
 
-class ANIRA_API RingBuffer : public AudioBuffer<float>
+// The RingBuffer is wait-free for one producer and one consumer per channel. The producer calls the push methods, the consumer the pop, discard and tail methods. Both may query the available samples.
+// Since every channel is published on its own, a consumer on another thread must check get_available_samples for every channel it reads from (or use get_available_samples() for the minimum over all channels).
+// The buffers of a session can be large, so they may be backed by huge pages.
+// A mirrored buffer keeps every channel in MirroredMemory instead, so that any window of its samples is contiguous and can be read in place, see get_window.
+class ANIRA_API RingBuffer
 {
 public:
     RingBuffer();
 
-    void initialize_with_positions(size_t num_channels, size_t num_samples);
+    // A mirrored buffer rounds num_samples up to a multiple of the page size and of window_hop. Windows that advance by window_hop then start at the same get_capacity() / window_hop positions on every pass, so that data derived from them can be kept. If the platform does not support mirrored memory, the buffer is not mirrored.
+    void initialize_with_positions(size_t num_channels, size_t num_samples, bool mirrored = false, size_t window_hop = 1);
     void clear_with_positions();
     void push_sample(size_t channel, float sample);
     float pop_sample(size_t channel);
     float get_sample_from_tail(size_t channel, size_t offset);
     size_t get_available_samples(size_t channel);
+    size_t get_available_samples();
+    size_t get_free_samples(size_t channel);
+
+    // Block-wise variants of the per-sample methods above. Each call copies at most two contiguous segments (before and after the wrap-around).
+    void push_block(size_t channel, const float* data, size_t num_samples);
+    void push_zeros(size_t channel, size_t num_samples);
+    void pop_block(size_t channel, float* data, size_t num_samples);
+    void discard_block(size_t channel, size_t num_samples);
+    // Copies num_samples already popped samples, starting offset samples behind the read position, i.e. data[i] = get_sample_from_tail(channel, offset - i)
+    void peek_from_tail(size_t channel, float* data, size_t num_samples, size_t offset);
+
+    size_t get_num_channels() const;
+    // The samples of the channel in memory order, independent of the read and write positions. Valid for get_capacity() samples.
+    const float* get_read_pointer(size_t channel) const;
+    float* get_write_pointer(size_t channel);
+    // Sets all samples to zero, but keeps the positions
+    void clear();
+
+    bool is_mirrored() const;
+    // Number of samples per channel, the buffer holds at most one sample less
+    size_t get_capacity() const;
+    // The RingBuffer used to derive from AudioBuffer<float>, this is the only one of the inherited methods that is kept
+    [[deprecated("Use get_capacity instead")]] size_t get_num_samples() const;
+    // Points to the same num_samples samples that peek_from_tail copies. Every window of a mirrored buffer is contiguous, otherwise nullptr is returned if the window wraps around.
+    const float* get_window(size_t channel, size_t num_samples, size_t offset);
+    // Position in the channel of a pointer returned by get_window, or get_capacity() if it does not point into the channel
+    size_t get_window_position(size_t channel, const float* window) const;
+    // The window that starts at the position, independent of the read position. Only mirrored buffers have contiguous windows at every position.
+    const float* get_window_at_position(size_t channel, size_t position) const;
 
 private:
-    std::vector<size_t> m_read_pos, m_write_pos;
+    size_t advance(size_t position, size_t num_samples) const;
+    // Number of samples that can be copied in one block from the position on
+    size_t get_segment(size_t position, size_t num_samples) const;
+
+    // Every position lives on its own cache line, so that the producer and consumer do not invalidate each other's cache lines
+    struct alignas(CACHE_LINE_SIZE) Position {
+        std::atomic<size_t> m_value{0};
+    };
+
+    std::vector<Position> m_read_pos, m_write_pos;
+
+    // A mirrored buffer keeps its samples in m_mirrors, a regular one in m_buffer. m_channels points to either.
+    AudioBuffer<float, HugePageAllocator> m_buffer;
+    std::vector<MirroredMemory> m_mirrors;
+    std::vector<float*> m_channels;
+    size_t m_capacity = 0;
 };
 
 } // namespace anira
 
-#endif //ANIRA_RINGBUFFER_H
\ No newline at end of file
+#endif //ANIRA_RINGBUFFER_H
@@ -0,0 +1,46 @@
+#ifndef ANIRA_TENSORBLOCK_H
+#define ANIRA_TENSORBLOCK_H
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include "MemoryBlock.h"
+#include "../system/CacheLine.h"
+#include "../system/AniraWinExports.h"
+
+namespace anira {
+
+// A float tensor that is shared between threads. It is double buffered: a writer fills the copy that is not published and then publishes it, so readers always copy the last complete write with memcpy.
+// Writers never wait for readers, several writers are serialized. Readers never wait for a writer either, they only retry if two writes completed while they were copying.
+// The unpublished copy only misses the range of the last write, so a write costs as much as its own range and the previous one, and filling a tensor value by value stays linear.
+class ANIRA_API TensorBlock {
+public:
+    TensorBlock(size_t size = 0);
+
+    // Neither resizing nor moving is thread safe, they are only meant for setting up the tensor
+    TensorBlock(TensorBlock&& other) noexcept;
+    TensorBlock& operator=(TensorBlock&& other) noexcept;
+    void resize(size_t size);
+
+    size_t size() const;
+
+    void write(const float* data, size_t num_values, size_t offset = 0);
+    void read(float* data, size_t num_values, size_t offset = 0) const;
+
+private:
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> m_writing{false};
+    // Index of the copy with the last complete write
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_current{0};
+    // The sequence of a copy is odd while it is written
+    std::array<std::atomic<size_t>, 2> m_sequences{};
+    std::array<MemoryBlock<float>, 2> m_data;
+
+    // Only accessed by the writer that holds m_writing. A copy is up to date except for the last write if its version is one behind the published copy.
+    std::array<size_t, 2> m_versions{};
+    size_t m_last_write_offset = 0;
+    size_t m_last_write_size = 0;
+};
+
+} // namespace anira
+
+#endif // ANIRA_TENSORBLOCK_H
@@ -58,9 +58,7 @@ static void fill_buffer(AudioBufferF &buffer){
 /// @param buffer 
 /// @param ringbuffer 
 static void push_buffer_to_ringbuffer(AudioBufferF const &buffer, RingBuffer &ringbuffer){
-    for (size_t i = 0; i < buffer.get_num_samples(); i++){
-        ringbuffer.push_sample(0, buffer.get_sample(0, i));
-    }
+    ringbuffer.push_block(0, buffer.get_read_pointer(0), buffer.get_num_samples());
 }
 
 
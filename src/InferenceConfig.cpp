@@ -1,4 +1,5 @@
 #include <anira/InferenceConfig.h>
+#include <algorithm>
 
 namespace anira {
 
@@ -52,6 +53,17 @@ InferenceConfig::InferenceConfig (
             }
         }
     }
+    update_sizes();
+    if (m_session_exclusive_processor) {
+        m_num_parallel_processors = 1;
+    }
+    if (m_num_parallel_processors < 1) {
+        m_num_parallel_processors = 1;
+        std::cout << "[WARNING] Number of parellel processors must be at least 1. Setting to 1." << std::endl;
+    }
+}
+
+void InferenceConfig::update_sizes() {
     m_input_sizes.resize(m_tensor_shape[0].m_input_shape.size());
     for(int i = 0; i < m_tensor_shape[0].m_input_shape.size(); ++i) {
         m_input_sizes[i] = 1;
@@ -66,13 +78,6 @@ InferenceConfig::InferenceConfig (
             m_output_sizes[i] *= (int) m_tensor_shape[0].m_output_shape[i][j];
         }
     }
-    if (m_session_exclusive_processor) {
-        m_num_parallel_processors = 1;
-    }
-    if (m_num_parallel_processors < 1) {
-        m_num_parallel_processors = 1;
-        std::cout << "[WARNING] Number of parellel processors must be at least 1. Setting to 1." << std::endl;
-    }
 }
 
 void InferenceConfig::set_input_sizes(const std::vector<size_t>& input_sizes) {
@@ -167,6 +172,33 @@ void InferenceConfig::set_model_path(const std::string& model_path, InferenceBac
     assert((false && "No model path found for backend."));
 }
 
+void InferenceConfig::set_model_data(const ModelData& model_data) {
+    // The models are copy constructed into a new list, since assigning a model does not take over the ownership of a path when the binary flag changes
+    std::vector<ModelData> model_data_list;
+    for (const auto& model : m_model_data) {
+        if (model.m_backend != model_data.m_backend) {
+            model_data_list.push_back(model);
+        }
+    }
+    model_data_list.push_back(model_data);
+    m_model_data.swap(model_data_list);
+
+    for (const auto& tensor_shape : m_tensor_shape) {
+        if (!tensor_shape.m_universal && tensor_shape.m_backend == model_data.m_backend) {
+            return;
+        }
+    }
+    for (const auto& tensor_shape : m_tensor_shape) {
+        if (tensor_shape.m_universal) {
+            TensorShape backend_tensor_shape = tensor_shape;
+            backend_tensor_shape.m_backend = model_data.m_backend;
+            m_tensor_shape.push_back(backend_tensor_shape);
+            return;
+        }
+    }
+    assert((false && "No tensor shape provided for model."));
+}
+
 void InferenceConfig::set_input_shape(const TensorShapeList& input_shape, InferenceBackend backend) {
     for (int i = 0; i < m_tensor_shape.size(); ++i) {
         if (m_tensor_shape[i].m_backend == backend) {
@@ -187,4 +219,27 @@ void InferenceConfig::set_output_shape(const TensorShapeList& output_shape, Infe
     assert((false && "No tensor shape found for backend."));
 }
 
+bool InferenceConfig::set_chunk_size(size_t chunk_size) {
+    // The input keeps its past samples, so both time axes change by the same number of samples
+    int64_t difference = (int64_t) chunk_size - (int64_t) get_chunk_size();
+    std::vector<TensorShape> tensor_shapes = m_tensor_shape;
+    for (auto& tensor_shape : tensor_shapes) {
+        std::array<std::vector<int64_t>*, 2> shapes = {&tensor_shape.m_input_shape[m_index_audio_data[Input]], &tensor_shape.m_output_shape[m_index_audio_data[Output]]};
+        for (size_t i = 0; i < shapes.size(); ++i) {
+            int64_t time_axis = m_time_axis[i] < 0 ? (int64_t) shapes[i]->size() + m_time_axis[i] : m_time_axis[i];
+            if (time_axis < 0 || time_axis >= (int64_t) shapes[i]->size() || (*shapes[i])[time_axis] + difference < 1) {
+                return false;
+            }
+            (*shapes[i])[time_axis] += difference;
+        }
+    }
+    m_tensor_shape = tensor_shapes;
+    update_sizes();
+    return true;
+}
+
+size_t InferenceConfig::get_chunk_size() const {
+    return m_output_sizes[m_index_audio_data[Output]] / m_num_audio_channels[Output];
+}
+
 } // namespace anira
@@ -16,6 +16,14 @@ void InferenceHandler::prepare(HostAudioConfig new_audio_config) {
     m_inference_manager.prepare(new_audio_config);
 }
 
+void InferenceHandler::set_non_realtime(bool non_realtime) {
+    m_inference_manager.set_non_realtime(non_realtime);
+}
+
+bool InferenceHandler::is_non_realtime() {
+    return m_inference_manager.is_non_realtime();
+}
+
 void InferenceHandler::process(float* const* data, size_t num_samples) {
     m_inference_manager.process(data, data, num_samples);
 }
@@ -36,6 +44,34 @@ int InferenceHandler::get_latency() {
     return m_inference_manager.get_latency();
 }
 
+size_t InferenceHandler::get_chunk_size() {
+    return m_inference_manager.get_chunk_size();
+}
+
+InferenceStats InferenceHandler::get_stats() {
+    return m_inference_manager.get_stats();
+}
+
+void InferenceHandler::reset_stats() {
+    m_inference_manager.reset_stats();
+}
+
+void InferenceHandler::set_latency_change_callback(std::function<void(int requested_latency)> callback) {
+    m_inference_manager.set_latency_change_callback(callback);
+}
+
+bool InferenceHandler::load_model_async(const ModelData& model_data, size_t crossfade_samples) {
+    return m_inference_manager.load_model_async(model_data, crossfade_samples);
+}
+
+bool InferenceHandler::set_custom_processor_async(BackendBase& custom_processor, size_t crossfade_samples) {
+    return m_inference_manager.set_custom_processor_async(custom_processor, crossfade_samples);
+}
+
+bool InferenceHandler::is_swapping_model() {
+    return m_inference_manager.is_swapping_model();
+}
+
 void InferenceHandler::exec_inference() {
     m_inference_manager.exec_inference();
 }
@@ -31,10 +31,9 @@ void PrePostProcessor::post_process(AudioBufferF& input, RingBuffer& output, [[m
 }
 
 void PrePostProcessor::pop_samples_from_buffer(RingBuffer& input, AudioBufferF& output) {
+    output.reset_channel_ptr();
     for (size_t i = 0; i < output.get_num_channels(); i++) {
-        for (size_t j = 0; j < output.get_num_samples(); j++) {
-            output.set_sample(i, j, input.pop_sample(i));
-        }
+        input.pop_block(i, output.get_write_pointer(i), output.get_num_samples());
     }
 }
 
@@ -43,24 +42,24 @@ void PrePostProcessor::pop_samples_from_buffer(RingBuffer& input, AudioBufferF&
 }
 
 void PrePostProcessor::pop_samples_from_buffer(RingBuffer& input, AudioBufferF& output, size_t num_new_samples, size_t num_old_samples, size_t offset) {
-    int num_total_samples = num_new_samples + num_old_samples;
+    size_t num_total_samples = num_new_samples + num_old_samples;
+    // A mono model input can point straight into the history of a mirrored buffer, the backends only read it
+    if (input.is_mirrored() && output.get_num_channels() == 1 && offset == 0 && num_total_samples == output.get_num_samples()) {
+        input.discard_block(0, num_new_samples);
+        output.set_view(const_cast<float*>(input.get_window(0, num_total_samples, num_total_samples)));
+        return;
+    }
+    output.reset_channel_ptr();
     for (size_t i = 0; i < output.get_num_channels(); i++) {
-        // int j is important to be signed, because it is used in the condition j >= 0
-        for (int j = num_total_samples - 1; j >= 0; j--) {
-            if (j >= num_old_samples) {
-                output.set_sample(i, (size_t) (num_total_samples - j + num_old_samples - 1) + offset, input.pop_sample(i));
-            } else {
-                output.set_sample(i, (size_t) j + offset, input.get_sample_from_tail(i, num_total_samples - (size_t) j));
-            }
-        }
+        // First pop the new samples behind the old ones, then the old samples are the num_total_samples samples before the new read position
+        input.pop_block(i, output.get_write_pointer(i, offset + num_old_samples), num_new_samples);
+        input.peek_from_tail(i, output.get_write_pointer(i, offset), num_old_samples, num_total_samples);
     }
 }
 
 void PrePostProcessor::push_samples_to_buffer(const AudioBufferF& input, RingBuffer& output) {
     for (size_t i = 0; i < input.get_num_channels(); i++) {
-        for (size_t j = 0; j < input.get_num_samples(); j++) {
-            output.push_sample(i, input.get_sample(i, j));
-        }
+        output.push_block(i, input.get_read_pointer(i), input.get_num_samples());
     }
 }
 
@@ -68,28 +67,56 @@ void PrePostProcessor::set_input(const float& input, size_t i, size_t j) {
     assert(("Index i out of bounds" && i < m_inputs.size()));
     assert(("Index j out of bounds" && j < m_inputs[i].size()));
     assert(("Index contains audio data, which should be passed in the processBlock method." && i != m_index_audio_data[Input]));
-    m_inputs[i][j].store(input);
+    m_inputs[i].write(&input, 1, j);
 }
 
 void PrePostProcessor::set_output(const float& output, size_t i, size_t j) {
     assert(("Index i out of bounds" && i < m_outputs.size()));
     assert(("Index j out of bounds" && j < m_outputs[i].size()));
     assert(("Index contains audio data, which should be returned in the processBlock method." && i != m_index_audio_data[Output]));
-    m_outputs[i][j].store(output);
+    m_outputs[i].write(&output, 1, j);
 }
 
 float PrePostProcessor::get_input(size_t i, size_t j) {
     assert(("Index i out of bounds" && i < m_inputs.size()));
     assert(("Index j out of bounds" && j < m_inputs[i].size()));
     assert(("Index contains audio data, which should be passed in the processBlock method." && i != m_index_audio_data[Input]));
-    return m_inputs[i][j].load();
+    float input;
+    m_inputs[i].read(&input, 1, j);
+    return input;
 }
 
 float PrePostProcessor::get_output(size_t i, size_t j) {
     assert(("Index i out of bounds" && i < m_outputs.size()));
     assert(("Index j out of bounds" && j < m_outputs[i].size()));
     assert(("Index contains audio data, which should be returned in the processBlock method." && i != m_index_audio_data[Output]));
-    return m_outputs[i][j].load();
+    float output;
+    m_outputs[i].read(&output, 1, j);
+    return output;
+}
+
+void PrePostProcessor::set_input_tensor(const float* input, size_t i) {
+    assert(("Index i out of bounds" && i < m_inputs.size()));
+    assert(("Index contains audio data, which should be passed in the processBlock method." && i != m_index_audio_data[Input]));
+    m_inputs[i].write(input, m_inputs[i].size());
+}
+
+void PrePostProcessor::set_output_tensor(const float* output, size_t i) {
+    assert(("Index i out of bounds" && i < m_outputs.size()));
+    assert(("Index contains audio data, which should be returned in the processBlock method." && i != m_index_audio_data[Output]));
+    m_outputs[i].write(output, m_outputs[i].size());
+}
+
+void PrePostProcessor::get_input_tensor(float* input, size_t i) {
+    assert(("Index i out of bounds" && i < m_inputs.size()));
+    assert(("Index contains audio data, which should be passed in the processBlock method." && i != m_index_audio_data[Input]));
+    m_inputs[i].read(input, m_inputs[i].size());
+}
+
+void PrePostProcessor::get_output_tensor(float* output, size_t i) {
+    assert(("Index i out of bounds" && i < m_outputs.size()));
+    assert(("Index contains audio data, which should be returned in the processBlock method." && i != m_index_audio_data[Output]));
+    m_outputs[i].read(output, m_outputs[i].size());
 }
 
 } // namespace anira
\ No newline at end of file
@@ -1,14 +1,33 @@
 #include <anira/backends/BackendBase.h>
+#include <anira/scheduler/SessionElement.h>
+#include <anira/scheduler/WorkerQueues.h>
+#include <anira/system/RealtimeLogger.h>
+#include <algorithm>
+#include <thread>
 
 namespace anira {
 
+// Set by the inference threads while they process, so that a release can hand over the inference it could not resubmit
+static thread_local std::vector<InferenceData>* t_unsubmitted_inferences = nullptr;
+
 BackendBase::BackendBase(InferenceConfig& inference_config) : m_inference_config(inference_config) {
 }
 
+BackendBase::~BackendBase() {
+}
+
 void BackendBase::prepare() {
 
 }
 
+void BackendBase::prepare_session([[maybe_unused]] SessionElement& session) {
+
+}
+
+void BackendBase::release_session([[maybe_unused]] int session_id) {
+
+}
+
 void BackendBase::process(AudioBufferF& input, AudioBufferF& output, [[maybe_unused]] std::shared_ptr<SessionElement> session) {
     auto equal_channels = input.get_num_channels() == output.get_num_channels();
     auto sample_diff = input.get_num_samples() - output.get_num_samples();
@@ -28,4 +47,101 @@ void BackendBase::process(AudioBufferF& input, AudioBufferF& output, [[maybe_unu
     }
 }
 
-}
\ No newline at end of file
+void BackendBase::process_batch(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions) {
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        process(*inputs[i], *outputs[i], sessions[i]);
+    }
+}
+
+bool BackendBase::try_process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) {
+    process(input, output, session);
+    return true;
+}
+
+bool BackendBase::try_process_batch(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions) {
+    process_batch(inputs, outputs, sessions);
+    return true;
+}
+
+bool BackendBase::try_process_or_wait(AudioBufferF& input, AudioBufferF& output, const InferenceData& inference_data, WorkerQueues& queues) {
+    // Read before the attempt, so that a release between the attempt and the wait is noticed
+    uint64_t num_released_instances = m_num_released_instances.load();
+    if (try_process(input, output, inference_data.m_session)) {
+        return true;
+    }
+    wait_for_instance(&inference_data, 1, queues, num_released_instances);
+    return false;
+}
+
+bool BackendBase::try_process_batch_or_wait(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions, const std::vector<InferenceData>& batch, WorkerQueues& queues) {
+    uint64_t num_released_instances = m_num_released_instances.load();
+    if (try_process_batch(inputs, outputs, sessions)) {
+        return true;
+    }
+    // The inferences are resubmitted one by one and batched again by the thread that takes them
+    wait_for_instance(batch.data(), batch.size(), queues, num_released_instances);
+    return false;
+}
+
+void BackendBase::release_instance(FreeList& free_instances, size_t index) {
+    free_instances.release(index);
+    // Both sides store first and load second with sequential consistency, so either we see the waiting inference or it sees our release
+    m_num_released_instances.fetch_add(1);
+    if (m_num_waiting_inferences.load() > 0) {
+        resubmit_waiting_inference();
+    }
+}
+
+void BackendBase::wait_for_instance(const InferenceData* inference_data, size_t num_inferences, WorkerQueues& queues, uint64_t num_released_instances) {
+    {
+        std::lock_guard<std::mutex> lock(m_waiting_mutex);
+        m_waiting_queues = &queues;
+        m_waiting_inferences.insert(m_waiting_inferences.end(), inference_data, inference_data + num_inferences);
+        m_num_waiting_inferences.store(m_waiting_inferences.size());
+    }
+    // Instances were released since the attempt, possibly before the releases saw us waiting
+    uint64_t num_missed_releases = std::min<uint64_t>(m_num_released_instances.load() - num_released_instances, num_inferences);
+    for (uint64_t i = 0; i < num_missed_releases; ++i) {
+        resubmit_waiting_inference();
+    }
+}
+
+void BackendBase::resubmit_waiting_inference() {
+    InferenceData inference_data;
+    WorkerQueues* queues;
+    {
+        std::lock_guard<std::mutex> lock(m_waiting_mutex);
+        if (m_waiting_inferences.empty()) {
+            return;
+        }
+        // One instance was released, so the inference with the earliest deadline goes first. The others wait for the next release.
+        auto earliest = std::min_element(m_waiting_inferences.begin(), m_waiting_inferences.end(), [](const InferenceData& a, const InferenceData& b) {
+            return a.m_deadline < b.m_deadline;
+        });
+        inference_data = *earliest;
+        *earliest = m_waiting_inferences.back();
+        m_waiting_inferences.pop_back();
+        m_num_waiting_inferences.store(m_waiting_inferences.size());
+        queues = m_waiting_queues;
+    }
+    if (!queues->try_enqueue(inference_data)) {
+        // No later release may come for it, so like a parked inference it is processed by the inference thread that released the instance
+        if (t_unsubmitted_inferences != nullptr) {
+            RealtimeLogger::log(LogLevel::Warning, "Could not resubmit the inference waiting for an instance, processing it right away", inference_data.m_session->m_session_id);
+            t_unsubmitted_inferences->push_back(inference_data);
+            return;
+        }
+        // Released outside of the inference threads, which keep taking inferences from the queues
+        while (!queues->try_enqueue(inference_data)) {
+            std::this_thread::yield();
+        }
+    }
+    // The waiting inference was counted as active, so that the session was not idled meanwhile
+    inference_data.m_session->m_active_inferences.fetch_sub(1, std::memory_order::release);
+}
+
+void BackendBase::set_unsubmitted_inferences(std::vector<InferenceData>* unsubmitted_inferences) {
+    t_unsubmitted_inferences = unsubmitted_inferences;
+}
+
+} // namespace anira
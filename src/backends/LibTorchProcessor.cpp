@@ -5,8 +5,30 @@ namespace anira {
 LibtorchProcessor::LibtorchProcessor(InferenceConfig& inference_config) : BackendBase(inference_config) {
     torch::set_num_threads(1);
 
+    m_module = ModelCache::get<torch::jit::script::Module>(ModelCache::get_key(m_inference_config, anira::InferenceBackend::LIBTORCH), [this]() {
+        auto module = std::make_shared<torch::jit::script::Module>();
+        try {
+            *module = torch::jit::load(m_inference_config.get_model_path(anira::InferenceBackend::LIBTORCH));
+        }
+        catch (const c10::Error& e) {
+            std::cerr << "[ERROR] error loading the model\n";
+            std::cerr << e.what() << std::endl;
+        }
+        return module;
+    });
+
+    // Cloning registers the types of the clone in the compilation unit shared with the model, so only the warm up runs on temporary threads in parallel
     for (unsigned int i = 0; i < m_inference_config.m_num_parallel_processors; ++i) {
-        m_instances.emplace_back(std::make_shared<Instance>(m_inference_config));
+        m_instances.emplace_back(std::make_shared<Instance>(m_inference_config, *m_module));
+    }
+    parallel_for(m_inference_config.m_warm_up_policy == WarmUpPolicy::PerInstance ? m_instances.size() : 1, [this](size_t i) {
+        m_instances[i]->warm_up();
+    });
+    m_free_instances.resize(m_instances.size());
+
+    if (m_inference_config.m_max_batch_size > 1 && !m_instances[0]->check_batching()) {
+        std::cout << "[WARNING] The LibTorch model does not accept a dynamic first dimension, its inferences are not batched." << std::endl;
+        m_batching_supported = false;
     }
 }
 
@@ -19,26 +41,41 @@ void LibtorchProcessor::prepare() {
     }
 }
 
-void LibtorchProcessor::process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) { 
-    while (true) {
-        for(auto& instance : m_instances) {
-            if (!(instance->m_processing.exchange(true))) {
-                instance->process(input, output, session);
-                instance->m_processing.exchange(false);
-                return;
-            }
-        }
-    }
+void LibtorchProcessor::process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) {
+    size_t index = m_free_instances.acquire();
+    m_instances[index]->process(input, output, session);
+    release_instance(m_free_instances, index);
 }
 
-LibtorchProcessor::Instance::Instance(InferenceConfig& inference_config) : m_inference_config(inference_config) {
-    try {
-        m_module = torch::jit::load(m_inference_config.get_model_path(anira::InferenceBackend::LIBTORCH));
+bool LibtorchProcessor::try_process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) {
+    size_t index;
+    if (!m_free_instances.try_acquire(index)) {
+        return false;
     }
-    catch (const c10::Error& e) {
-        std::cerr << "[ERROR] error loading the model\n";
-        std::cerr << e.what() << std::endl;
+    m_instances[index]->process(input, output, session);
+    release_instance(m_free_instances, index);
+    return true;
+}
+
+void LibtorchProcessor::process_batch(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions) {
+    size_t index = m_free_instances.acquire();
+    m_instances[index]->process_batch(inputs, outputs, sessions);
+    release_instance(m_free_instances, index);
+}
+
+bool LibtorchProcessor::try_process_batch(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions) {
+    size_t index;
+    if (!m_free_instances.try_acquire(index)) {
+        return false;
     }
+    m_instances[index]->process_batch(inputs, outputs, sessions);
+    release_instance(m_free_instances, index);
+    return true;
+}
+
+LibtorchProcessor::Instance::Instance(InferenceConfig& inference_config, const torch::jit::script::Module& module) : m_inference_config(inference_config) {
+    // With inplace set, the clone gets its own module objects, but shares the parameters and buffers instead of copying them
+    m_module = module.clone(true);
     m_inputs.resize(m_inference_config.m_input_sizes.size());
     m_input_data.resize(m_inference_config.m_input_sizes.size());
     for (size_t i = 0; i < m_inference_config.m_input_sizes.size(); i++) {
@@ -46,11 +83,44 @@ LibtorchProcessor::Instance::Instance(InferenceConfig& inference_config) : m_inf
         m_inputs[i] = torch::from_blob(m_input_data[i].data(), m_inference_config.get_input_shape(anira::InferenceBackend::LIBTORCH)[i]);
     }
 
+    if (m_inference_config.m_max_batch_size > 1) {
+        m_batch_inputs.resize(m_inference_config.m_input_sizes.size());
+        m_batch_input_data.resize(m_inference_config.m_input_sizes.size());
+        m_batch_input_shapes.resize(m_inference_config.m_input_sizes.size());
+        for (size_t i = 0; i < m_inference_config.m_input_sizes.size(); i++) {
+            m_batch_input_data[i].resize(m_inference_config.m_input_sizes[i] * m_inference_config.m_max_batch_size);
+            m_batch_input_shapes[i] = m_inference_config.get_input_shape(anira::InferenceBackend::LIBTORCH)[i];
+        }
+    }
+}
+
+void LibtorchProcessor::Instance::warm_up() {
     for (size_t i = 0; i < m_inference_config.m_warm_up; i++) {
         m_outputs = m_module.forward(m_inputs);
     }
 }
 
+bool LibtorchProcessor::Instance::check_batching() {
+    std::vector<c10::IValue> batch_inputs;
+    for (size_t i = 0; i < m_inference_config.m_input_sizes.size(); i++) {
+        std::vector<int64_t> shape = m_inference_config.get_input_shape(anira::InferenceBackend::LIBTORCH)[i];
+        shape[0] *= 2;
+        batch_inputs.emplace_back(torch::zeros(shape));
+    }
+    try {
+        c10::IValue batch_outputs = m_module.forward(batch_inputs);
+        for (size_t i = 0; i < m_inference_config.m_output_sizes.size(); i++) {
+            torch::Tensor output_tensor = get_output_tensor(batch_outputs, i);
+            if (!output_tensor.defined() || (size_t) output_tensor.numel() != 2 * m_inference_config.m_output_sizes[i]) {
+                return false;
+            }
+        }
+    } catch (const c10::Error&) {
+        return false;
+    }
+    return true;
+}
+
 void LibtorchProcessor::Instance::prepare() {
     for (size_t i = 0; i < m_inference_config.m_input_sizes.size(); i++) {
         m_input_data[i].clear();
@@ -59,51 +129,102 @@ void LibtorchProcessor::Instance::prepare() {
 
 void LibtorchProcessor::Instance::process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) {
     for (size_t i = 0; i < m_inference_config.m_input_sizes.size(); i++) {
+        float* input_data = m_input_data[i].data();
         if (i != m_inference_config.m_index_audio_data[Input]) {
-            for (size_t j = 0; j < m_input_data[i].size(); j++) {
-                m_input_data[i][j] = session->m_pp_processor.get_input(i, j);
-            }
+            session->get_input_tensor(input_data, i);
+        } else if (input.is_view()) {
+            // The input points into the history of a mirrored ring buffer, which the tensor reads in place
+            input_data = input.data();
         } else {
             m_input_data[i].swap_data(input.get_memory_block());
             input.reset_channel_ptr();
+            input_data = m_input_data[i].data();
         }
         // This is necessary because the tensor data pointers seem to change from inference to inference
-        m_inputs[i] = torch::from_blob(m_input_data[i].data(), m_inference_config.get_input_shape(anira::InferenceBackend::LIBTORCH)[i]);
+        m_inputs[i] = torch::from_blob(input_data, m_inference_config.get_input_shape(anira::InferenceBackend::LIBTORCH)[i]);
     }
 
     // Run inference
     m_outputs = m_module.forward(m_inputs);
 
-    // We need to copy the data because we cannot access the data pointer ref of the tensor directly
-    if(m_outputs.isTuple()) {
-        for (size_t i = 0; i < m_inference_config.m_output_sizes.size(); i++) {
-            if (i != m_inference_config.m_index_audio_data[Output]) {
-                for (size_t j = 0; j < m_inference_config.m_output_sizes[i]; j++) {
-                    session->m_pp_processor.set_output(m_outputs.toTuple()->elements()[i].toTensor().view({-1}).data_ptr<float>()[j], i, j);
-                }
+    // TorchScript modules always return newly allocated tensors, so every output is copied in one block
+    for (size_t i = 0; i < m_inference_config.m_output_sizes.size(); i++) {
+        torch::Tensor output_tensor = get_output_tensor(m_outputs, i);
+        if (!output_tensor.defined()) {
+            break;
+        }
+        const float* output_read_ptr = output_tensor.data_ptr<float>();
+        if (i != m_inference_config.m_index_audio_data[Output]) {
+            session->set_output_tensor(output_read_ptr, i);
+        } else {
+            std::memcpy(output.data(), output_read_ptr, m_inference_config.m_output_sizes[i] * sizeof(float));
+        }
+    }
+}
+
+void LibtorchProcessor::Instance::process_batch(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions) {
+    size_t batch_size = sessions.size();
+    if (batch_size == 1 || m_batch_inputs.empty()) {
+        for (size_t b = 0; b < batch_size; b++) {
+            process(*inputs[b], *outputs[b], sessions[b]);
+        }
+        return;
+    }
+    for (size_t i = 0; i < m_inference_config.m_input_sizes.size(); i++) {
+        size_t input_size = m_inference_config.m_input_sizes[i];
+        for (size_t b = 0; b < batch_size; b++) {
+            float* batch_input = m_batch_input_data[i].data() + b * input_size;
+            if (i != m_inference_config.m_index_audio_data[Input]) {
+                sessions[b]->get_input_tensor(batch_input, i);
             } else {
-                for (size_t j = 0; j < m_inference_config.m_output_sizes[i]; j++) {
-                    output.get_memory_block()[j] = m_outputs.toTuple()->elements()[i].toTensor().view({-1}).data_ptr<float>()[j];
-                }
+                std::memcpy(batch_input, inputs[b]->data(), input_size * sizeof(float));
             }
         }
-    } else if(m_outputs.isTensorList()) {
-        for (size_t i = 0; i < m_inference_config.m_output_sizes.size(); i++) {
+        m_batch_input_shapes[i][0] = m_inference_config.get_input_shape(anira::InferenceBackend::LIBTORCH)[i][0] * (int64_t) batch_size;
+        m_batch_inputs[i] = torch::from_blob(m_batch_input_data[i].data(), m_batch_input_shapes[i]);
+    }
+
+    c10::IValue batch_outputs;
+    try {
+        batch_outputs = m_module.forward(m_batch_inputs);
+    } catch (const c10::Error&) {
+        RealtimeLogger::log(LogLevel::Error, "Batched LibTorch inference failed, processing the batch sequentially", sessions[0]->m_session_id);
+        for (size_t b = 0; b < batch_size; b++) {
+            process(*inputs[b], *outputs[b], sessions[b]);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < m_inference_config.m_output_sizes.size(); i++) {
+        torch::Tensor output_tensor = get_output_tensor(batch_outputs, i);
+        if (!output_tensor.defined()) {
+            break;
+        }
+        const float* output_read_ptr = output_tensor.data_ptr<float>();
+        size_t output_size = m_inference_config.m_output_sizes[i];
+        for (size_t b = 0; b < batch_size; b++) {
             if (i != m_inference_config.m_index_audio_data[Output]) {
-                for (size_t j = 0; j < m_inference_config.m_output_sizes[i]; j++) {
-                    session->m_pp_processor.set_output(m_outputs.toTensorList().get(i).view({-1}).data_ptr<float>()[j], i, j);
-                }
+                sessions[b]->set_output_tensor(output_read_ptr + b * output_size, i);
             } else {
-                for (size_t j = 0; j < m_inference_config.m_output_sizes[i]; j++) {
-                    output.get_memory_block()[j] = m_outputs.toTensorList().get(i).view({-1}).data_ptr<float>()[j];
-                }
+                std::memcpy(outputs[b]->data(), output_read_ptr + b * output_size, output_size * sizeof(float));
             }
         }
-    } else if (m_outputs.isTensor()) {
-        for (size_t i = 0; i < m_inference_config.m_output_sizes[0]; i++) {
-            output.get_memory_block()[i] = m_outputs.toTensor().view({-1}).data_ptr<float>()[i];
-        }
     }
 }
 
+torch::Tensor LibtorchProcessor::Instance::get_output_tensor(const c10::IValue& outputs, size_t index) {
+    torch::Tensor output_tensor;
+    if (outputs.isTuple()) {
+        output_tensor = outputs.toTuple()->elements()[index].toTensor();
+    } else if (outputs.isTensorList()) {
+        output_tensor = outputs.toTensorList().get(index);
+    } else if (outputs.isTensor() && index == 0) {
+        output_tensor = outputs.toTensor();
+    } else {
+        return output_tensor;
+    }
+    // The model output may be a strided view, the copies need one contiguous block
+    return output_tensor.contiguous();
+}
+
 } // namespace anira
\ No newline at end of file
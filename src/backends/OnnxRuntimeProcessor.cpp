@@ -4,59 +4,68 @@ namespace anira {
 
 OnnxRuntimeProcessor::OnnxRuntimeProcessor(InferenceConfig& inference_config) : BackendBase(inference_config)
 {
-    for (unsigned int i = 0; i < m_inference_config.m_num_parallel_processors; ++i) {
-        m_instances.emplace_back(std::make_shared<Instance>(m_inference_config));
+    m_model = ModelCache::get<Model>(ModelCache::get_key(m_inference_config, anira::InferenceBackend::ONNX), [this]() {
+        return std::make_shared<Model>(m_inference_config);
+    });
+
+    if (m_inference_config.m_max_batch_size > 1 && !m_model->m_dynamic_batch) {
+        std::cout << "[WARNING] The first dimension of the ONNX model is not dynamic, its inferences are not batched." << std::endl;
+        m_batching_supported = false;
     }
-}
 
-OnnxRuntimeProcessor::~OnnxRuntimeProcessor() {
+    // Building and warming up the instances takes long for large models, so they are spread over temporary threads
+    m_instances.resize(m_inference_config.m_num_parallel_processors);
+    parallel_for(m_instances.size(), [this](size_t i) {
+        m_instances[i] = std::make_shared<Instance>(m_inference_config, *m_model->m_session, m_model->m_input_names, m_model->m_output_names, m_batching_supported);
+        if (i == 0 || m_inference_config.m_warm_up_policy == WarmUpPolicy::PerInstance) {
+            m_instances[i]->warm_up();
+        }
+    });
+    m_free_instances.resize(m_instances.size());
 }
 
-void OnnxRuntimeProcessor::prepare() {
-    for(auto& instance : m_instances) {
-        instance->prepare();
-    }
+OnnxRuntimeProcessor::~OnnxRuntimeProcessor() {
+    // The instances refer to the session of the model, so they go first
+    m_instances.clear();
+    m_model.reset();
 }
 
-void OnnxRuntimeProcessor::process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) {
-    while (true) {
-        for(auto& instance : m_instances) {
-            if (!(instance->m_processing.exchange(true))) {
-                instance->process(input, output, session);
-                instance->m_processing.exchange(false);
-                return;
-            }
-        }
+std::shared_ptr<Ort::Env> OnnxRuntimeProcessor::get_env() {
+    static std::mutex mutex;
+    static std::weak_ptr<Ort::Env> cached_env;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<Ort::Env> env = cached_env.lock();
+    if (env == nullptr) {
+        env = std::make_shared<Ort::Env>();
+        cached_env = env;
     }
+    return env;
 }
 
-OnnxRuntimeProcessor::Instance::Instance(InferenceConfig& inference_config) : m_memory_info(Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU)),
-                                                                    m_inference_config(inference_config)
+OnnxRuntimeProcessor::Model::Model(InferenceConfig& inference_config) : m_env(get_env())
 {
     m_session_options.SetIntraOpNumThreads(1);
 
     // Check if the model is binary
-    if (m_inference_config.is_model_binary(anira::InferenceBackend::ONNX)) {
-        const anira::ModelData* model_data = m_inference_config.get_model_data(anira::InferenceBackend::ONNX);
+    if (inference_config.is_model_binary(anira::InferenceBackend::ONNX)) {
+        const anira::ModelData* model_data = inference_config.get_model_data(anira::InferenceBackend::ONNX);
         assert(model_data && "Model data not found for binary model!");
 
         // Load model from binary data
-        m_session = std::make_unique<Ort::Session>(m_env, model_data->m_data, model_data->m_size, m_session_options);
+        m_session = std::make_unique<Ort::Session>(*m_env, model_data->m_data, model_data->m_size, m_session_options);
     } else {
         // Load model from file path
 #ifdef _WIN32
-        std::string modelpath_str = m_inference_config.get_model_path(anira::InferenceBackend::ONNX);
+        std::string modelpath_str = inference_config.get_model_path(anira::InferenceBackend::ONNX);
         std::wstring modelpath = std::wstring(modelpath_str.begin(), modelpath_str.end());
 #else
-        std::string modelpath = m_inference_config.get_model_path(anira::InferenceBackend::ONNX);
+        std::string modelpath = inference_config.get_model_path(anira::InferenceBackend::ONNX);
 #endif
-        m_session = std::make_unique<Ort::Session>(m_env, modelpath.c_str(), m_session_options);
+        m_session = std::make_unique<Ort::Session>(*m_env, modelpath.c_str(), m_session_options);
     }
-    
+
     m_input_names.resize(m_session->GetInputCount());
     m_output_names.resize(m_session->GetOutputCount());
-    m_input_name.clear();
-    m_output_name.clear();
 
     for (size_t i = 0; i < m_session->GetInputCount(); ++i) {
         m_input_name.emplace_back(m_session->GetInputNameAllocated(i, m_ort_alloc));
@@ -67,6 +76,87 @@ OnnxRuntimeProcessor::Instance::Instance(InferenceConfig& inference_config) : m_
         m_output_names[i] = m_output_name[i].get();
     }
 
+    for (size_t i = 0; i < m_session->GetInputCount(); ++i) {
+        std::vector<int64_t> shape = m_session->GetInputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape();
+        if (shape.empty() || shape[0] >= 0) {
+            m_dynamic_batch = false;
+        }
+    }
+    for (size_t i = 0; i < m_session->GetOutputCount(); ++i) {
+        std::vector<int64_t> shape = m_session->GetOutputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape();
+        if (shape.empty() || shape[0] >= 0) {
+            m_dynamic_batch = false;
+        }
+    }
+}
+
+OnnxRuntimeProcessor::Model::~Model() {
+    // Reseting the session here is very important otherwise new models might not be loaded correctly
+    m_session.reset();
+}
+
+void OnnxRuntimeProcessor::prepare() {
+    for(auto& instance : m_instances) {
+        instance->prepare();
+    }
+}
+
+void OnnxRuntimeProcessor::prepare_session(SessionElement& session) {
+    // Waits for every instance in turn, so that the others keep processing the inferences of other sessions
+    for (size_t i = 0; i < m_instances.size(); ++i) {
+        m_free_instances.acquire_index(i);
+        m_instances[i]->prepare_session(session);
+        release_instance(m_free_instances, i);
+    }
+}
+
+void OnnxRuntimeProcessor::release_session(int session_id) {
+    for (size_t i = 0; i < m_instances.size(); ++i) {
+        m_free_instances.acquire_index(i);
+        m_instances[i]->m_session_tensors.erase(session_id);
+        release_instance(m_free_instances, i);
+    }
+}
+
+void OnnxRuntimeProcessor::process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) {
+    size_t index = m_free_instances.acquire();
+    m_instances[index]->process(input, output, session);
+    release_instance(m_free_instances, index);
+}
+
+bool OnnxRuntimeProcessor::try_process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) {
+    size_t index;
+    if (!m_free_instances.try_acquire(index)) {
+        return false;
+    }
+    m_instances[index]->process(input, output, session);
+    release_instance(m_free_instances, index);
+    return true;
+}
+
+void OnnxRuntimeProcessor::process_batch(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions) {
+    size_t index = m_free_instances.acquire();
+    m_instances[index]->process_batch(inputs, outputs, sessions);
+    release_instance(m_free_instances, index);
+}
+
+bool OnnxRuntimeProcessor::try_process_batch(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions) {
+    size_t index;
+    if (!m_free_instances.try_acquire(index)) {
+        return false;
+    }
+    m_instances[index]->process_batch(inputs, outputs, sessions);
+    release_instance(m_free_instances, index);
+    return true;
+}
+
+OnnxRuntimeProcessor::Instance::Instance(InferenceConfig& inference_config, Ort::Session& session, const std::vector<const char*>& input_names, const std::vector<const char*>& output_names, bool batching) :
+                                                                    m_memory_info(Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU)),
+                                                                    m_session(session),
+                                                                    m_input_names(input_names),
+                                                                    m_output_names(output_names),
+                                                                    m_inference_config(inference_config)
+{
     m_input_data.resize(m_inference_config.m_input_sizes.size());
     m_inputs.clear();
     for (size_t i = 0; i < m_inference_config.m_input_sizes.size(); i++) {
@@ -80,61 +170,203 @@ OnnxRuntimeProcessor::Instance::Instance(InferenceConfig& inference_config) : m_
         ));
     }
 
+    m_output_data.resize(m_inference_config.m_output_sizes.size());
+    m_outputs.clear();
+    for (size_t i = 0; i < m_inference_config.m_output_sizes.size(); i++) {
+        m_output_data[i].resize(m_inference_config.m_output_sizes[i]);
+        m_outputs.emplace_back(Ort::Value::CreateTensor<float>(
+                m_memory_info,
+                m_output_data[i].data(),
+                m_output_data[i].size(),
+                m_inference_config.get_output_shape(anira::InferenceBackend::ONNX)[i].data(),
+                m_inference_config.get_output_shape(anira::InferenceBackend::ONNX)[i].size()
+        ));
+    }
+
+    for (auto& input : m_inputs) {
+        m_input_values.push_back(input);
+    }
+    for (auto& output : m_outputs) {
+        m_output_values.push_back(output);
+    }
+
+    if (batching && m_inference_config.m_max_batch_size > 1) {
+        m_batch_input_data.resize(m_inference_config.m_input_sizes.size());
+        for (size_t i = 0; i < m_inference_config.m_input_sizes.size(); i++) {
+            m_batch_input_data[i].resize(m_inference_config.m_input_sizes[i] * m_inference_config.m_max_batch_size);
+        }
+        m_batch_output_data.resize(m_inference_config.m_output_sizes.size());
+        for (size_t i = 0; i < m_inference_config.m_output_sizes.size(); i++) {
+            m_batch_output_data[i].resize(m_inference_config.m_output_sizes[i] * m_inference_config.m_max_batch_size);
+        }
+        // One set of tensors per batch size, they all view the beginning of the same buffers
+        m_batch_inputs.resize(m_inference_config.m_max_batch_size + 1);
+        m_batch_outputs.resize(m_inference_config.m_max_batch_size + 1);
+        for (size_t batch_size = 2; batch_size <= m_inference_config.m_max_batch_size; batch_size++) {
+            for (size_t i = 0; i < m_inference_config.m_input_sizes.size(); i++) {
+                std::vector<int64_t> shape = m_inference_config.get_input_shape(anira::InferenceBackend::ONNX)[i];
+                shape[0] *= (int64_t) batch_size;
+                m_batch_inputs[batch_size].emplace_back(Ort::Value::CreateTensor<float>(
+                        m_memory_info,
+                        m_batch_input_data[i].data(),
+                        m_inference_config.m_input_sizes[i] * batch_size,
+                        shape.data(),
+                        shape.size()
+                ));
+            }
+            for (size_t i = 0; i < m_inference_config.m_output_sizes.size(); i++) {
+                std::vector<int64_t> shape = m_inference_config.get_output_shape(anira::InferenceBackend::ONNX)[i];
+                shape[0] *= (int64_t) batch_size;
+                m_batch_outputs[batch_size].emplace_back(Ort::Value::CreateTensor<float>(
+                        m_memory_info,
+                        m_batch_output_data[i].data(),
+                        m_inference_config.m_output_sizes[i] * batch_size,
+                        shape.data(),
+                        shape.size()
+                ));
+            }
+        }
+    }
+}
+
+void OnnxRuntimeProcessor::Instance::warm_up() {
     for (size_t i = 0; i < m_inference_config.m_warm_up; i++) {
         try {
-            m_outputs = m_session->Run(Ort::RunOptions{nullptr}, m_input_names.data(), m_inputs.data(), m_input_names.size(), m_output_names.data(), m_output_names.size());
+            m_session.Run(Ort::RunOptions{nullptr}, m_input_names.data(), m_inputs.data(), m_input_names.size(), m_output_names.data(), m_outputs.data(), m_output_names.size());
         } catch (Ort::Exception &e) {
             std::cerr << e.what() << std::endl;
         }
     }
 }
 
-OnnxRuntimeProcessor::Instance::~Instance() {
-    // Reseting the session here is very important otherwise new models might not be loaded correctly
-    m_session.reset();
-}
-
 void OnnxRuntimeProcessor::Instance::prepare() {
     for (auto & i : m_input_data) {
         i.clear();
     }
 }
 
+void OnnxRuntimeProcessor::Instance::prepare_session(SessionElement& session) {
+    SessionTensors& tensors = m_session_tensors[session.m_session_id];
+    tensors.m_inputs.clear();
+    tensors.m_outputs.clear();
+
+    size_t input_index = m_inference_config.m_index_audio_data[Input];
+    size_t output_index = m_inference_config.m_index_audio_data[Output];
+    std::vector<int64_t> input_shape = m_inference_config.get_input_shape(anira::InferenceBackend::ONNX)[input_index];
+    std::vector<int64_t> output_shape = m_inference_config.get_output_shape(anira::InferenceBackend::ONNX)[output_index];
+    size_t input_size = m_inference_config.m_input_sizes[input_index];
+    size_t output_size = m_inference_config.m_output_sizes[output_index];
+
+    for (auto& thread_safe_struct : session.m_inference_queue) {
+        float* input_data = thread_safe_struct->m_processed_model_input.data();
+        float* output_data = thread_safe_struct->m_raw_model_output.data();
+        tensors.m_inputs.emplace(input_data, Ort::Value::CreateTensor<float>(m_memory_info, input_data, input_size, input_shape.data(), input_shape.size()));
+        tensors.m_outputs.emplace(output_data, Ort::Value::CreateTensor<float>(m_memory_info, output_data, output_size, output_shape.data(), output_shape.size()));
+    }
+
+    // Only mono inputs become views of the send buffer, see PrePostProcessor::pop_samples_from_buffer. Their windows end at the read position, which advances by the output samples per inference.
+    RingBuffer& send_buffer = session.m_send_buffer;
+    size_t capacity = send_buffer.get_capacity();
+    size_t hop = m_inference_config.m_output_sizes[output_index] / m_inference_config.m_num_audio_channels[Output];
+    if (!send_buffer.is_mirrored() || m_inference_config.m_num_audio_channels[Input] != 1 || capacity % hop != 0 || input_size > capacity) {
+        return;
+    }
+    for (size_t position = 0; position < capacity; position += hop) {
+        float* window = const_cast<float*>(send_buffer.get_window_at_position(0, position + capacity - input_size));
+        tensors.m_inputs.emplace(window, Ort::Value::CreateTensor<float>(m_memory_info, window, input_size, input_shape.data(), input_shape.size()));
+    }
+}
+
+OrtValue* OnnxRuntimeProcessor::Instance::get_session_tensor(int session_id, AudioBufferF& buffer, bool input) {
+    size_t size = input ? m_inference_config.m_input_sizes[m_inference_config.m_index_audio_data[Input]] : m_inference_config.m_output_sizes[m_inference_config.m_index_audio_data[Output]];
+    if (buffer.get_num_channels() * buffer.get_num_samples() != size) {
+        return nullptr;
+    }
+    auto session_tensors = m_session_tensors.find(session_id);
+    if (session_tensors == m_session_tensors.end()) {
+        return nullptr;
+    }
+    auto& tensors = input ? session_tensors->second.m_inputs : session_tensors->second.m_outputs;
+    auto tensor = tensors.find(buffer.data());
+    return tensor != tensors.end() ? (OrtValue*) tensor->second : nullptr;
+}
+
 void OnnxRuntimeProcessor::Instance::process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) {
+    size_t audio_input_index = m_inference_config.m_index_audio_data[Input];
+    size_t audio_output_index = m_inference_config.m_index_audio_data[Output];
     for (size_t i = 0; i < m_inference_config.m_input_sizes.size(); i++) {
-        if (i != m_inference_config.m_index_audio_data[Input]) {
-            for (size_t j = 0; j < m_input_data[i].size(); j++) {
-                m_input_data[i][j] = session->m_pp_processor.get_input(i, j);
-            }
-        } else {
-            m_inputs[i] = Ort::Value::CreateTensor<float>(
-                    m_memory_info,
-                    input.data(),
-                    input.get_num_samples() * input.get_num_channels(),
-                    m_inference_config.get_input_shape(anira::InferenceBackend::ONNX)[i].data(),
-                    m_inference_config.get_input_shape(anira::InferenceBackend::ONNX)[i].size()
-            );
+        if (i != audio_input_index) {
+            session->get_input_tensor(m_input_data[i].data(), i);
         }
     }
 
+    // Run reads and writes the buffers of the session in place, other buffers are copied through the tensors of the instance
+    const OrtValue* input_value = get_session_tensor(session->m_session_id, input, true);
+    if (input_value == nullptr) {
+        std::memcpy(m_input_data[audio_input_index].data(), input.data(), m_inference_config.m_input_sizes[audio_input_index] * sizeof(float));
+        input_value = m_inputs[audio_input_index];
+    }
+    OrtValue* output_value = get_session_tensor(session->m_session_id, output, false);
+    m_input_values[audio_input_index] = input_value;
+    m_output_values[audio_output_index] = output_value != nullptr ? output_value : (OrtValue*) m_outputs[audio_output_index];
+
     try {
-        m_outputs = m_session->Run(Ort::RunOptions{nullptr}, m_input_names.data(), m_inputs.data(), m_input_names.size(), m_output_names.data(), m_output_names.size());
-    } catch (Ort::Exception &e) {
-        std::cerr << e.what() << std::endl;
+        Ort::ThrowOnError(Ort::GetApi().Run(m_session, nullptr, m_input_names.data(), m_input_values.data(), m_input_names.size(), m_output_names.data(), m_output_names.size(), m_output_values.data()));
+    } catch (const Ort::Exception&) {
+        RealtimeLogger::log(LogLevel::Error, "OnnxRuntime inference failed", session->m_session_id);
     }
 
     for (size_t i = 0; i < m_outputs.size(); i++) {
-        const auto output_read_ptr = m_outputs[i].GetTensorMutableData<float>();
-        if (i != m_inference_config.m_index_audio_data[Output]) {
-            for (size_t j = 0; j < m_inference_config.m_output_sizes[i]; j++) {
-                session->m_pp_processor.set_output(output_read_ptr[j], i, j);
+        if (i != audio_output_index) {
+            session->set_output_tensor(m_output_data[i].data(), i);
+        } else if (output_value == nullptr) {
+            std::memcpy(output.data(), m_output_data[i].data(), m_inference_config.m_output_sizes[i] * sizeof(float));
+        }
+    }
+}
+
+void OnnxRuntimeProcessor::Instance::process_batch(std::vector<AudioBufferF*>& inputs, std::vector<AudioBufferF*>& outputs, std::vector<std::shared_ptr<SessionElement>>& sessions) {
+    size_t batch_size = sessions.size();
+    // The tensors of the batches start at two inferences
+    if (batch_size == 1 || m_batch_inputs.empty()) {
+        for (size_t b = 0; b < batch_size; b++) {
+            process(*inputs[b], *outputs[b], sessions[b]);
+        }
+        return;
+    }
+    for (size_t i = 0; i < m_inference_config.m_input_sizes.size(); i++) {
+        size_t input_size = m_inference_config.m_input_sizes[i];
+        for (size_t b = 0; b < batch_size; b++) {
+            float* batch_input = m_batch_input_data[i].data() + b * input_size;
+            if (i != m_inference_config.m_index_audio_data[Input]) {
+                sessions[b]->get_input_tensor(batch_input, i);
+            } else {
+                std::memcpy(batch_input, inputs[b]->data(), input_size * sizeof(float));
             }
-        } else {
-            for (size_t j = 0; j < m_inference_config.m_output_sizes[i]; j++) {
-                output.get_memory_block()[j] = output_read_ptr[j];
+        }
+    }
+
+    try {
+        m_session.Run(Ort::RunOptions{nullptr}, m_input_names.data(), m_batch_inputs[batch_size].data(), m_input_names.size(), m_output_names.data(), m_batch_outputs[batch_size].data(), m_output_names.size());
+    } catch (const Ort::Exception&) {
+        RealtimeLogger::log(LogLevel::Error, "Batched OnnxRuntime inference failed, processing the batch sequentially", sessions[0]->m_session_id);
+        for (size_t b = 0; b < batch_size; b++) {
+            process(*inputs[b], *outputs[b], sessions[b]);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < m_batch_output_data.size(); i++) {
+        const float* output_read_ptr = m_batch_output_data[i].data();
+        size_t output_size = m_inference_config.m_output_sizes[i];
+        for (size_t b = 0; b < batch_size; b++) {
+            if (i != m_inference_config.m_index_audio_data[Output]) {
+                sessions[b]->set_output_tensor(output_read_ptr + b * output_size, i);
+            } else {
+                std::memcpy(outputs[b]->data(), output_read_ptr + b * output_size, output_size * sizeof(float));
             }
         }
     }
 }
 
-} // namespace anira
+} // namespace anira
\ No newline at end of file
@@ -8,12 +8,26 @@ namespace anira {
 
 TFLiteProcessor::TFLiteProcessor(InferenceConfig& inference_config) : BackendBase(inference_config)
 {
-    for (unsigned int i = 0; i < m_inference_config.m_num_parallel_processors; ++i) {
-        m_instances.emplace_back(std::make_shared<Instance>(m_inference_config));
-    }
+    m_model = ModelCache::get<TfLiteModel>(ModelCache::get_key(m_inference_config, anira::InferenceBackend::TFLITE), [this]() {
+        std::string modelpath = m_inference_config.get_model_path(anira::InferenceBackend::TFLITE);
+        return std::shared_ptr<TfLiteModel>(TfLiteModelCreateFromFile(modelpath.c_str()), TfLiteModelDelete);
+    });
+
+    // Every instance allocates the tensors of its own interpreter, so building and warming them up is spread over temporary threads
+    m_instances.resize(m_inference_config.m_num_parallel_processors);
+    parallel_for(m_instances.size(), [this](size_t i) {
+        m_instances[i] = std::make_shared<Instance>(m_inference_config, m_model.get());
+        if (i == 0 || m_inference_config.m_warm_up_policy == WarmUpPolicy::PerInstance) {
+            m_instances[i]->warm_up();
+        }
+    });
+    m_free_instances.resize(m_instances.size());
 }
 
 TFLiteProcessor::~TFLiteProcessor() {
+    // The interpreters must be deleted before the model they use
+    m_instances.clear();
+    m_model.reset();
 }
 
 void TFLiteProcessor::prepare() {
@@ -23,25 +37,26 @@ void TFLiteProcessor::prepare() {
 }
 
 void TFLiteProcessor::process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) {
-    while (true) {
-        for(auto& instance : m_instances) {
-            if (!(instance->m_processing.exchange(true))) {
-                instance->process(input, output, session);
-                instance->m_processing.exchange(false);
-                return;
-            }
-        }
+    size_t index = m_free_instances.acquire();
+    m_instances[index]->process(input, output, session);
+    release_instance(m_free_instances, index);
+}
+
+bool TFLiteProcessor::try_process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) {
+    size_t index;
+    if (!m_free_instances.try_acquire(index)) {
+        return false;
     }
+    m_instances[index]->process(input, output, session);
+    release_instance(m_free_instances, index);
+    return true;
 }
 
-TFLiteProcessor::Instance::Instance(InferenceConfig& inference_config) : m_inference_config(inference_config)
+TFLiteProcessor::Instance::Instance(InferenceConfig& inference_config, TfLiteModel* model) : m_inference_config(inference_config)
 {
-    std::string modelpath = m_inference_config.get_model_path(anira::InferenceBackend::TFLITE);
-    m_model = TfLiteModelCreateFromFile(modelpath.c_str());
-
     m_options = TfLiteInterpreterOptionsCreate();
     TfLiteInterpreterOptionsSetNumThreads(m_options, 1);
-    m_interpreter = TfLiteInterpreterCreate(m_model, m_options);
+    m_interpreter = TfLiteInterpreterCreate(model, m_options);
 
     // This is necessary when we have dynamic input shapes, it should be done before allocating tensors obviously
     for (size_t i = 0; i < m_inference_config.m_input_sizes.size(); i++) {
@@ -66,7 +81,9 @@ TFLiteProcessor::Instance::Instance(InferenceConfig& inference_config) : m_infer
     for (size_t i = 0; i < m_inference_config.m_output_sizes.size(); i++) {
         m_outputs[i] = TfLiteInterpreterGetOutputTensor(m_interpreter, i);
     }
+}
 
+void TFLiteProcessor::Instance::warm_up() {
     for (size_t i = 0; i < m_inference_config.m_warm_up; i++) {
         TfLiteInterpreterInvoke(m_interpreter);
     }
@@ -75,7 +92,6 @@ TFLiteProcessor::Instance::Instance(InferenceConfig& inference_config) : m_infer
 TFLiteProcessor::Instance::~Instance() {
     TfLiteInterpreterDelete(m_interpreter);
     TfLiteInterpreterOptionsDelete(m_options);
-    TfLiteModelDelete(m_model);
 }
 
 void TFLiteProcessor::Instance::prepare() {
@@ -86,32 +102,30 @@ void TFLiteProcessor::Instance::prepare() {
 
 void TFLiteProcessor::Instance::process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) {
     for (size_t i = 0; i < m_inference_config.m_input_sizes.size(); i++) {
+        const float* input_data = m_input_data[i].data();
         if (i != m_inference_config.m_index_audio_data[Input]) {
-            for (size_t j = 0; j < m_input_data[i].size(); j++) {
-                m_input_data[i][j] = session->m_pp_processor.get_input(i, j);
-            }
+            session->get_input_tensor(m_input_data[i].data(), i);
+        } else if (input.is_view()) {
+            // The input points into the history of a mirrored ring buffer
+            input_data = input.data();
         } else {
             m_input_data[i].swap_data(input.get_memory_block());
             input.reset_channel_ptr();
+            input_data = m_input_data[i].data();
         }
         // TODO: Check if we can find a solution to avoid copying the data
-        TfLiteTensorCopyFromBuffer(m_inputs[i], m_input_data[i].data(), m_inference_config.m_input_sizes[i] * sizeof(float));
+        TfLiteTensorCopyFromBuffer(m_inputs[i], input_data, m_inference_config.m_input_sizes[i] * sizeof(float));
     }
 
     // Run inference
     TfLiteInterpreterInvoke(m_interpreter);
 
-    // We need to copy the data because we cannot access the data pointer ref of the tensor directly
+    // The interpreter owns the output tensors and the C API cannot bind them to external memory between invocations, so the audio output is copied in one block
     for (size_t i = 0; i < m_inference_config.m_output_sizes.size(); i++) {
-        float* output_read_ptr = (float*) TfLiteTensorData(m_outputs[i]);
         if (i != m_inference_config.m_index_audio_data[Output]) {
-            for (size_t j = 0; j < m_inference_config.m_output_sizes[i]; j++) {
-                session->m_pp_processor.set_output(output_read_ptr[j], i, j);
-            }
+            session->set_output_tensor((const float*) TfLiteTensorData(m_outputs[i]), i);
         } else {
-            for (size_t j = 0; j < m_inference_config.m_output_sizes[i]; j++) {
-                output.get_memory_block()[j] = output_read_ptr[j];
-            }
+            TfLiteTensorCopyToBuffer(m_outputs[i], output.data(), m_inference_config.m_output_sizes[i] * sizeof(float));
         }
     }
 }
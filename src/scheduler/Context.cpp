@@ -1,15 +1,27 @@
 #include <anira/scheduler/Context.h>
+#include <algorithm>
+#include <thread>
 
 namespace anira {
 
 Context::Context(const ContextConfig& context_config) {
     m_context_config = context_config;
+    // Applies to all buffers allocated from now on, so before any session is created
+    MemoryOptions::set_lock_memory(m_context_config.m_lock_memory);
+    MemoryOptions::set_use_huge_pages(m_context_config.m_use_huge_pages);
+    RealtimeLogger::start();
+    resolve_thread_cores();
+    m_next_inference.set_num_workers(m_context_config.m_num_threads);
+    std::lock_guard<std::mutex> lock(m_thread_pool_mutex);
     for (unsigned int i = 0; i < m_context_config.m_num_threads; ++i) {
-        m_thread_pool.emplace_back(std::make_unique<InferenceThread>(m_next_inference));
+        m_thread_pool.emplace_back(std::make_unique<InferenceThread>(m_next_inference, i));
+        m_thread_pool.back()->set_cpu_affinity(get_thread_cores(i));
     }
 }
 
-Context::~Context() {}
+Context::~Context() {
+    RealtimeLogger::stop();
+}
 
 std::shared_ptr<Context> Context::get_instance(const ContextConfig& context_config) {
     if (m_context == nullptr) {
@@ -25,6 +37,12 @@ std::shared_ptr<Context> Context::get_instance(const ContextConfig& context_conf
         if (m_context->m_context_config.m_use_controlled_blocking != context_config.m_use_controlled_blocking) {
             std::cerr << "[ERROR] Context already initialized with with different controlled blocking option!" << std::endl;
         }
+        if (m_context->m_context_config.m_thread_cores != context_config.m_thread_cores || m_context->m_context_config.m_excluded_cores != context_config.m_excluded_cores || m_context->m_context_config.m_numa_node != context_config.m_numa_node) {
+            std::cerr << "[ERROR] Context already initialized with different thread affinity options!" << std::endl;
+        }
+        if (m_context->m_context_config.m_lock_memory != context_config.m_lock_memory || m_context->m_context_config.m_use_huge_pages != context_config.m_use_huge_pages) {
+            std::cerr << "[ERROR] Context already initialized with different memory options!" << std::endl;
+        }
         if ((unsigned int) m_context->m_thread_pool.size() > context_config.m_num_threads) {
             m_context->new_num_threads(context_config.m_num_threads);
             m_context->m_context_config.m_num_threads = context_config.m_num_threads;
@@ -46,14 +64,53 @@ int Context::get_available_session_id() {
     return m_next_id.load();
 }
 
+void Context::resolve_thread_cores() {
+    m_thread_cores.clear();
+    if (m_context_config.m_thread_cores.empty() && m_context_config.m_excluded_cores.empty() && m_context_config.m_numa_node < 0) {
+        return;
+    }
+
+    std::vector<int> cores = m_context_config.m_thread_cores.empty() ? CpuAffinity::get_online_cores() : m_context_config.m_thread_cores;
+    auto remove_cores = [&cores](const std::vector<int>& to_remove, bool keep) {
+        cores.erase(std::remove_if(cores.begin(), cores.end(), [&](int core) {
+            return (std::find(to_remove.begin(), to_remove.end(), core) != to_remove.end()) != keep;
+        }), cores.end());
+    };
+
+    if (m_context_config.m_numa_node >= 0) {
+        remove_cores(CpuAffinity::get_numa_node_cores(m_context_config.m_numa_node), true);
+    }
+    // The context may be created on any thread, so the cores of the audio thread are only known from the config
+    remove_cores(m_context_config.m_excluded_cores, false);
+
+    if (cores.empty()) {
+        std::cout << "[WARNING] No cores left for the inference threads with the given affinity options. The threads are not pinned." << std::endl;
+        return;
+    }
+    m_thread_cores = cores;
+}
+
+std::vector<int> Context::get_thread_cores(unsigned int thread_index) {
+    // Explicitly listed cores are often isolated, where the kernel does not balance threads between them, so every thread gets its own core
+    if (!m_context_config.m_thread_cores.empty() && !m_thread_cores.empty()) {
+        return {m_thread_cores[thread_index % m_thread_cores.size()]};
+    }
+    return m_thread_cores;
+}
+
 void Context::new_num_threads(unsigned int new_num_threads) {
+    std::lock_guard<std::mutex> lock(m_thread_pool_mutex);
     unsigned int current_num_threads = (unsigned int) m_thread_pool.size();
 
     if (new_num_threads > current_num_threads) {
+        m_next_inference.set_num_workers(new_num_threads);
         for (unsigned int i = current_num_threads; i < new_num_threads; ++i) {
-            m_thread_pool.emplace_back(std::make_unique<InferenceThread>(m_next_inference));
+            m_thread_pool.emplace_back(std::make_unique<InferenceThread>(m_next_inference, i));
+            m_thread_pool.back()->set_cpu_affinity(get_thread_cores(i));
         }
     } else if (new_num_threads < current_num_threads) {
+        // New inferences only go to the remaining workers, those still queued for the stopped workers get stolen
+        m_next_inference.set_num_workers(new_num_threads);
         for (unsigned int i = current_num_threads - 1; i >= new_num_threads; --i) {
             m_thread_pool[i]->stop();
             while (m_thread_pool[i]->is_running()) {
@@ -61,6 +118,8 @@ void Context::new_num_threads(unsigned int new_num_threads) {
             }
             m_thread_pool.pop_back();
         }
+        // The inferences left in the queues of the stopped workers are stolen by the parked ones
+        m_next_inference.notify_all();
     }
 }
 
@@ -79,21 +138,23 @@ std::shared_ptr<SessionElement> Context::create_session(PrePostProcessor& pp_pro
     }
 
 #ifdef USE_LIBTORCH
-    set_processor(session, inference_config, m_libtorch_processors, InferenceBackend::LIBTORCH);
+    set_processor(session, session->m_inference_config, m_libtorch_processors, InferenceBackend::LIBTORCH);
 #endif
 #ifdef USE_ONNXRUNTIME
-    set_processor(session, inference_config, m_onnx_processors, InferenceBackend::ONNX);
+    set_processor(session, session->m_inference_config, m_onnx_processors, InferenceBackend::ONNX);
 #endif
 #ifdef USE_TFLITE
-    set_processor(session, inference_config, m_tflite_processors, InferenceBackend::TFLITE);
+    set_processor(session, session->m_inference_config, m_tflite_processors, InferenceBackend::TFLITE);
 #endif
 
     m_sessions.emplace_back(session);
+    update_shared_processors();
 
     return m_sessions.back();
 }
 
 void Context::release_thread_pool() {
+    std::lock_guard<std::mutex> lock(m_thread_pool_mutex);
     m_thread_pool.clear();
 }
 
@@ -104,18 +165,10 @@ void Context::release_session(std::shared_ptr<SessionElement> session) {
         std::this_thread::sleep_for(std::chrono::microseconds(50));
     }
 
-    std::vector<InferenceData> inference_stack;
-    InferenceData inference_data;
-    while (m_next_inference.try_dequeue(inference_data)) {
-        if (inference_data.m_session != session) {
-            inference_stack.emplace_back(inference_data);
-        }
-    }
+    m_next_inference.remove_session(session);
 
-    for (auto& inference_data : inference_stack) {
-        if (!m_next_inference.try_enqueue(inference_data)) {
-            std::cerr << "[ERROR] Could not requeue inference data!" << std::endl;
-        }
+    for (BackendBase* processor : get_session_processors(session)) {
+        processor->release_session(session->m_session_id);
     }
 
     InferenceConfig inference_config = session->m_inference_config;
@@ -135,6 +188,7 @@ void Context::release_session(std::shared_ptr<SessionElement> session) {
             break;
         }
     }
+    update_shared_processors();
 
 #ifdef USE_LIBTORCH
     release_processor(inference_config, m_libtorch_processors, libtorch_processor);
@@ -154,29 +208,68 @@ void Context::release_session(std::shared_ptr<SessionElement> session) {
     }
 }
 
-void Context::prepare(std::shared_ptr<SessionElement> session, HostAudioConfig new_config) {
+std::shared_ptr<BackendBase> Context::create_processor([[maybe_unused]] InferenceConfig& inference_config, [[maybe_unused]] InferenceBackend backend) {
+    std::shared_ptr<BackendBase> processor = nullptr;
+#ifdef USE_LIBTORCH
+    if (backend == LIBTORCH) {
+        processor = std::make_shared<LibtorchProcessor>(inference_config);
+    }
+#endif
+#ifdef USE_ONNXRUNTIME
+    if (backend == ONNX) {
+        processor = std::make_shared<OnnxRuntimeProcessor>(inference_config);
+    }
+#endif
+#ifdef USE_TFLITE
+    if (backend == TFLITE) {
+        processor = std::make_shared<TFLiteProcessor>(inference_config);
+    }
+#endif
+    if (processor != nullptr) {
+        processor->prepare();
+    }
+    return processor;
+}
+
+void Context::reset_processors(std::shared_ptr<SessionElement> session, [[maybe_unused]] InferenceConfig& previous_config) {
     session->m_initialized.store(false);
 
     while (session->m_active_inferences.load(std::memory_order::acquire) != 0) {
         std::this_thread::sleep_for(std::chrono::microseconds(50));
     }
 
-    std::vector<InferenceData> inference_stack;
-    InferenceData inference_data;
-    while (m_next_inference.try_dequeue(inference_data)) {
-        if (inference_data.m_session != session) {
-            inference_stack.emplace_back(inference_data);
-        }
-    }
+#ifdef USE_LIBTORCH
+    std::shared_ptr<LibtorchProcessor> libtorch_processor = session->m_libtorch_processor;
+    release_processor(previous_config, m_libtorch_processors, libtorch_processor);
+    set_processor(session, session->m_inference_config, m_libtorch_processors, InferenceBackend::LIBTORCH);
+#endif
+#ifdef USE_ONNXRUNTIME
+    std::shared_ptr<OnnxRuntimeProcessor> onnx_processor = session->m_onnx_processor;
+    release_processor(previous_config, m_onnx_processors, onnx_processor);
+    set_processor(session, session->m_inference_config, m_onnx_processors, InferenceBackend::ONNX);
+#endif
+#ifdef USE_TFLITE
+    std::shared_ptr<TFLiteProcessor> tflite_processor = session->m_tflite_processor;
+    release_processor(previous_config, m_tflite_processors, tflite_processor);
+    set_processor(session, session->m_inference_config, m_tflite_processors, InferenceBackend::TFLITE);
+#endif
+    update_shared_processors();
+}
 
-    for (auto& inference_data : inference_stack) {
-        if (!m_next_inference.try_enqueue(inference_data)) {
-            std::cerr << "[ERROR] Could not requeue inference data!" << std::endl;
-        }
+void Context::prepare(std::shared_ptr<SessionElement> session, HostAudioConfig new_config, int latency) {
+    session->m_initialized.store(false);
+
+    while (session->m_active_inferences.load(std::memory_order::acquire) != 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
     }
 
+    m_next_inference.remove_session(session);
+
     session->clear();
-    session->prepare(new_config);
+    session->prepare(new_config, latency);
+    for (BackendBase* processor : get_session_processors(session)) {
+        processor->prepare_session(*session);
+    }
 
     if (!new_config.m_submit_task_to_host_thread) {
         m_context_config.m_use_host_threads = false;
@@ -193,11 +286,48 @@ void Context::prepare(std::shared_ptr<SessionElement> session, HostAudioConfig n
     }
 }
 
+void Context::calibrate(std::shared_ptr<SessionElement> session, unsigned int num_runs) {
+    session->m_calibrating.store(true);
+    std::shared_ptr<SessionElement::ThreadSafeStruct> thread_safe_struct = session->m_inference_queue[0];
+    for (unsigned int i = 0; i < num_runs; ++i) {
+        thread_safe_struct->m_free.store(false);
+        auto now = std::chrono::steady_clock::now();
+        InferenceData inference_data = {session, thread_safe_struct, now + session->m_inference_budget, now};
+        if (!m_next_inference.try_enqueue(inference_data)) {
+            std::cerr << "[ERROR] Could not enqueue calibration inference!" << std::endl;
+            thread_safe_struct->m_free.store(true);
+            break;
+        }
+        if (session->m_host_config.m_submit_task_to_host_thread && m_host_threads_active.load()) {
+            session->m_host_config.m_submit_task_to_host_thread(1);
+        }
+#ifdef USE_CONTROLLED_BLOCKING
+        thread_safe_struct->m_done.acquire();
+#else
+        while (!thread_safe_struct->m_done.exchange(false)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+#endif
+        thread_safe_struct->m_free.store(true);
+    }
+    // The calibration inferences must not leave anything in the recurrent state
+    for (auto& state : session->m_states) {
+        state.clear();
+    }
+    session->m_calibrating.store(false);
+}
+
 void Context::new_data_submitted(std::shared_ptr<SessionElement> session) {
     // TODO: We assume that the model_output_size gives us the amount of new samples that we need to process. This can differ from the model_input_size because we might need to add some padding or past samples. Find a better way to determine the amount of new samples.
     int new_samples_needed_for_inference = session->m_inference_config.m_output_sizes[session->m_inference_config.m_index_audio_data[Output]] / session->m_inference_config.m_num_audio_channels[Output];
-    while (session->m_send_buffer.get_available_samples(0) >= (new_samples_needed_for_inference)) {
-        bool success = pre_process(session);
+    bool offload_pre_post_processing = session->m_inference_config.m_offload_pre_post_processing;
+    // When offloading, the inference threads consume the send buffer, so we count the samples that are not yet claimed by an inference instead
+    while ((offload_pre_post_processing ? session->m_num_pending_samples : session->m_send_buffer.get_available_samples(0)) >= (size_t) new_samples_needed_for_inference) {
+        bool success = offload_pre_post_processing ? submit_inference(session) : pre_process(session);
+
+        if (success && offload_pre_post_processing) {
+            session->m_num_pending_samples -= (size_t) new_samples_needed_for_inference;
+        }
 
         if (success && session->m_host_config.m_submit_task_to_host_thread && m_host_threads_active.load()) {
             bool host_exec_success = session->m_host_config.m_submit_task_to_host_thread(1);
@@ -212,26 +342,48 @@ void Context::new_data_submitted(std::shared_ptr<SessionElement> session) {
 
         // !success means that there is no free m_inference_queue
         if (!success) {
-            for (size_t channel = 0; channel < session->m_inference_config.m_num_audio_channels[Input]; channel++) {
-                for (size_t i = 0; i < new_samples_needed_for_inference; i++) {
-                    session->m_send_buffer.pop_sample(channel);
+            // When rendering offline nothing is dropped, we sleep until an inference finished and its struct is free again
+            if (session->m_non_realtime) {
+                size_t num_finished = session->m_num_finished_inferences.load(std::memory_order::acquire);
+                new_data_request(session, 0.);
+                if (!has_free_struct(session)) {
+                    session->wait_for_inference(num_finished);
                 }
+                continue;
+            }
+            // Only the inference threads may consume the send buffer and fill the receive buffer, so the samples wait for the next call
+            if (offload_pre_post_processing) {
+                break;
+            }
+            for (size_t channel = 0; channel < session->m_inference_config.m_num_audio_channels[Input]; channel++) {
+                session->m_send_buffer.discard_block(channel, new_samples_needed_for_inference);
             }
             for (size_t channel = 0; channel < session->m_inference_config.m_num_audio_channels[Output]; channel++) {
-                for (size_t i = 0; i < new_samples_needed_for_inference; i++) {
-                    session->m_receive_buffer.push_sample(channel, 0.f);
-                }
+                session->m_receive_buffer.push_zeros(channel, new_samples_needed_for_inference);
             }
         }
     }
 }
 
+bool Context::has_free_struct(std::shared_ptr<SessionElement> session) {
+    for (auto& thread_safe_struct : session->m_inference_queue) {
+        if (thread_safe_struct->m_free.load(std::memory_order::acquire)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void Context::new_data_request(std::shared_ptr<SessionElement> session, double buffer_size_in_sec) {
 #ifdef USE_CONTROLLED_BLOCKING
     auto timeToProcess = std::chrono::microseconds(static_cast<long>(buffer_size_in_sec * 1e6 * session->m_inference_config.m_wait_in_process_block));
     auto currentTime = std::chrono::system_clock::now();
     auto waitUntil = currentTime + timeToProcess;
 #endif
+    // The inference threads push the results to the receive buffer themselves
+    if (session->m_inference_config.m_offload_pre_post_processing) {
+        return;
+    }
     while (session->m_time_stamps.size() > 0) {
         for (size_t i = 0; i < session->m_inference_queue.size(); ++i) {
             if (session->m_inference_queue[i]->m_time_stamp == session->m_time_stamps.back()) {
@@ -265,15 +417,26 @@ std::vector<std::shared_ptr<SessionElement>>& Context::get_sessions() {
     return m_sessions;
 }
 
+std::vector<std::chrono::nanoseconds> Context::get_worker_busy_times() {
+    std::vector<std::chrono::nanoseconds> busy_times;
+    std::lock_guard<std::mutex> lock(m_thread_pool_mutex);
+    for (auto& thread : m_thread_pool) {
+        busy_times.push_back(thread->get_busy_time());
+    }
+    return busy_times;
+}
+
 bool Context::pre_process(std::shared_ptr<SessionElement> session) {
     for (size_t i = 0; i < session->m_inference_queue.size(); ++i) {
         if (session->m_inference_queue[i]->m_free.exchange(false)) {
             session->m_pp_processor.pre_process(session->m_send_buffer, session->m_inference_queue[i]->m_processed_model_input, session->m_currentBackend.load(std::memory_order_relaxed));
             session->m_time_stamps.insert(session->m_time_stamps.begin(), session->m_current_queue);
+            session->start_model_swaps(session->m_current_queue);
             session->m_inference_queue[i]->m_time_stamp = session->m_current_queue;
-            InferenceData inference_data = {session, session->m_inference_queue[i]};
+            auto now = std::chrono::steady_clock::now();
+            InferenceData inference_data = {session, session->m_inference_queue[i], now + session->m_inference_budget, now};
             if (!m_next_inference.try_enqueue(inference_data)) {
-                std::cerr << "[ERROR] Could not enqueue next inference!" << std::endl;
+                RealtimeLogger::log(LogLevel::Error, "Could not enqueue next inference", session->m_session_id);
                 session->m_inference_queue[i]->m_free.exchange(true);
                 session->m_time_stamps.pop_back();
                 return false;
@@ -286,7 +449,25 @@ bool Context::pre_process(std::shared_ptr<SessionElement> session) {
             return true;
         }
     }
-    std::cout << "[WARNING] No free inference queue found in session: " << session->m_session_id << "!" << std::endl;
+    RealtimeLogger::log(LogLevel::Warning, "No free inference queue found", session->m_session_id);
+    return false;
+}
+
+bool Context::submit_inference(std::shared_ptr<SessionElement> session) {
+    for (size_t i = 0; i < session->m_inference_queue.size(); ++i) {
+        if (session->m_inference_queue[i]->m_free.exchange(false)) {
+            session->m_inference_queue[i]->m_pre_processed = false;
+            auto now = std::chrono::steady_clock::now();
+            InferenceData inference_data = {session, session->m_inference_queue[i], now + session->m_inference_budget, now};
+            if (!m_next_inference.try_enqueue(inference_data)) {
+                RealtimeLogger::log(LogLevel::Error, "Could not enqueue next inference", session->m_session_id);
+                session->m_inference_queue[i]->m_free.store(true, std::memory_order::release);
+                return false;
+            }
+            return true;
+        }
+    }
+    RealtimeLogger::log(LogLevel::Warning, "No free inference queue found", session->m_session_id);
     return false;
 }
 
@@ -296,6 +477,7 @@ void Context::post_process(std::shared_ptr<SessionElement> session, std::shared_
 }
 
 void Context::start_thread_pool() {
+    std::lock_guard<std::mutex> lock(m_thread_pool_mutex);
     if (!m_context->m_context_config.m_use_host_threads) {
         for (size_t i = 0; i < m_thread_pool.size(); ++i) {
             if (!m_thread_pool[i]->is_running()) {
@@ -308,6 +490,34 @@ void Context::start_thread_pool() {
     }
 }
 
+void Context::update_shared_processors() {
+    for (auto& session : m_sessions) {
+        for (size_t backend = 0; backend < SessionElement::NUM_BACKENDS; ++backend) {
+            BackendBase* processor = session->get_processor((InferenceBackend) backend);
+            bool shared = std::any_of(m_sessions.begin(), m_sessions.end(), [&](const std::shared_ptr<SessionElement>& other) {
+                return other != session && processor != nullptr && other->get_processor((InferenceBackend) backend) == processor;
+            });
+            session->m_shares_processor[backend].store(shared, std::memory_order_relaxed);
+        }
+    }
+}
+
+std::vector<BackendBase*> Context::get_session_processors(std::shared_ptr<SessionElement> session) {
+    std::vector<BackendBase*> processors;
+    for (size_t backend = 0; backend < SessionElement::NUM_BACKENDS; ++backend) {
+        BackendBase* processor = session->get_processor((InferenceBackend) backend);
+        if (processor != nullptr) {
+            processors.push_back(processor);
+        }
+        // The session is idle, so the swap and its processors stay in place
+        SessionElement::ModelSwap* model_swap = session->m_model_swaps[backend].load(std::memory_order::acquire);
+        if (model_swap != nullptr && model_swap->m_processor != nullptr) {
+            processors.push_back(model_swap->m_processor.get());
+        }
+    }
+    return processors;
+}
+
 int Context::get_num_sessions() {
     return m_active_sessions.load();
 }
@@ -315,7 +525,8 @@ int Context::get_num_sessions() {
 template <typename T> void Context::set_processor(std::shared_ptr<SessionElement> session, InferenceConfig& inference_config, std::vector<std::shared_ptr<T>>& processors, anira::InferenceBackend backend) {
     for (auto model_data : inference_config.m_model_data) {
         if (model_data.m_backend == backend) {
-            if (!inference_config.m_session_exclusive_processor) {
+            // A session that selects its chunk size resizes the tensors of its processors, so they are not shared
+            if (!inference_config.m_session_exclusive_processor && inference_config.m_chunk_sizes.empty()) {
                 for (auto processor : processors) {
                     if (processor->m_inference_config == inference_config) {
                         session->set_processor(processor);
@@ -334,7 +545,7 @@ template <typename T> void Context::release_processor(InferenceConfig& inference
     if (processor == nullptr) {
         return;
     }
-    if (!inference_config.m_session_exclusive_processor) {
+    if (!inference_config.m_session_exclusive_processor && inference_config.m_chunk_sizes.empty()) {
         for (auto session : m_sessions) {
             if (session->m_inference_config == inference_config) {
                 return;
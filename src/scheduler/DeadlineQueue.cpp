@@ -0,0 +1,96 @@
+#include <anira/scheduler/DeadlineQueue.h>
+#include <bit>
+#include <limits>
+
+namespace anira {
+
+DeadlineQueue::DeadlineQueue(size_t capacity) :
+    m_slots(capacity),
+    m_free_slots(capacity),
+    m_filled_slots((capacity + BITS_PER_WORD - 1) / BITS_PER_WORD)
+{
+}
+
+bool DeadlineQueue::try_push(InferenceData inference_data) {
+    size_t index;
+    if (!m_free_slots.try_acquire(index)) {
+        return false;
+    }
+    Slot& slot = m_slots[index];
+    slot.m_deadline.store(inference_data.m_deadline.time_since_epoch().count(), std::memory_order_relaxed);
+    slot.m_inference_data = std::move(inference_data);
+    m_size.fetch_add(1, std::memory_order_relaxed);
+    // Publishes the slot, the consumers acquire the word before they read the deadline and the data
+    m_filled_slots[index / BITS_PER_WORD].fetch_or(uint64_t(1) << (index % BITS_PER_WORD), std::memory_order_release);
+    return true;
+}
+
+bool DeadlineQueue::try_dequeue(InferenceData& inference_data) {
+    // Idle threads poll this method, so we only scan the slots when there is something to take
+    if (m_size.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+
+    while (true) {
+        size_t earliest_index = m_slots.size();
+        int64_t earliest_deadline = std::numeric_limits<int64_t>::max();
+        for (size_t i = 0; i < m_filled_slots.size(); ++i) {
+            uint64_t word = m_filled_slots[i].load(std::memory_order_acquire);
+            while (word != 0) {
+                size_t index = i * BITS_PER_WORD + (size_t) std::countr_zero(word);
+                int64_t deadline = m_slots[index].m_deadline.load(std::memory_order_relaxed);
+                if (deadline < earliest_deadline) {
+                    earliest_deadline = deadline;
+                    earliest_index = index;
+                }
+                word &= word - 1;
+            }
+        }
+        if (earliest_index == m_slots.size()) {
+            return false;
+        }
+
+        // Only the consumer that clears the bit owns the slot. If another one was faster, we look for the next earliest deadline.
+        uint64_t bit = uint64_t(1) << (earliest_index % BITS_PER_WORD);
+        if (m_filled_slots[earliest_index / BITS_PER_WORD].fetch_and(~bit, std::memory_order::acquire) & bit) {
+            // Moving leaves the shared pointers of the slot empty, so the producers never release a session or struct when they refill it
+            inference_data = std::move(m_slots[earliest_index].m_inference_data);
+            m_size.fetch_sub(1, std::memory_order_release);
+            m_free_slots.release(earliest_index);
+            return true;
+        }
+    }
+}
+
+void DeadlineQueue::remove_session(std::shared_ptr<SessionElement> session) {
+    for (size_t i = 0; i < m_filled_slots.size(); ++i) {
+        uint64_t word = m_filled_slots[i].load(std::memory_order_acquire);
+        while (word != 0) {
+            size_t index = i * BITS_PER_WORD + (size_t) std::countr_zero(word);
+            uint64_t bit = uint64_t(1) << (index % BITS_PER_WORD);
+            word &= word - 1;
+            // The slot is owned while its bit is cleared, the consumers skip it meanwhile
+            if (!(m_filled_slots[i].fetch_and(~bit, std::memory_order::acquire) & bit)) {
+                continue;
+            }
+            Slot& slot = m_slots[index];
+            if (slot.m_inference_data.m_session == session) {
+                slot.m_inference_data = InferenceData();
+                m_size.fetch_sub(1, std::memory_order_release);
+                m_free_slots.release(index);
+            } else {
+                m_filled_slots[i].fetch_or(bit, std::memory_order_release);
+            }
+        }
+    }
+}
+
+size_t DeadlineQueue::size_approx() const {
+    return m_size.load(std::memory_order_acquire);
+}
+
+size_t DeadlineQueue::get_capacity() const {
+    return m_slots.size();
+}
+
+} // namespace anira
@@ -1,18 +1,31 @@
 #include <anira/scheduler/InferenceManager.h>
+#include <algorithm>
+#include <numeric>
 
 namespace anira {
 
 InferenceManager::InferenceManager(PrePostProcessor& pp_processor, InferenceConfig& inference_config, BackendBase* custom_processor, const ContextConfig& context_config) :
     m_context(Context::get_instance(context_config)),
     m_session(m_context->create_session(pp_processor, inference_config, custom_processor)),
-    m_inference_config(inference_config)
+    m_inference_config(m_session->m_inference_config),
+    m_configured_chunk_size(inference_config.get_chunk_size())
 {
 }
 
 InferenceManager::~InferenceManager() {
+    stop_latency_monitor();
+    stop_model_swap();
     m_context->release_session(m_session);
 }
 
+void InferenceManager::set_non_realtime(bool non_realtime) {
+    m_non_realtime = non_realtime;
+}
+
+bool InferenceManager::is_non_realtime() const {
+    return m_session->m_non_realtime;
+}
+
 void InferenceManager::set_backend(InferenceBackend new_inference_backend) {
     m_session->m_currentBackend.store(new_inference_backend, std::memory_order_relaxed);
 }
@@ -22,21 +35,199 @@ InferenceBackend InferenceManager::get_backend() const {
 }
 
 void InferenceManager::prepare(HostAudioConfig new_config) {
+    stop_latency_monitor();
+    stop_model_swap();
     m_spec = new_config;
+    m_session->m_non_realtime = m_non_realtime;
+    m_inference_time = m_inference_config.m_max_inference_time;
+    prepare_resamplers();
 
-    m_context->prepare(m_session, m_spec);
+    // Offline the latency does not depend on the chunk size, so the tensors keep their shapes. Only a session that copied the config at its creation resizes them.
+    if (m_session->m_chunk_config != nullptr && !m_session->m_non_realtime) {
+        select_chunk_size();
+    }
+
+    if (m_inference_config.m_calibration_runs > 0) {
+        // The model can only run on the thread pool once the session is prepared, so we prepare it with the configured inference time first
+        prepare_session();
+        m_context->calibrate(m_session, m_inference_config.m_calibration_runs);
+        float calibrated_inference_time = calculate_inference_time(m_session->m_inference_time);
+        if (calibrated_inference_time > 0.f) {
+            m_inference_time = calibrated_inference_time;
+        }
+        reset_stats();
+    }
+
+    prepare_session();
+
+    // The session was idle while it was prepared, so no inference uses the previous processors or the replaced swaps anymore
+    release_previous_processors();
+    m_retired_model_swaps.clear();
 
     m_inference_counter.store(0);
 
-    m_init_samples = calculate_latency();
     for (size_t i = 0; i < m_inference_config.m_num_audio_channels[Output]; ++i) {
-        for (size_t j = 0; j < m_init_samples; ++j) {
-            m_session->m_receive_buffer.push_sample(i, 0.f);
+        m_session->m_receive_buffer.push_zeros(i, m_model_latency);
+    }
+
+    if (m_session->m_non_realtime) {
+        prepare_non_realtime();
+    }
+
+    // Offline the latency does not depend on the inference time
+    if (m_latency_change_callback && !m_session->m_non_realtime) {
+        start_latency_monitor();
+    }
+}
+
+void InferenceManager::prepare_session() {
+    // The latency is needed to size the buffers of the session
+    m_init_samples = calculate_latency(m_inference_time);
+    m_model_latency = calculate_model_latency(m_inference_time);
+    m_session->m_inference_budget = std::chrono::nanoseconds(static_cast<long long>(calculate_inference_caused_latency(m_inference_time) * 1e9 / m_spec.m_host_sample_rate));
+    m_session->m_expected_inference_time = std::chrono::nanoseconds(static_cast<long long>(m_inference_time * 1e6));
+
+    m_context->prepare(m_session, m_model_spec, m_model_latency);
+}
+
+void InferenceManager::prepare_non_realtime() {
+    m_non_realtime_input.resize(m_inference_config.m_num_audio_channels[Input]);
+    m_non_realtime_output.resize(m_inference_config.m_num_audio_channels[Output]);
+
+    // The send buffer keeps the past samples and the receive buffer the latency, the rest of both is free for the samples of the buffers in flight
+    size_t buffer_size = std::max<size_t>(m_model_spec.m_host_buffer_size, 1);
+    size_t send_samples = m_session->m_send_buffer.get_capacity() - 1;
+    size_t receive_samples = m_session->m_receive_buffer.get_capacity() - 1;
+    send_samples = send_samples > m_session->m_num_past_samples ? send_samples - m_session->m_num_past_samples : 0;
+    receive_samples = receive_samples > m_model_latency ? receive_samples - m_model_latency : 0;
+    m_num_non_realtime_buffers = std::max<size_t>(std::min(send_samples, receive_samples) / buffer_size, 1);
+}
+
+void InferenceManager::prepare_resamplers() {
+    m_model_spec = m_spec;
+    double model_sample_rate = m_inference_config.m_model_sample_rate;
+    m_resampling = model_sample_rate > 0. && std::abs(model_sample_rate - m_spec.m_host_sample_rate) > 1e-6;
+    if (!m_resampling) {
+        return;
+    }
+
+    size_t num_input_channels = m_inference_config.m_num_audio_channels[Input];
+    size_t num_output_channels = m_inference_config.m_num_audio_channels[Output];
+    if (!m_input_resampler.prepare(m_spec.m_host_sample_rate, model_sample_rate, num_input_channels, m_spec.m_host_buffer_size)) {
+        std::cerr << "[ERROR] Session " << m_session->m_session_id << " runs the model at the host sample rate!" << std::endl;
+        m_resampling = false;
+        return;
+    }
+    // The input resampler is never limited, so it produces at most this many model samples per host buffer
+    int64_t up = m_input_resampler.get_up_factor();
+    int64_t down = m_input_resampler.get_down_factor();
+    m_model_spec.m_host_buffer_size = (size_t) (((int64_t) m_spec.m_host_buffer_size * up + down - 1) / down);
+    m_model_spec.m_host_sample_rate = model_sample_rate;
+    m_output_resampler.prepare(model_sample_rate, m_spec.m_host_sample_rate, num_output_channels, m_model_spec.m_host_buffer_size);
+
+    m_resampled_input.resize(num_input_channels, m_input_resampler.get_max_num_output_samples(m_spec.m_host_buffer_size));
+    m_resampled_output.resize(num_output_channels, m_output_resampler.get_max_num_input_samples(m_spec.m_host_buffer_size));
+}
+
+void InferenceManager::select_chunk_size() {
+    InferenceBackend backend = m_session->m_currentBackend.load(std::memory_order_relaxed);
+    if (m_model_swaps[backend] != nullptr) {
+        std::cout << "[WARNING] Session " << m_session->m_session_id << " keeps its chunk size, since its model was swapped!" << std::endl;
+        return;
+    }
+
+    auto cached_selection = std::find_if(m_chunk_size_selections.begin(), m_chunk_size_selections.end(), [this, backend](const ChunkSizeSelection& selection) {
+        return selection.m_spec == m_spec && selection.m_backend == backend;
+    });
+    if (cached_selection != m_chunk_size_selections.end()) {
+        apply_chunk_size(cached_selection->m_chunk_size, cached_selection->m_inference_time);
+        return;
+    }
+
+    std::vector<size_t> chunk_sizes = m_inference_config.m_chunk_sizes;
+    std::sort(chunk_sizes.begin(), chunk_sizes.end());
+    float host_buffer_time = (float) m_spec.m_host_buffer_size * 1000.f / (float) m_spec.m_host_sample_rate;
+    size_t selected_chunk_size = 0;
+    float selected_inference_time = 0.f;
+    bool keeps_up = false;
+    for (size_t chunk_size : chunk_sizes) {
+        float inference_time = benchmark_chunk_size(chunk_size, backend);
+        if (inference_time < 0.f) {
+            continue;
+        }
+        selected_chunk_size = chunk_size;
+        selected_inference_time = inference_time;
+        // Like the inference caused latency, we assume that the inferences of a host buffer run one after another
+        if ((float) max_num_inferences((int) m_model_spec.m_host_buffer_size, (int) chunk_size) * inference_time <= host_buffer_time) {
+            keeps_up = true;
+            break;
         }
     }
+    if (selected_chunk_size == 0) {
+        std::cerr << "[ERROR] None of the chunk sizes could be benchmarked, using the tensor shapes of the config!" << std::endl;
+        apply_chunk_size(m_configured_chunk_size, m_inference_config.m_max_inference_time);
+        return;
+    }
+    if (!keeps_up) {
+        std::cout << "[WARNING] No chunk size keeps up with the host buffer, using the largest one!" << std::endl;
+    }
+    m_chunk_size_selections.push_back({m_spec, backend, selected_chunk_size, selected_inference_time});
+    apply_chunk_size(selected_chunk_size, selected_inference_time);
+}
+
+void InferenceManager::apply_chunk_size(size_t chunk_size, float inference_time) {
+    if (chunk_size != m_inference_config.get_chunk_size()) {
+        InferenceConfig previous_config = m_inference_config;
+        m_inference_config.set_chunk_size(chunk_size);
+        m_context->reset_processors(m_session, previous_config);
+    }
+    // The configured inference time belongs to the original shapes
+    m_inference_time = inference_time;
+}
+
+float InferenceManager::benchmark_chunk_size(size_t chunk_size, InferenceBackend backend) {
+    InferenceConfig chunk_config = m_inference_config;
+    if (!chunk_config.set_chunk_size(chunk_size)) {
+        std::cerr << "[ERROR] The tensor shapes cannot be resized to the chunk size " << chunk_size << "!" << std::endl;
+        return -1.f;
+    }
+    // One instance and the untimed inference below are enough to time the model, the session builds and warms up its processors once the chunk size is selected
+    chunk_config.m_num_parallel_processors = 1;
+    chunk_config.m_warm_up = 0;
+
+    // A custom processor is handed the buffers of the chunk size and has to handle them
+    std::shared_ptr<BackendBase> processor = nullptr;
+    BackendBase* chunk_processor = m_session->m_custom_processor;
+    if (backend != CUSTOM) {
+        processor = m_context->create_processor(chunk_config, backend);
+        chunk_processor = processor.get();
+    }
+    if (chunk_processor == nullptr) {
+        std::cerr << "[ERROR] No processor for the chunk size " << chunk_size << ", its backend is not enabled!" << std::endl;
+        return -1.f;
+    }
+
+    size_t num_input_channels = chunk_config.m_num_audio_channels[Input];
+    size_t num_output_channels = chunk_config.m_num_audio_channels[Output];
+    AudioBufferF input(num_input_channels, chunk_config.m_input_sizes[chunk_config.m_index_audio_data[Input]] / num_input_channels);
+    AudioBufferF output(num_output_channels, chunk_config.m_output_sizes[chunk_config.m_index_audio_data[Output]] / num_output_channels);
+    input.clear();
+    chunk_processor->process(input, output, m_session);
+
+    LatencyHistogram histogram;
+    for (unsigned int i = 0; i < CHUNK_SIZE_BENCHMARK_RUNS; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        chunk_processor->process(input, output, m_session);
+        histogram.record(std::chrono::steady_clock::now() - start);
+    }
+    return calculate_inference_time(histogram);
 }
 
 void InferenceManager::process(const float* const* input_data, float* const* output_data, size_t num_samples) {
+    if (m_session->m_non_realtime) {
+        process_non_realtime(input_data, output_data, num_samples);
+        return;
+    }
     process_input(input_data, num_samples);
 
     m_context->new_data_submitted(m_session);
@@ -46,39 +237,89 @@ void InferenceManager::process(const float* const* input_data, float* const* out
     process_output(output_data, num_samples);
 }
 
+void InferenceManager::process_non_realtime(const float* const* input_data, float* const* output_data, size_t num_samples) {
+    size_t buffer_size = m_spec.m_host_buffer_size;
+    size_t input_offset = 0;
+
+    // The resamplers are sized for the host buffer size, so larger blocks are rendered in pieces of that size. As many pieces as the ring buffers hold are submitted ahead, so their inferences are spread over the thread pool while we wait for the oldest one.
+    for (size_t output_offset = 0; output_offset < num_samples; output_offset += buffer_size) {
+        while (input_offset < num_samples && input_offset < output_offset + m_num_non_realtime_buffers * buffer_size) {
+            size_t num_piece_samples = std::min(num_samples - input_offset, buffer_size);
+            for (size_t channel = 0; channel < m_non_realtime_input.size(); ++channel) {
+                m_non_realtime_input[channel] = input_data[channel] + input_offset;
+            }
+            process_input(m_non_realtime_input.data(), num_piece_samples);
+            input_offset += num_piece_samples;
+        }
+        m_context->new_data_submitted(m_session);
+
+        // The latency only covers the buffer adaptation, so the results of the submitted inferences suffice
+        size_t num_piece_samples = std::min(num_samples - output_offset, buffer_size);
+        size_t num_model_samples = m_resampling ? m_output_resampler.get_num_input_samples(num_piece_samples) : num_piece_samples;
+        while (m_session->m_receive_buffer.get_available_samples() < num_model_samples) {
+            size_t num_finished = m_session->m_num_finished_inferences.load(std::memory_order::acquire);
+            m_context->new_data_request(m_session, 0.);
+            if (m_session->m_receive_buffer.get_available_samples() < num_model_samples) {
+                m_session->wait_for_inference(num_finished);
+            }
+        }
+        for (size_t channel = 0; channel < m_non_realtime_output.size(); ++channel) {
+            m_non_realtime_output[channel] = output_data[channel] + output_offset;
+        }
+        process_output(m_non_realtime_output.data(), num_piece_samples);
+    }
+}
+
 void InferenceManager::process_input(const float* const* input_data, size_t num_samples) {
+    if (m_resampling) {
+        num_samples = m_input_resampler.process(input_data, num_samples, m_resampled_input.get_array_of_write_pointers());
+        input_data = m_resampled_input.get_array_of_read_pointers();
+    }
+    // Only happens when the inferences cannot keep up for a long time, the pending samples are then dropped instead of overwriting the past samples
+    if (m_session->m_send_buffer.get_free_samples(0) < num_samples + m_session->m_num_past_samples) {
+        RealtimeLogger::log(LogLevel::Warning, "Send buffer overflow", m_session->m_session_id);
+        return;
+    }
     for (size_t channel = 0; channel < m_inference_config.m_num_audio_channels[Input]; ++channel) {
-        for (size_t sample = 0; sample < num_samples; ++sample) {
-            m_session->m_send_buffer.push_sample(channel, input_data[channel][sample]);
-        }
+        m_session->m_send_buffer.push_block(channel, input_data[channel], num_samples);
+    }
+    if (m_inference_config.m_offload_pre_post_processing) {
+        m_session->m_num_pending_samples += num_samples;
     }
 }
 
-void InferenceManager::process_output(float* const* output_data, size_t num_samples) {    
+void InferenceManager::process_output(float* const* output_data, size_t num_samples) {
+    // The receive buffer holds samples at the model sample rate
+    size_t num_model_samples = m_resampling ? m_output_resampler.get_num_input_samples(num_samples) : num_samples;
     while (m_inference_counter.load() > 0) {
-        if (m_session->m_receive_buffer.get_available_samples(0) >= 2 * (size_t) num_samples) {
+        if (m_session->m_receive_buffer.get_available_samples(0) >= 2 * num_model_samples) {
             for (size_t channel = 0; channel < m_inference_config.m_num_audio_channels[Output]; ++channel) {
-                for (size_t sample = 0; sample < num_samples; ++sample) {
-                    m_session->m_receive_buffer.pop_sample(channel);
-                }
+                m_session->m_receive_buffer.discard_block(channel, num_model_samples);
             }
             m_inference_counter.fetch_sub(1);
-            std::cout << "[WARNING] Catch up samples in session: " << m_session->m_session_id << "!" << std::endl;
+            m_num_caught_up_blocks.fetch_add(1, std::memory_order_relaxed);
+            RealtimeLogger::log(LogLevel::Warning, "Catch up samples", m_session->m_session_id);
         }
         else {
             break;
         }
     }
-    if (m_session->m_receive_buffer.get_available_samples(0) >= (size_t) num_samples) {
-        for (size_t channel = 0; channel < m_inference_config.m_num_audio_channels[Output]; ++channel) {
-            for (size_t sample = 0; sample < num_samples; ++sample) {
-                output_data[channel][sample] = m_session->m_receive_buffer.pop_sample(channel);
+    if (m_session->m_receive_buffer.get_available_samples(0) >= num_model_samples) {
+        if (m_resampling) {
+            for (size_t channel = 0; channel < m_inference_config.m_num_audio_channels[Output]; ++channel) {
+                m_session->m_receive_buffer.pop_block(channel, m_resampled_output.get_write_pointer(channel), num_model_samples);
+            }
+            m_output_resampler.process(m_resampled_output.get_array_of_read_pointers(), num_model_samples, output_data, num_samples);
+        } else {
+            for (size_t channel = 0; channel < m_inference_config.m_num_audio_channels[Output]; ++channel) {
+                m_session->m_receive_buffer.pop_block(channel, output_data[channel], num_samples);
             }
         }
     } else {
         clear_data(output_data, num_samples, m_inference_config.m_num_audio_channels[Output]);
         m_inference_counter.fetch_add(1);
-        std::cout << "[WARNING] Missing samples in session: " << m_session->m_session_id << "!" << std::endl;
+        m_num_missed_blocks.fetch_add(1, std::memory_order_relaxed);
+        RealtimeLogger::log(LogLevel::Warning, "Missing samples", m_session->m_session_id);
     }
 }
 
@@ -94,6 +335,10 @@ int InferenceManager::get_latency() const {
     return m_init_samples;
 }
 
+size_t InferenceManager::get_chunk_size() const {
+    return m_inference_config.get_chunk_size();
+}
+
 const Context& InferenceManager::get_context() const {
     return *m_context;
 }
@@ -111,11 +356,275 @@ int InferenceManager::get_session_id() const {
     return m_session->m_session_id;
 }
 
+InferenceStats InferenceManager::get_stats() {
+    InferenceStats stats;
+    stats.m_queue_wait_time = m_session->m_queue_wait_time.get_statistics();
+    stats.m_inference_time = m_session->m_inference_time.get_statistics();
+    stats.m_missed_blocks = m_num_missed_blocks.load(std::memory_order_relaxed);
+    stats.m_caught_up_blocks = m_num_caught_up_blocks.load(std::memory_order_relaxed);
+
+    stats.m_num_inference_structs = m_session->m_inference_queue.size();
+    for (auto& thread_safe_struct : m_session->m_inference_queue) {
+        if (thread_safe_struct->m_free.load(std::memory_order_relaxed)) {
+            stats.m_free_inference_structs++;
+        }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::chrono::nanoseconds> busy_times = m_context->get_worker_busy_times();
+    // The number of threads changes when another session requests more, the window then starts from scratch
+    if (m_last_busy_times.size() != busy_times.size()) {
+        m_last_busy_times.assign(busy_times.size(), std::chrono::nanoseconds(0));
+    }
+    double elapsed = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_last_stats_time).count();
+    for (size_t i = 0; i < busy_times.size(); ++i) {
+        double busy = (double) (busy_times[i] - m_last_busy_times[i]).count();
+        stats.m_worker_utilisation.push_back(elapsed > 0. ? (float) std::clamp(busy / elapsed, 0., 1.) : 0.f);
+    }
+    m_last_busy_times = busy_times;
+    m_last_stats_time = now;
+
+    return stats;
+}
+
+void InferenceManager::reset_stats() {
+    m_session->m_queue_wait_time.reset();
+    m_session->m_inference_time.reset();
+    m_num_missed_blocks.store(0, std::memory_order_relaxed);
+    m_num_caught_up_blocks.store(0, std::memory_order_relaxed);
+}
+
+void InferenceManager::set_latency_change_callback(std::function<void(int requested_latency)> callback) {
+    m_latency_change_callback = callback;
+}
+
+float InferenceManager::calculate_inference_time(const LatencyHistogram& histogram) const {
+    double percentile = (double) histogram.get_percentile(m_inference_config.m_calibration_percentile).count() * 1e-6;
+    return (float) percentile * m_inference_config.m_calibration_headroom;
+}
+
+void InferenceManager::start_latency_monitor() {
+    m_session->swap_monitored_inference_time();
+    m_monitor_should_exit = false;
+    m_monitor_thread = std::thread(&InferenceManager::monitor_latency, this);
+}
+
+void InferenceManager::stop_latency_monitor() {
+    if (!m_monitor_thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_monitor_mutex);
+        m_monitor_should_exit = true;
+    }
+    m_monitor_condition.notify_one();
+    m_monitor_thread.join();
+}
+
+void InferenceManager::monitor_latency() {
+    int last_requested_latency = (int) m_init_samples;
+    std::unique_lock<std::mutex> lock(m_monitor_mutex);
+    while (!m_monitor_condition.wait_for(lock, LATENCY_MONITOR_INTERVAL, [this] { return m_monitor_should_exit; })) {
+        size_t index = m_session->m_monitored_index.load(std::memory_order_relaxed);
+        if (m_session->m_monitored_inference_time[index].get_count() < LATENCY_MONITOR_MIN_INFERENCES) {
+            continue;
+        }
+        // The inference threads record into the other histogram meanwhile, so the window is not reset while they write to it
+        const LatencyHistogram& window = m_session->swap_monitored_inference_time();
+        int requested_latency = calculate_latency(calculate_inference_time(window));
+        // Every change is reported once, a latency that keeps being requested does not call back again
+        if (requested_latency != last_requested_latency && requested_latency != (int) m_init_samples) {
+            m_latency_change_callback(requested_latency);
+        }
+        last_requested_latency = requested_latency;
+    }
+}
+
+bool InferenceManager::load_model_async(const ModelData& model_data, size_t crossfade_samples) {
+    if (model_data.m_backend == CUSTOM) {
+        std::cerr << "[ERROR] Models can only be loaded for the LibTorch, OnnxRuntime and TFLite backends, use set_custom_processor_async instead!" << std::endl;
+        return false;
+    }
+    if (!start_model_swap()) {
+        return false;
+    }
+
+    auto model_swap = std::make_shared<SessionElement::ModelSwap>();
+    model_swap->m_inference_config = std::make_unique<InferenceConfig>(m_inference_config);
+    model_swap->m_inference_config->set_model_data(model_data);
+
+    m_model_swap_thread = std::thread([this, model_swap, backend = model_data.m_backend, crossfade_samples]() {
+        // Builds a processor with its own instances, which load the model and run the warm up inferences
+        model_swap->m_processor = m_context->create_processor(*model_swap->m_inference_config, backend);
+        if (model_swap->m_processor == nullptr) {
+            std::cerr << "[ERROR] Could not load the model, its backend is not enabled!" << std::endl;
+            m_swapping_model.store(false);
+            return;
+        }
+        swap_processor(model_swap, backend, crossfade_samples);
+    });
+    return true;
+}
+
+bool InferenceManager::set_custom_processor_async(BackendBase& custom_processor, size_t crossfade_samples) {
+    if (!start_model_swap()) {
+        return false;
+    }
+
+    auto model_swap = std::make_shared<SessionElement::ModelSwap>();
+    // The caller owns the custom processor
+    model_swap->m_processor = std::shared_ptr<BackendBase>(&custom_processor, [](BackendBase*) {});
+    m_model_swap_thread = std::thread(&InferenceManager::swap_processor, this, model_swap, CUSTOM, crossfade_samples);
+    return true;
+}
+
+bool InferenceManager::is_swapping_model() const {
+    return m_swapping_model.load();
+}
+
+bool InferenceManager::start_model_swap() {
+    if (m_swapping_model.load()) {
+        std::cout << "[WARNING] The previous model swap of session " << m_session->m_session_id << " is still in progress!" << std::endl;
+        return false;
+    }
+    if (m_model_swap_thread.joinable()) {
+        m_model_swap_thread.join();
+    }
+    m_model_swap_should_exit.store(false);
+    m_swapping_model.store(true);
+    return true;
+}
+
+void InferenceManager::swap_processor(std::shared_ptr<SessionElement::ModelSwap> model_swap, InferenceBackend backend, size_t crossfade_samples) {
+    size_t num_output_samples = m_inference_config.m_output_sizes[m_inference_config.m_index_audio_data[Output]] / m_inference_config.m_num_audio_channels[Output];
+    model_swap->m_num_crossfade_inferences = (crossfade_samples + num_output_samples - 1) / num_output_samples;
+
+    std::shared_ptr<SessionElement::ModelSwap>& current_swap = m_model_swaps[backend];
+    if (current_swap != nullptr) {
+        model_swap->m_previous_processor = current_swap->m_processor;
+        // Inferences that acquired the replaced swap before it was replaced may still use it, so it is kept until the session is idle
+        m_retired_model_swaps.push_back(current_swap);
+    } else {
+        // The session owns its processors
+        BackendBase* processor = m_session->get_processor(backend);
+        model_swap->m_previous_processor = std::shared_ptr<BackendBase>(processor != nullptr ? processor : &m_session->m_default_processor, [](BackendBase*) {});
+    }
+    // The states only change while the session holds the state turn, here we only need their sizes
+    for (auto& state : m_session->m_states) {
+        model_swap->m_previous_states.emplace_back(state.size());
+    }
+    // The session is not idle, but the processor is not used by any inference before it is published
+    model_swap->m_processor->prepare_session(*m_session);
+    current_swap = model_swap;
+    m_session->m_model_swaps[backend].store(model_swap.get());
+
+    bool complete = false;
+    while (!m_model_swap_should_exit.load()) {
+        if (!complete && is_model_swap_finished(*model_swap)) {
+            model_swap->m_complete.store(true);
+            complete = true;
+        }
+        // Inferences that saw the swap as complete only use the new processor, so the previous processors can go once the others have finished
+        if (complete && !has_model_swap_users()) {
+            release_previous_processors();
+            break;
+        }
+        std::this_thread::sleep_for(MODEL_SWAP_POLL_INTERVAL);
+    }
+    m_swapping_model.store(false);
+}
+
+bool InferenceManager::has_model_swap_users() const {
+    for (auto& model_swap : m_model_swaps) {
+        if (model_swap != nullptr && model_swap->m_num_users.load() > 0) {
+            return true;
+        }
+    }
+    for (auto& model_swap : m_retired_model_swaps) {
+        if (model_swap->m_num_users.load() > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void InferenceManager::release_previous_processors() {
+    for (auto& model_swap : m_model_swaps) {
+        if (model_swap != nullptr) {
+            model_swap->m_previous_processor.reset();
+            model_swap->m_previous_states.clear();
+        }
+    }
+    // The current swaps still hold the processors that are in use
+    for (auto& model_swap : m_retired_model_swaps) {
+        model_swap->m_processor.reset();
+        model_swap->m_previous_processor.reset();
+    }
+}
+
+bool InferenceManager::is_model_swap_finished(const SessionElement::ModelSwap& model_swap) const {
+    unsigned long time_stamp = model_swap.m_time_stamp.load(std::memory_order::acquire);
+    if (time_stamp == SessionElement::ModelSwap::NO_TIME_STAMP) {
+        return false;
+    }
+    if (model_swap.m_num_finished_crossfades.load(std::memory_order::acquire) < model_swap.m_num_crossfade_inferences) {
+        return false;
+    }
+    // All earlier time stamps were already given out when the swap started, so an inference that still needs the previous processor holds its struct.
+    // A struct that is taken but not yet stamped shows its old time stamp, which only delays the swap.
+    for (auto& thread_safe_struct : m_session->m_inference_queue) {
+        if (!thread_safe_struct->m_free.load(std::memory_order::acquire) && m_session->get_time_stamp_distance(thread_safe_struct->m_time_stamp.load(std::memory_order_relaxed), time_stamp) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void InferenceManager::stop_model_swap() {
+    m_model_swap_should_exit.store(true);
+    if (m_model_swap_thread.joinable()) {
+        m_model_swap_thread.join();
+    }
+    // The inferences switch to the new processors right away. Those that still use a previous one are awaited by the caller, which idles the session before the previous processors are released.
+    for (auto& model_swap : m_model_swaps) {
+        if (model_swap != nullptr) {
+            model_swap->m_complete.store(true);
+        }
+    }
+}
+
 void InferenceManager::exec_inference() const {
     m_context->exec_inference();
 }
 
-int InferenceManager::calculate_latency() {
+int InferenceManager::calculate_latency(float inference_time) {
+    int model_latency = calculate_model_latency(inference_time);
+    if (!m_resampling) {
+        return model_latency;
+    }
+    // The filters of both resamplers delay the signal, the output filter by samples at the model sample rate
+    double host_samples_per_model_sample = (double) m_input_resampler.get_down_factor() / (double) m_input_resampler.get_up_factor();
+    return (int) std::lround(m_input_resampler.get_delay() + ((double) model_latency + m_output_resampler.get_delay()) * host_samples_per_model_sample);
+}
+
+int InferenceManager::calculate_model_latency(float inference_time) {
+    int num_output_samples = m_inference_config.m_output_sizes[m_inference_config.m_index_audio_data[Output]] / m_inference_config.m_num_audio_channels[Output];
+
+    int buffer_adaptation = m_resampling ? calculate_resampled_buffer_adaptation(num_output_samples) : calculate_buffer_adaptation(m_spec.m_host_buffer_size, num_output_samples);
+    // Offline the caller waits for the inferences, so they cause no latency
+    int inference_caused_latency = m_session->m_non_realtime ? 0 : calculate_inference_caused_latency(inference_time);
+    if (m_resampling) {
+        int64_t up = m_input_resampler.get_up_factor();
+        int64_t down = m_input_resampler.get_down_factor();
+        inference_caused_latency = (int) (((int64_t) inference_caused_latency * up + down - 1) / down);
+    }
+    int model_caused_latency = m_inference_config.m_internal_latency;
+
+    // Add it all together
+    return buffer_adaptation + inference_caused_latency + model_caused_latency;
+}
+
+int InferenceManager::calculate_inference_caused_latency(float inference_time) {
     // First calculate some universal values
     int num_output_samples = m_inference_config.m_output_sizes[m_inference_config.m_index_audio_data[Output]] / m_inference_config.m_num_audio_channels[Output];
     float host_buffer_time = (float) m_spec.m_host_buffer_size * 1000.f / (float) m_spec.m_host_sample_rate;
@@ -125,21 +634,12 @@ int InferenceManager::calculate_latency() {
     float wait_time = 0.f;
 #endif
 
-    // Then caclulate the different parts of the latency
-    int buffer_adaptation = calculate_buffer_adaptation(m_spec.m_host_buffer_size, num_output_samples);
-
-    int max_possible_inferences = max_num_inferences(m_spec.m_host_buffer_size, num_output_samples);
-    float total_inference_time_after_wait = (max_possible_inferences * m_inference_config.m_max_inference_time) - wait_time;
+    int max_possible_inferences = max_num_inferences(m_model_spec.m_host_buffer_size, num_output_samples);
+    float total_inference_time_after_wait = (max_possible_inferences * inference_time) - wait_time;
     int num_buffers_for_max_inferences = std::ceil(total_inference_time_after_wait / host_buffer_time);
-    int inference_caused_latency = num_buffers_for_max_inferences * m_spec.m_host_buffer_size;
-
-    int model_caused_latency = m_inference_config.m_internal_latency;
-
-    // Add it all together
-    return buffer_adaptation + inference_caused_latency + model_caused_latency;
+    return num_buffers_for_max_inferences * m_spec.m_host_buffer_size;
 }
 
-
 int InferenceManager::calculate_buffer_adaptation(int host_buffer_size, int num_output_samples) {
     int res = 0;
     for (int i = host_buffer_size; i < leat_common_multiple(host_buffer_size, num_output_samples) ; i+=host_buffer_size) {
@@ -148,6 +648,22 @@ int InferenceManager::calculate_buffer_adaptation(int host_buffer_size, int num_
     return res;
 }
 
+int InferenceManager::calculate_resampled_buffer_adaptation(int num_output_samples) {
+    // Both resamplers start at the same position, so after b host buffers the input resampler has produced ceil(b * N * up / down) model samples and the output resampler has consumed floor((b * N - 1) * up / down) + 1
+    int64_t host_buffer_size = m_spec.m_host_buffer_size;
+    int64_t up = m_input_resampler.get_up_factor();
+    int64_t down = m_input_resampler.get_down_factor();
+    // Both counts and the position within an inference repeat after this many host buffers
+    int64_t num_buffers = down * num_output_samples / std::gcd(host_buffer_size * up, down * num_output_samples);
+    int64_t res = 0;
+    for (int64_t i = 1; i <= num_buffers; ++i) {
+        int64_t produced = (i * host_buffer_size * up + down - 1) / down;
+        int64_t consumed = (i * host_buffer_size - 1) * up / down + 1;
+        res = std::max<int64_t>(res, consumed - produced / num_output_samples * num_output_samples);
+    }
+    return (int) res;
+}
+
 int InferenceManager::max_num_inferences(int host_buffer_size, int num_output_samples) {
     float samples_in_buffer = host_buffer_size;
     int res = (int) (samples_in_buffer / (float) num_output_samples);
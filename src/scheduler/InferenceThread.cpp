@@ -2,8 +2,9 @@
 
 namespace anira {
 
-InferenceThread::InferenceThread(moodycamel::ConcurrentQueue<InferenceData>& next_inference) :
-    m_next_inference(next_inference)
+InferenceThread::InferenceThread(WorkerQueues& next_inference, size_t worker_index) :
+    m_next_inference(next_inference),
+    m_worker_index(worker_index)
 {
 }
 
@@ -15,25 +16,26 @@ InferenceThread::~InferenceThread()
 void InferenceThread::run() {
     while (!should_exit()) {
         constexpr std::array<int, 2> iterations = {4, 32};
-        // The times for the exponential backoff. The first loop is insteadly trying to acquire the atomic counter. The second loop is waiting for approximately 100ns. Beyond that, the thread will yield and sleep for 100us.
-        exponential_backoff(iterations);
+        // The first loop is instantly trying to get new work. The second loop is waiting for approximately 100ns between the attempts. Beyond that, the thread parks until the next inference is enqueued.
+        if (!spin(iterations)) {
+            park();
+        }
     }
 }
 
-void InferenceThread::exponential_backoff(std::array<int, 2> iterations) {
+bool InferenceThread::spin(std::array<int, 2> iterations) {
     for (int i = 0; i < iterations[0]; i++) {
-        if (should_exit()) return;
-        if (execute()) return;
+        if (should_exit()) return true;
+        if (execute()) return true;
     }
     for (int i = 0; i < iterations[1]; i++) {
-        if (should_exit()) return;
-        if (execute()) return;
+        if (should_exit()) return true;
+        if (execute()) return true;
 #if defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64)
         _mm_pause();
         _mm_pause();
 #elif __aarch64__
         // ISB instruction is better than WFE https://stackoverflow.com/questions/70810121/why-does-hintspin-loop-use-isb-on-aarch64
-        // Still on linux it maxes out the CPU, so we need to sleep for a while in the next phase
         asm volatile("isb sy");
         asm volatile("isb sy");
         asm volatile("isb sy");
@@ -49,74 +51,410 @@ void InferenceThread::exponential_backoff(std::array<int, 2> iterations) {
         asm volatile("yield");
 #endif
     }
-    while (true) {
-        // The sleep_for function is important - without it, the thread will consume 100% of the CPU. This also applies when we use the ISB or WFE instruction. Also on linux we will get missing samples, because the thread gets suspended by the OS for a certain period once in a while?!?
-        if (should_exit()) return;
-        if (execute()) return;
-        std::this_thread::yield();
-        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    return false;
+}
+
+void InferenceThread::park() {
+    EventCount& event_count = m_next_inference.get_event_count(m_worker_index);
+    uint32_t key = event_count.prepare_wait();
+    // Work that was enqueued before prepare_wait did not notify us, so we have to check once more
+    if (should_exit() || m_next_inference.has_work(m_worker_index)) {
+        event_count.cancel_wait();
+        return;
     }
+    event_count.wait(key);
 }
 
+void InferenceThread::wake_up() {
+    // Only this thread parks on the event count of its queue, unless there are more threads than queues
+    m_next_inference.get_event_count(m_worker_index).notify_all();
+}
 
 bool InferenceThread::execute() {
-    if (m_next_inference.try_dequeue(m_inference_data)) {
-        // TODO: Is this enough to ensure that prepare works fine?
-        if (m_inference_data.m_session->m_initialized.load(std::memory_order::acquire)) {
-            do_inference(m_inference_data.m_session, m_inference_data.m_thread_safe_struct);
+    // Local, since the host threads may call execute concurrently
+    InferenceData inference_data;
+    if (m_next_inference.try_dequeue(m_worker_index, inference_data)) {
+        auto start = std::chrono::steady_clock::now();
+        // Thread local like the batch, it only allocates when the queues were full at a release
+        thread_local std::vector<InferenceData> unsubmitted_inferences;
+        BackendBase::set_unsubmitted_inferences(&unsubmitted_inferences);
+        process_inference_data(inference_data);
+        while (!unsubmitted_inferences.empty()) {
+            InferenceData unsubmitted_inference = unsubmitted_inferences.back();
+            unsubmitted_inferences.pop_back();
+            do_inference(unsubmitted_inference, true);
+            // It was counted as active while it waited for an instance
+            unsubmitted_inference.m_session->m_active_inferences.fetch_sub(1, std::memory_order::release);
         }
+        BackendBase::set_unsubmitted_inferences(nullptr);
+        m_busy_time_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
         return true;
     }
     return false;
 }
 
-void InferenceThread::do_inference(std::shared_ptr<SessionElement> session, std::shared_ptr<SessionElement::ThreadSafeStruct> thread_safe_struct) {
+void InferenceThread::process_inference_data(const InferenceData& inference_data) {
+    // TODO: Is this enough to ensure that prepare works fine?
+    if (!inference_data.m_session->m_initialized.load(std::memory_order::acquire)) {
+        return;
+    }
+    if (inference_data.m_session->m_inference_config.m_max_batch_size > 1) {
+        // Thread local like the buffers of the crossfade, the vectors only allocate for the first batches of a thread
+        thread_local Batch batch;
+        collect_batch(inference_data, batch);
+        do_batched_inference(batch);
+        inference_data.m_session->release_model_swap(batch.m_swap);
+        batch.m_swap = nullptr;
+        return;
+    }
+    // When all instances of the processor are busy, the inference waits on the processor until one is released instead of going back into the queue
+    do_inference(inference_data, false);
+}
+
+std::chrono::nanoseconds InferenceThread::get_busy_time() const {
+    return std::chrono::nanoseconds(m_busy_time_ns.load(std::memory_order_relaxed));
+}
+
+void InferenceThread::collect_batch(const InferenceData& first_inference, Batch& batch) {
+    const std::shared_ptr<SessionElement>& session = first_inference.m_session;
+    batch.m_inferences.clear();
+    batch.m_inferences.push_back(first_inference);
+    InferenceBackend backend = session->m_currentBackend.load(std::memory_order_relaxed);
+    // Keeps the processor of the batch alive, if it belongs to a swap, see process_inference_data
+    batch.m_swap = session->acquire_model_swap(backend);
+    batch.m_processor = get_processor(session, batch.m_swap);
+    // The processor found at construction that its model cannot run batches, so it processes the inferences one by one anyway
+    if (batch.m_processor != nullptr && !batch.m_processor->m_batching_supported) {
+        return;
+    }
+
+    size_t max_batch_size = session->m_inference_config.m_max_batch_size;
+    // The inference time the latency of the session is based on, which is calibrated or benchmarked if the session does so
+    std::chrono::nanoseconds max_inference_time = session->m_expected_inference_time;
+    // We wait for further inferences only as long as the batch can still finish before the earliest deadline in it. A batch runs at most as long as its inferences one after another, so the time left shrinks with every inference added.
+    auto earliest_deadline = first_inference.m_deadline;
+    auto latest_start = earliest_deadline - max_inference_time;
+    // The pending inferences of the session are batched as well, but without other sessions on the processor no more will arrive in time
+    bool wait = batch.m_processor != nullptr && session->m_shares_processor[backend].load(std::memory_order_relaxed);
+
+    InferenceData inference_data;
+    while (batch.m_inferences.size() < max_batch_size) {
+        if (m_next_inference.try_dequeue(m_worker_index, inference_data)) {
+            if (!inference_data.m_session->m_initialized.load(std::memory_order::acquire)) {
+                continue;
+            }
+            // Only the pointers are compared, a processor equal to ours is kept alive by our swap
+            const std::shared_ptr<SessionElement>& other_session = inference_data.m_session;
+            InferenceBackend other_backend = other_session->m_currentBackend.load(std::memory_order_relaxed);
+            if (get_processor(other_session, other_session->m_model_swaps[other_backend].load(std::memory_order::acquire)) == batch.m_processor) {
+                batch.m_inferences.push_back(inference_data);
+                earliest_deadline = std::min(earliest_deadline, inference_data.m_deadline);
+                latest_start = earliest_deadline - max_inference_time * (int64_t) batch.m_inferences.size();
+            } else {
+                // Other work is pending, so we give it back to the other threads and close the batch. If the queue is full, we process it ourselves, since dropping it would never free its struct.
+                if (!m_next_inference.try_enqueue(inference_data)) {
+                    RealtimeLogger::log(LogLevel::Warning, "Could not requeue inference data, processing it before the batch", inference_data.m_session->m_session_id);
+                    do_inference(inference_data, true);
+                }
+                break;
+            }
+        } else if (!wait || std::chrono::steady_clock::now() >= latest_start || should_exit()) {
+            break;
+        } else {
+            // Like park, but only until the batch has to start. Sleeping instead of spinning lets the producers run, even when they share the core with this high priority thread.
+            EventCount& event_count = m_next_inference.get_event_count(m_worker_index);
+            uint32_t key = event_count.prepare_wait();
+            if (should_exit() || m_next_inference.has_work(m_worker_index)) {
+                event_count.cancel_wait();
+                continue;
+            }
+            if (!event_count.wait_until(key, latest_start)) {
+                break;
+            }
+        }
+    }
+}
+
+void InferenceThread::do_batched_inference(Batch& batch) {
+    batch.m_inputs.clear();
+    batch.m_outputs.clear();
+    batch.m_sessions.clear();
+    auto start = std::chrono::steady_clock::now();
+    for (auto& inference_data : batch.m_inferences) {
+        inference_data.m_session->m_active_inferences.fetch_add(1, std::memory_order::release);
+        if (inference_data.m_session->m_inference_config.m_offload_pre_post_processing && !inference_data.m_session->m_calibrating.load(std::memory_order_relaxed)) {
+            pre_process(inference_data.m_session, inference_data.m_thread_safe_struct);
+        }
+    }
+    // Inferences of a stateful session that have to wait for an earlier one are parked, the others run without them
+    size_t batch_size = 0;
+    for (auto& inference_data : batch.m_inferences) {
+        if (!is_state_turn(inference_data) && inference_data.m_session->park_for_state_turn(inference_data.m_thread_safe_struct, inference_data.m_deadline, inference_data.m_submit_time)) {
+            inference_data.m_session->m_active_inferences.fetch_sub(1, std::memory_order::release);
+            continue;
+        }
+        batch.m_inferences[batch_size++] = inference_data;
+        batch.m_inputs.push_back(&inference_data.m_thread_safe_struct->m_processed_model_input);
+        batch.m_outputs.push_back(&inference_data.m_thread_safe_struct->m_raw_model_output);
+        batch.m_sessions.push_back(inference_data.m_session);
+    }
+    batch.m_inferences.resize(batch_size);
+    if (batch.m_inferences.empty()) {
+        return;
+    }
+
+    auto inference_start = std::chrono::steady_clock::now();
+    if (batch.m_processor != nullptr) {
+        // The inferences wait on the processor and stay active until they are resubmitted
+        if (!batch.m_processor->try_process_batch_or_wait(batch.m_inputs, batch.m_outputs, batch.m_sessions, batch.m_inferences, m_next_inference)) {
+            batch.m_sessions.clear();
+            batch.m_inferences.clear();
+            return;
+        }
+    } else {
+        // The backend has no processor or swaps it, inference reports the error and falls back to the default processor or picks the processor per inference
+        for (size_t i = 0; i < batch.m_inferences.size(); ++i) {
+            inference(batch.m_sessions[i], *batch.m_inputs[i], *batch.m_outputs[i], batch.m_inferences[i].m_thread_safe_struct->m_time_stamp.load(std::memory_order_relaxed), nullptr);
+        }
+    }
+    auto inference_time = std::chrono::steady_clock::now() - inference_start;
+
+    for (auto& inference_data : batch.m_inferences) {
+        finish_state_turn(inference_data);
+        inference_data.m_session->m_queue_wait_time.record(start - inference_data.m_submit_time);
+        inference_data.m_session->record_inference_time(inference_time);
+        if (inference_data.m_session->m_inference_config.m_offload_pre_post_processing && !inference_data.m_session->m_calibrating.load(std::memory_order_relaxed)) {
+            post_process(inference_data.m_session, inference_data.m_thread_safe_struct);
+        } else {
+#ifdef USE_CONTROLLED_BLOCKING
+            inference_data.m_thread_safe_struct->m_done.release();
+#else
+            inference_data.m_thread_safe_struct->m_done.store(true, std::memory_order::release);
+#endif
+        }
+        inference_data.m_session->notify_inference_finished();
+        inference_data.m_session->m_active_inferences.fetch_sub(1, std::memory_order::release);
+    }
+    batch.m_sessions.clear();
+    batch.m_inferences.clear();
+}
+
+BackendBase* InferenceThread::get_processor(std::shared_ptr<SessionElement> session, SessionElement::ModelSwap* model_swap) {
+    if (model_swap != nullptr) {
+        // While a swap is in progress, the inferences of the session may use different processors, so they are not batched
+        return model_swap->m_complete.load() ? model_swap->m_processor.get() : nullptr;
+    }
+    return session->get_processor(session->m_currentBackend.load(std::memory_order_relaxed));
+}
+
+void InferenceThread::do_inference(const InferenceData& inference_data, bool wait_for_instance) {
+    const std::shared_ptr<SessionElement>& session = inference_data.m_session;
+    const std::shared_ptr<SessionElement::ThreadSafeStruct>& thread_safe_struct = inference_data.m_thread_safe_struct;
     session->m_active_inferences.fetch_add(1, std::memory_order::release);
-    inference(session, thread_safe_struct->m_processed_model_input, thread_safe_struct->m_raw_model_output);
+    auto start = std::chrono::steady_clock::now();
+    bool offload = session->m_inference_config.m_offload_pre_post_processing && !session->m_calibrating.load(std::memory_order_relaxed);
+    if (offload) {
+        pre_process(session, thread_safe_struct);
+    }
+
+    // The inference before it submits a parked inference again once it finished
+    if (!is_state_turn(inference_data) && session->park_for_state_turn(thread_safe_struct, inference_data.m_deadline, inference_data.m_submit_time)) {
+        session->m_active_inferences.fetch_sub(1, std::memory_order::release);
+        return;
+    }
+
+    auto inference_start = std::chrono::steady_clock::now();
+    // An inference that waits for an instance stays active until the processor resubmits it
+    if (!inference(session, thread_safe_struct->m_processed_model_input, thread_safe_struct->m_raw_model_output, thread_safe_struct->m_time_stamp.load(std::memory_order_relaxed), wait_for_instance ? nullptr : &inference_data)) {
+        return;
+    }
+    auto inference_time = std::chrono::steady_clock::now() - inference_start;
+    finish_state_turn(inference_data);
+    // Includes the time the inference spent waiting for an instance
+    session->m_queue_wait_time.record(start - inference_data.m_submit_time);
+    session->record_inference_time(inference_time);
+
+    if (offload) {
+        post_process(session, thread_safe_struct);
+    } else {
 #ifdef USE_CONTROLLED_BLOCKING
-    thread_safe_struct->m_done.release();
+        thread_safe_struct->m_done.release();
 #else
-    thread_safe_struct->m_done.store(true, std::memory_order::release);
+        thread_safe_struct->m_done.store(true, std::memory_order::release);
 #endif
+    }
+    session->notify_inference_finished();
     session->m_active_inferences.fetch_sub(1, std::memory_order::release);
 }
 
-void InferenceThread::inference(std::shared_ptr<SessionElement> session, AudioBufferF& input, AudioBufferF& output) {
+bool InferenceThread::is_state_turn(const InferenceData& inference_data) {
+    const std::shared_ptr<SessionElement>& session = inference_data.m_session;
+    // Calibration inferences do not belong to the state, it is reset afterwards
+    if (!session->is_stateful() || session->m_calibrating.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    return session->is_state_turn(inference_data.m_thread_safe_struct->m_time_stamp.load(std::memory_order_relaxed));
+}
+
+void InferenceThread::finish_state_turn(const InferenceData& inference_data) {
+    const std::shared_ptr<SessionElement>& session = inference_data.m_session;
+    if (!session->is_stateful() || session->m_calibrating.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::shared_ptr<SessionElement::ThreadSafeStruct> next_struct = session->finish_state_turn();
+    if (next_struct == nullptr) {
+        return;
+    }
+    InferenceData next_inference = {session, next_struct, next_struct->m_parked_deadline, next_struct->m_parked_submit_time};
+    if (!m_next_inference.try_enqueue(next_inference)) {
+        RealtimeLogger::log(LogLevel::Warning, "Could not resubmit the parked inference, processing it right away", session->m_session_id);
+        do_inference(next_inference, true);
+    }
+}
+
+void InferenceThread::pre_process(std::shared_ptr<SessionElement> session, std::shared_ptr<SessionElement::ThreadSafeStruct> thread_safe_struct) {
+    // A resubmitted inference was already pre-processed
+    if (thread_safe_struct->m_pre_processed) {
+        return;
+    }
+    thread_safe_struct->m_pre_processed = true;
+    // The send buffer has a single consumer, so the windows are popped one after another and stamped in the order they were popped
+    std::lock_guard<std::mutex> lock(session->m_pre_process_mutex);
+    session->m_pp_processor.pre_process(session->m_send_buffer, thread_safe_struct->m_processed_model_input, session->m_currentBackend.load(std::memory_order_relaxed));
+    session->start_model_swaps(session->m_next_pre_process_stamp);
+    thread_safe_struct->m_time_stamp = session->m_next_pre_process_stamp++;
+}
+
+void InferenceThread::post_process(std::shared_ptr<SessionElement> session, std::shared_ptr<SessionElement::ThreadSafeStruct> thread_safe_struct) {
+    size_t num_slots = session->m_finished_inferences.size();
+    session->m_finished_inferences[thread_safe_struct->m_time_stamp % num_slots].store(thread_safe_struct.get(), std::memory_order::release);
+
+    // Results have to be pushed in the order of their time stamps. Whoever holds the lock pushes all finished results in order. A result that finishes meanwhile is pushed by its own thread once it gets the lock.
+    std::lock_guard<std::mutex> lock(session->m_post_process_mutex);
+    while (true) {
+        std::atomic<SessionElement::ThreadSafeStruct*>& slot = session->m_finished_inferences[session->m_next_post_process_stamp % num_slots];
+        SessionElement::ThreadSafeStruct* finished_struct = slot.load(std::memory_order::acquire);
+        if (finished_struct == nullptr) {
+            break;
+        }
+        slot.store(nullptr, std::memory_order_relaxed);
+        session->m_pp_processor.post_process(finished_struct->m_raw_model_output, session->m_receive_buffer, session->m_currentBackend.load(std::memory_order_relaxed));
+        session->m_next_post_process_stamp++;
+        finished_struct->m_free.store(true, std::memory_order::release);
+    }
+}
+
+bool InferenceThread::inference(std::shared_ptr<SessionElement> session, AudioBufferF& input, AudioBufferF& output, unsigned long time_stamp, const InferenceData* waiting_inference) {
+    SessionElement::ModelSwap* model_swap = session->acquire_model_swap(session->m_currentBackend.load(std::memory_order_relaxed));
+    if (model_swap != nullptr) {
+        bool processed = swap_inference(session, *model_swap, input, output, time_stamp, waiting_inference);
+        session->release_model_swap(model_swap);
+        return processed;
+    }
 #ifdef USE_LIBTORCH
     if (session->m_currentBackend.load(std::memory_order_relaxed) == LIBTORCH) {
         if (session->m_libtorch_processor != nullptr) {
-            session->m_libtorch_processor->process(input, output, session);
+            return run_processor(*session->m_libtorch_processor, input, output, session, waiting_inference);
         }
         else {
             session->m_default_processor.process(input, output, session);
-            std::cerr << "[ERROR] LibTorch model has not been provided. Using default processor." << std::endl;
+            RealtimeLogger::log(LogLevel::Error, "LibTorch model has not been provided, using default processor", session->m_session_id);
         }
     }
 #endif
 #ifdef USE_ONNXRUNTIME
     if (session->m_currentBackend.load(std::memory_order_relaxed) == ONNX) {
         if (session->m_onnx_processor != nullptr) {
-            session->m_onnx_processor->process(input, output, session);
+            return run_processor(*session->m_onnx_processor, input, output, session, waiting_inference);
         }
         else {
             session->m_default_processor.process(input, output, session);
-            std::cerr << "[ERROR] OnnxRuntime model has not been provided. Using default processor." << std::endl;
+            RealtimeLogger::log(LogLevel::Error, "OnnxRuntime model has not been provided, using default processor", session->m_session_id);
         }
     }
 #endif
 #ifdef USE_TFLITE
     if (session->m_currentBackend.load(std::memory_order_relaxed) == TFLITE) {
         if (session->m_tflite_processor != nullptr) {
-            session->m_tflite_processor->process(input, output, session);
+            return run_processor(*session->m_tflite_processor, input, output, session, waiting_inference);
         }
         else {
             session->m_default_processor.process(input, output, session);
-            std::cerr << "[ERROR] TFLite model has not been provided. Using default processor." << std::endl;
+            RealtimeLogger::log(LogLevel::Error, "TFLite model has not been provided, using default processor", session->m_session_id);
         }
     }
 #endif
     if (session->m_currentBackend.load(std::memory_order_relaxed) == CUSTOM) {
-        session->m_custom_processor->process(input, output, session);
+        return run_processor(*session->m_custom_processor, input, output, session, waiting_inference);
+    }
+    return true;
+}
+
+bool InferenceThread::swap_inference(std::shared_ptr<SessionElement> session, SessionElement::ModelSwap& model_swap, AudioBufferF& input, AudioBufferF& output, unsigned long time_stamp, const InferenceData* waiting_inference) {
+    // Sequentially consistent with the user count, so that the InferenceManager either sees us as user or we see the swap as complete
+    if (model_swap.m_complete.load()) {
+        return run_processor(*model_swap.m_processor, input, output, session, waiting_inference);
+    }
+
+    // The swap starts at the first time stamp that was given out after it was published. Earlier inferences keep using the previous processor, no matter when they run, so the output never switches back.
+    unsigned long swap_time_stamp = model_swap.m_time_stamp.load(std::memory_order::acquire);
+    long distance = swap_time_stamp == SessionElement::ModelSwap::NO_TIME_STAMP ? -1 : session->get_time_stamp_distance(time_stamp, swap_time_stamp);
+
+    if (distance < 0) {
+        return run_processor(*model_swap.m_previous_processor, input, output, session, waiting_inference);
+    }
+    // Inferences of a stateful session run in the order of their time stamps, so the state belongs to the previous processor up to here
+    if (distance == 0 && session->is_stateful()) {
+        session->split_states(model_swap);
+    }
+    if ((size_t) distance >= model_swap.m_num_crossfade_inferences) {
+        return run_processor(*model_swap.m_processor, input, output, session, waiting_inference);
+    }
+    // The crossfade needs both processors, so it waits for their instances instead of holding one of them while waiting for the other
+    crossfade(session, model_swap, input, output, (size_t) distance);
+    model_swap.m_num_finished_crossfades.fetch_add(1, std::memory_order::release);
+    return true;
+}
+
+bool InferenceThread::run_processor(BackendBase& processor, AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session, const InferenceData* waiting_inference) {
+    if (waiting_inference == nullptr) {
+        processor.process(input, output, session);
+        return true;
+    }
+    return processor.try_process_or_wait(input, output, *waiting_inference, m_next_inference);
+}
+
+void InferenceThread::crossfade(std::shared_ptr<SessionElement> session, SessionElement::ModelSwap& model_swap, AudioBufferF& input, AudioBufferF& output, size_t crossfade_index) {
+    // Thread local, since the host threads may call execute concurrently. They are only allocated by the first crossfade of a thread.
+    thread_local AudioBufferF previous_input;
+    thread_local AudioBufferF previous_output;
+    if (previous_input.get_num_channels() != input.get_num_channels() || previous_input.get_num_samples() != input.get_num_samples()) {
+        previous_input.resize(input.get_num_channels(), input.get_num_samples());
+    }
+    if (previous_output.get_num_channels() != output.get_num_channels() || previous_output.get_num_samples() != output.get_num_samples()) {
+        previous_output.resize(output.get_num_channels(), output.get_num_samples());
+    }
+
+    // The backends may swap the input buffer with one of their own, so the previous processor gets a copy
+    for (size_t channel = 0; channel < input.get_num_channels(); ++channel) {
+        std::copy_n(input.get_read_pointer(channel), input.get_num_samples(), previous_input.get_write_pointer(channel));
+    }
+    // The previous processor continues its own state, so that the state of the new one only advances once per inference
+    SessionElement::set_crossfade_states(&model_swap.m_previous_states);
+    model_swap.m_previous_processor->process(previous_input, previous_output, session);
+    SessionElement::set_crossfade_states(nullptr);
+    model_swap.m_processor->process(input, output, session);
+
+    // The gain of the new processor rises linearly over the outputs of all crossfade inferences
+    size_t num_samples = output.get_num_samples();
+    float crossfade_length = (float) (model_swap.m_num_crossfade_inferences * num_samples);
+    for (size_t channel = 0; channel < output.get_num_channels(); ++channel) {
+        const float* previous_data = previous_output.get_read_pointer(channel);
+        float* data = output.get_write_pointer(channel);
+        for (size_t i = 0; i < num_samples; ++i) {
+            float gain = (float) (crossfade_index * num_samples + i + 1) / crossfade_length;
+            data[i] = previous_data[i] + gain * (data[i] - previous_data[i]);
+        }
     }
 }
 
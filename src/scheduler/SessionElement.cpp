@@ -2,10 +2,14 @@
 
 namespace anira {
 
+// Only the thread that runs the previous processor of a crossfade sees its states
+static thread_local std::vector<MemoryBlock<float>>* t_crossfade_states = nullptr;
+
 SessionElement::SessionElement(int newSessionID, PrePostProcessor& pp_processor, InferenceConfig& inference_config) :
     m_session_id(newSessionID),
     m_pp_processor(pp_processor),
-    m_inference_config(inference_config),
+    m_chunk_config(inference_config.m_chunk_sizes.empty() ? nullptr : std::make_unique<InferenceConfig>(inference_config)),
+    m_inference_config(m_chunk_config != nullptr ? *m_chunk_config : inference_config),
     m_default_processor(m_inference_config),
     m_custom_processor(&m_default_processor)
 {
@@ -16,39 +20,264 @@ SessionElement::ThreadSafeStruct::ThreadSafeStruct(size_t num_input_samples, siz
     m_raw_model_output.resize(num_output_channels, num_output_samples);
 }
 
+void SessionElement::record_inference_time(std::chrono::nanoseconds inference_time) {
+    m_inference_time.record(inference_time);
+    m_monitored_inference_time[m_monitored_index.load(std::memory_order::acquire)].record(inference_time);
+}
+
+const LatencyHistogram& SessionElement::swap_monitored_inference_time() {
+    size_t index = m_monitored_index.load(std::memory_order_relaxed);
+    // The next histogram was not recorded into for a whole monitor interval, so no inference thread is still writing to it
+    m_monitored_inference_time[1 - index].reset();
+    m_monitored_index.store(1 - index, std::memory_order::release);
+    return m_monitored_inference_time[index];
+}
+
 void SessionElement::clear() {
     m_send_buffer.clear_with_positions();
     m_receive_buffer.clear_with_positions();
     m_time_stamps.clear();
     m_inference_queue.clear();
+    m_num_pending_samples = 0;
+    m_next_pre_process_stamp = 0;
+    m_next_post_process_stamp = 0;
+    m_finished_inferences.clear();
 }
 
-void SessionElement::prepare(HostAudioConfig new_config) {
+void SessionElement::prepare(HostAudioConfig new_config, int latency) {
     m_host_config = new_config;
 
-    // TODO: forcing init until we find a better way
-    // @ANIRA: should allow for overwriting the maxSecs and maxStructs ?
-    
-    int maxSecs = 20;
-    int maxStructs = 20;
-    
-    m_send_buffer.initialize_with_positions(m_inference_config.m_num_audio_channels[Input], (size_t) m_host_config.m_host_sample_rate * maxSecs); // 20 secs
-    m_receive_buffer.initialize_with_positions(m_inference_config.m_num_audio_channels[Output], (size_t) m_host_config.m_host_sample_rate * maxSecs); // 20 secs
-
-    // Compute the queue size: ensure enough structures to handle hits considering thread count and processing time?
-    size_t n_structs = maxStructs;
-    
-    // How big are the input and output buffers
     size_t num_input_samples = m_inference_config.m_input_sizes[m_inference_config.m_index_audio_data[Input]] / m_inference_config.m_num_audio_channels[Input];
     size_t num_output_samples = m_inference_config.m_output_sizes[m_inference_config.m_index_audio_data[Output]] / m_inference_config.m_num_audio_channels[Output];
     size_t num_input_channels = m_inference_config.m_num_audio_channels[Input];
     size_t num_output_channels = m_inference_config.m_num_audio_channels[Output];
+    size_t host_buffer_size = m_host_config.m_host_buffer_size;
+
+    // An inference holds its struct from the submission until its result is pushed, which should happen within the latency plus one host buffer. Twice as many structs leave room for late inferences to catch up.
+    size_t n_structs = m_inference_config.m_num_inference_structs;
+    if (n_structs == 0) {
+        size_t num_inferences_in_latency = ((size_t) latency + host_buffer_size + num_output_samples - 1) / num_output_samples;
+        n_structs = 2 * num_inferences_in_latency + 1;
+    }
+
+    // The send buffer holds the past samples of the model input, the samples waiting for a struct and the next host buffer
+    size_t num_past_samples = num_input_samples > num_output_samples ? num_input_samples - num_output_samples : 0;
+    if (m_inference_config.m_mirrored_ring_buffer) {
+        // The model inputs point into the history of the send buffer until their inference finishes, so the windows of all inferences in flight must not be overwritten
+        num_past_samples += n_structs * num_output_samples;
+    }
+    size_t send_buffer_capacity = num_past_samples + (n_structs + 1) * num_output_samples + 2 * host_buffer_size + 1;
+    // The receive buffer holds the initial latency and the results of all structs, plus the zeros pushed when no struct was free
+    size_t receive_buffer_capacity = (size_t) latency + (n_structs + 1) * num_output_samples + 2 * host_buffer_size + 1;
+    if (m_inference_config.m_ring_buffer_capacity > 0) {
+        // Smaller buffers would overwrite the past samples, the windows of the inferences in flight or results that were not popped yet, so the capacity can only be enlarged
+        if (m_inference_config.m_ring_buffer_capacity < std::max(send_buffer_capacity, receive_buffer_capacity)) {
+            std::cout << "[WARNING] Session " << m_session_id << ": the ring buffer capacity of " << m_inference_config.m_ring_buffer_capacity << " samples is below the required " << send_buffer_capacity << " (send) and " << receive_buffer_capacity << " (receive) samples, using at least the required capacities!" << std::endl;
+        }
+        send_buffer_capacity = std::max(send_buffer_capacity, m_inference_config.m_ring_buffer_capacity);
+        receive_buffer_capacity = std::max(receive_buffer_capacity, m_inference_config.m_ring_buffer_capacity);
+    }
 
-    for (int i = 0; i < n_structs; ++i) {
+    // The read position advances by num_output_samples per inference, so the windows of the model inputs start at the same positions on every pass
+    m_send_buffer.initialize_with_positions(num_input_channels, send_buffer_capacity, m_inference_config.m_mirrored_ring_buffer, num_output_samples);
+    m_receive_buffer.initialize_with_positions(num_output_channels, receive_buffer_capacity);
+    // The first inferences read past samples from before the first push
+    m_send_buffer.clear_with_positions();
+    m_receive_buffer.clear_with_positions();
+    m_num_past_samples = num_past_samples;
+
+    for (size_t i = 0; i < n_structs; ++i) {
         m_inference_queue.emplace_back(std::make_unique<ThreadSafeStruct>(num_input_samples, num_output_samples, num_input_channels, num_output_channels));
     }
 
+    m_states.clear();
+    for (auto& state_indices : m_inference_config.m_state_indices) {
+        if (state_indices[Input] >= m_inference_config.m_input_sizes.size() || state_indices[Output] >= m_inference_config.m_output_sizes.size() ||
+            state_indices[Input] == m_inference_config.m_index_audio_data[Input] || state_indices[Output] == m_inference_config.m_index_audio_data[Output]) {
+            std::cerr << "[ERROR] The state indices " << state_indices[Input] << " and " << state_indices[Output] << " do not refer to non-audio tensors!" << std::endl;
+            m_states.clear();
+            break;
+        }
+        size_t state_size = m_inference_config.m_input_sizes[state_indices[Input]];
+        if (m_inference_config.m_output_sizes[state_indices[Output]] != state_size) {
+            std::cerr << "[ERROR] The state input " << state_indices[Input] << " and output " << state_indices[Output] << " have different sizes!" << std::endl;
+            m_states.clear();
+            break;
+        }
+        m_states.emplace_back(state_size);
+        m_states.back().clear();
+    }
+    // The time stamps of the offloaded pre-processing start from zero, those of the real-time thread continue
+    m_next_state_stamp.store(m_inference_config.m_offload_pre_post_processing ? m_next_pre_process_stamp : m_current_queue);
+
     m_time_stamps.reserve(n_structs);
+    // At most n_structs inferences are in flight and their stamps are consecutive, so every one of them gets its own slot
+    m_finished_inferences = std::vector<std::atomic<ThreadSafeStruct*>>(n_structs);
+}
+
+BackendBase* SessionElement::get_processor(InferenceBackend backend) {
+#ifdef USE_LIBTORCH
+    if (backend == LIBTORCH) {
+        return m_libtorch_processor.get();
+    }
+#endif
+#ifdef USE_ONNXRUNTIME
+    if (backend == ONNX) {
+        return m_onnx_processor.get();
+    }
+#endif
+#ifdef USE_TFLITE
+    if (backend == TFLITE) {
+        return m_tflite_processor.get();
+    }
+#endif
+    if (backend == CUSTOM) {
+        return m_custom_processor;
+    }
+    return nullptr;
+}
+
+SessionElement::ModelSwap* SessionElement::acquire_model_swap(InferenceBackend backend) {
+    ModelSwap* model_swap = m_model_swaps[backend].load(std::memory_order::acquire);
+    while (model_swap != nullptr) {
+        model_swap->m_num_users.fetch_add(1);
+        // A swap that was replaced meanwhile may lose its processors once its users left, so the caller only gets the current one
+        ModelSwap* current_swap = m_model_swaps[backend].load();
+        if (current_swap == model_swap) {
+            break;
+        }
+        model_swap->m_num_users.fetch_sub(1, std::memory_order::release);
+        model_swap = current_swap;
+    }
+    return model_swap;
+}
+
+void SessionElement::release_model_swap(ModelSwap* model_swap) {
+    if (model_swap != nullptr) {
+        model_swap->m_num_users.fetch_sub(1, std::memory_order::release);
+    }
+}
+
+void SessionElement::start_model_swaps(unsigned long time_stamp) {
+    for (auto& slot : m_model_swaps) {
+        ModelSwap* model_swap = slot.load(std::memory_order::acquire);
+        // Only the stamping thread writes the time stamp. Inferences with earlier stamps use the previous processor, no matter when they run.
+        if (model_swap != nullptr && model_swap->m_time_stamp.load(std::memory_order_relaxed) == ModelSwap::NO_TIME_STAMP) {
+            model_swap->m_time_stamp.store(time_stamp, std::memory_order::release);
+        }
+    }
+}
+
+long SessionElement::get_time_stamp_distance(unsigned long time_stamp, unsigned long reference) const {
+    long distance = (long) time_stamp - (long) reference;
+    if (!m_inference_config.m_offload_pre_post_processing) {
+        // The real-time thread wraps its time stamps around after UINT16_MAX
+        constexpr long period = (long) UINT16_MAX + 1;
+        distance = ((distance % period) + period + period / 2) % period - period / 2;
+    }
+    return distance;
+}
+
+void SessionElement::get_input_tensor(float* data, size_t i) {
+    std::vector<MemoryBlock<float>>& states = t_crossfade_states != nullptr ? *t_crossfade_states : m_states;
+    for (size_t s = 0; s < m_states.size(); ++s) {
+        if (m_inference_config.m_state_indices[s][Input] == i) {
+            std::memcpy(data, states[s].data(), states[s].size() * sizeof(float));
+            return;
+        }
+    }
+    m_pp_processor.get_input_tensor(data, i);
+}
+
+void SessionElement::set_output_tensor(const float* data, size_t i) {
+    std::vector<MemoryBlock<float>>& states = t_crossfade_states != nullptr ? *t_crossfade_states : m_states;
+    for (size_t s = 0; s < m_states.size(); ++s) {
+        if (m_inference_config.m_state_indices[s][Output] == i) {
+            std::memcpy(states[s].data(), data, states[s].size() * sizeof(float));
+            return;
+        }
+    }
+    // The PrePostProcessor gets the outputs of the new processor only
+    if (t_crossfade_states != nullptr) {
+        return;
+    }
+    m_pp_processor.set_output_tensor(data, i);
+}
+
+void SessionElement::set_crossfade_states(std::vector<MemoryBlock<float>>* previous_states) {
+    t_crossfade_states = previous_states;
+}
+
+void SessionElement::split_states(ModelSwap& model_swap) {
+    // A resubmitted inference must not split the states again
+    if (model_swap.m_states_split || model_swap.m_previous_states.size() != m_states.size()) {
+        return;
+    }
+    model_swap.m_states_split = true;
+    for (size_t s = 0; s < m_states.size(); ++s) {
+        std::memcpy(model_swap.m_previous_states[s].data(), m_states[s].data(), m_states[s].size() * sizeof(float));
+        m_states[s].clear();
+    }
+}
+
+void SessionElement::notify_inference_finished() {
+    // The real-time path never waits, so it does not pay for the notification
+    if (m_non_realtime) {
+        m_num_finished_inferences.fetch_add(1, std::memory_order::release);
+        m_inference_finished.notify_all();
+    }
+}
+
+void SessionElement::wait_for_inference(size_t num_finished) {
+    while (m_num_finished_inferences.load(std::memory_order::acquire) == num_finished) {
+        uint32_t key = m_inference_finished.prepare_wait();
+        if (m_num_finished_inferences.load(std::memory_order::acquire) != num_finished) {
+            m_inference_finished.cancel_wait();
+            return;
+        }
+        m_inference_finished.wait(key);
+    }
+}
+
+bool SessionElement::is_stateful() const {
+    return !m_states.empty();
+}
+
+bool SessionElement::is_state_turn(unsigned long time_stamp) const {
+    return get_time_stamp_distance(time_stamp, m_next_state_stamp.load()) == 0;
+}
+
+bool SessionElement::park_for_state_turn(const std::shared_ptr<ThreadSafeStruct>& thread_safe_struct, std::chrono::steady_clock::time_point deadline, std::chrono::steady_clock::time_point submit_time) {
+    thread_safe_struct->m_parked_deadline = deadline;
+    thread_safe_struct->m_parked_submit_time = submit_time;
+    thread_safe_struct->m_parked.store(true);
+    // Both sides store first and load second with sequential consistency, so either the finishing inference sees the parked one or we see the new turn
+    if (is_state_turn(thread_safe_struct->m_time_stamp.load(std::memory_order_relaxed))) {
+        // Whoever clears the flag runs the inference
+        return !thread_safe_struct->m_parked.exchange(false);
+    }
+    return true;
+}
+
+std::shared_ptr<SessionElement::ThreadSafeStruct> SessionElement::finish_state_turn() {
+    unsigned long time_stamp = m_next_state_stamp.load(std::memory_order_relaxed);
+    // Follows the time stamps of the real-time thread, which wrap around after UINT16_MAX
+    if (!m_inference_config.m_offload_pre_post_processing && time_stamp >= UINT16_MAX) {
+        time_stamp = 0;
+    } else {
+        time_stamp++;
+    }
+    m_next_state_stamp.store(time_stamp);
+
+    // Only one inference per time stamp is in flight, so at most one struct waits for this turn
+    for (auto& thread_safe_struct : m_inference_queue) {
+        if (thread_safe_struct->m_parked.load() && thread_safe_struct->m_time_stamp.load(std::memory_order_relaxed) == time_stamp) {
+            if (thread_safe_struct->m_parked.exchange(false)) {
+                return thread_safe_struct;
+            }
+        }
+    }
+    return nullptr;
 }
 
 template <typename T> void SessionElement::set_processor(std::shared_ptr<T>& processor) {
@@ -0,0 +1,162 @@
+#include <anira/scheduler/WorkerQueues.h>
+#include <algorithm>
+
+namespace anira {
+
+WorkerQueues::Worker::Worker(size_t queue_capacity) :
+    m_queue(queue_capacity)
+{
+}
+
+WorkerQueues::WorkerQueues(size_t max_num_workers, size_t queue_capacity) :
+    m_queue_capacity(queue_capacity)
+{
+    // The workers iterate over the queues while new ones are added, so the vector must never reallocate
+    m_workers.reserve(max_num_workers);
+}
+
+void WorkerQueues::set_num_workers(size_t num_workers) {
+    if (num_workers > m_workers.capacity()) {
+        std::cout << "[WARNING] Only " << m_workers.capacity() << " worker queues are supported. Additional workers share the existing queues." << std::endl;
+    }
+    while (m_workers.size() < std::max<size_t>(num_workers, 1) && m_workers.size() < m_workers.capacity()) {
+        m_workers.emplace_back(std::make_unique<Worker>(m_queue_capacity));
+        m_num_queues.store(m_workers.size(), std::memory_order_release);
+    }
+    m_num_workers.store(std::max<size_t>(std::min(num_workers, m_workers.size()), 1), std::memory_order_release);
+}
+
+EventCount& WorkerQueues::get_event_count(size_t worker_index) {
+    return m_workers[worker_index % m_num_queues.load(std::memory_order_acquire)]->m_event_count;
+}
+
+void WorkerQueues::notify_all() {
+    size_t num_queues = m_num_queues.load(std::memory_order_acquire);
+    for (size_t i = 0; i < num_queues; ++i) {
+        m_workers[i]->m_event_count.notify_all();
+    }
+}
+
+bool WorkerQueues::try_enqueue(const InferenceData& inference_data) {
+    if (m_num_queues.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    size_t num_workers = m_num_workers.load(std::memory_order_acquire);
+    // Zero marks an empty queue, so the submit time is at least one tick
+    int64_t submit_time = std::max<int64_t>(inference_data.m_submit_time.time_since_epoch().count(), 1);
+    size_t home_worker = get_home_worker(inference_data.m_session);
+    // A full queue passes the inference on to the next running worker, which takes it like its own
+    for (size_t i = 0; i < num_workers; ++i) {
+        size_t worker_index = (home_worker + i) % num_workers;
+        Worker& worker = *m_workers[worker_index];
+        if (worker.m_queue.try_push(inference_data)) {
+            int64_t expected = 0;
+            worker.m_pending_since.compare_exchange_strong(expected, submit_time, std::memory_order_relaxed);
+            wake_up(worker_index);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorkerQueues::try_dequeue(size_t worker_index, InferenceData& inference_data) {
+    size_t num_queues = m_num_queues.load(std::memory_order_acquire);
+    if (num_queues == 0) {
+        return false;
+    }
+    worker_index %= num_queues;
+    Worker& worker = *m_workers[worker_index];
+    worker.m_busy.store(false, std::memory_order_relaxed);
+
+    bool found = false;
+    if (worker.m_queue.size_approx() > 0) {
+        // Inferences pushed from now on start a new grace period
+        worker.m_pending_since.store(0, std::memory_order_relaxed);
+        found = worker.m_queue.try_dequeue(inference_data);
+    }
+    std::chrono::steady_clock::time_point now{};
+    for (size_t i = 1; i < num_queues && !found; ++i) {
+        size_t victim_index = (worker_index + i) % num_queues;
+        found = may_steal(victim_index, now) && m_workers[victim_index]->m_queue.try_dequeue(inference_data);
+    }
+    if (found) {
+        worker.m_busy.store(true, std::memory_order_relaxed);
+    }
+    return found;
+}
+
+bool WorkerQueues::has_work(size_t worker_index) const {
+    size_t num_queues = m_num_queues.load(std::memory_order_acquire);
+    if (num_queues == 0) {
+        return false;
+    }
+    worker_index %= num_queues;
+    if (m_workers[worker_index]->m_queue.size_approx() > 0) {
+        return true;
+    }
+    std::chrono::steady_clock::time_point now{};
+    for (size_t i = 1; i < num_queues; ++i) {
+        if (may_steal((worker_index + i) % num_queues, now)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerQueues::remove_session(std::shared_ptr<SessionElement> session) {
+    size_t num_queues = m_num_queues.load(std::memory_order_acquire);
+    for (size_t i = 0; i < num_queues; ++i) {
+        m_workers[i]->m_queue.remove_session(session);
+    }
+}
+
+size_t WorkerQueues::size_approx() const {
+    size_t size = 0;
+    size_t num_queues = m_num_queues.load(std::memory_order_acquire);
+    for (size_t i = 0; i < num_queues; ++i) {
+        size += m_workers[i]->m_queue.size_approx();
+    }
+    return size;
+}
+
+size_t WorkerQueues::get_home_worker(const std::shared_ptr<SessionElement>& session) const {
+    return (size_t) session->m_session_id % m_num_workers.load(std::memory_order_acquire);
+}
+
+bool WorkerQueues::may_steal(size_t victim_index, std::chrono::steady_clock::time_point& now) const {
+    const Worker& victim = *m_workers[victim_index];
+    if (victim.m_queue.size_approx() == 0) {
+        return false;
+    }
+    // Nobody else takes the inferences left behind by a stopped worker
+    if (victim_index >= m_num_workers.load(std::memory_order_acquire) || victim.m_busy.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    int64_t pending_since = victim.m_pending_since.load(std::memory_order_relaxed);
+    if (pending_since == 0) {
+        return false;
+    }
+    // The clock is only read once per call and only when a queue is waiting for its idle worker
+    if (now == std::chrono::steady_clock::time_point{}) {
+        now = std::chrono::steady_clock::now();
+    }
+    return now - std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(pending_since)) > STEAL_GRACE_PERIOD;
+}
+
+void WorkerQueues::wake_up(size_t worker_index) {
+    Worker& worker = *m_workers[worker_index];
+    bool busy = worker.m_busy.load(std::memory_order_relaxed);
+    worker.m_event_count.notify_one();
+    if (!busy) {
+        return;
+    }
+    // The home worker first has to finish its current inference, so one idle worker may steal the new one right away
+    size_t num_workers = m_num_workers.load(std::memory_order_acquire);
+    for (size_t i = 1; i < num_workers; ++i) {
+        if (m_workers[(worker_index + i) % num_workers]->m_event_count.notify_one()) {
+            return;
+        }
+    }
+}
+
+} // namespace anira
@@ -0,0 +1,123 @@
+#include <anira/system/CpuAffinity.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace anira {
+
+std::vector<int> CpuAffinity::parse_cpu_list(const std::string& cpu_list) {
+    std::vector<int> cores;
+    std::stringstream stream(cpu_list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        range.erase(std::remove_if(range.begin(), range.end(), ::isspace), range.end());
+        if (range.empty()) {
+            continue;
+        }
+        try {
+            size_t dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int core = first; core <= last; ++core) {
+                cores.push_back(core);
+            }
+        } catch (const std::exception&) {
+            std::cerr << "[ERROR] Invalid cpu list: " << cpu_list << std::endl;
+            return {};
+        }
+    }
+    std::sort(cores.begin(), cores.end());
+    cores.erase(std::unique(cores.begin(), cores.end()), cores.end());
+    return cores;
+}
+
+std::vector<int> CpuAffinity::get_online_cores() {
+#if __linux__
+    std::ifstream file("/sys/devices/system/cpu/online");
+    std::string cpu_list;
+    if (file && std::getline(file, cpu_list)) {
+        std::vector<int> cores = parse_cpu_list(cpu_list);
+        if (!cores.empty()) {
+            return cores;
+        }
+    }
+#endif
+    std::vector<int> cores;
+    for (int core = 0; core < (int) std::thread::hardware_concurrency(); ++core) {
+        cores.push_back(core);
+    }
+    return cores;
+}
+
+std::vector<int> CpuAffinity::get_numa_node_cores(int numa_node) {
+#if __linux__
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(numa_node) + "/cpulist");
+    std::string cpu_list;
+    if (file && std::getline(file, cpu_list)) {
+        return parse_cpu_list(cpu_list);
+    }
+    std::cerr << "[ERROR] Could not read the cores of NUMA node " << numa_node << "." << std::endl;
+#else
+    std::cout << "[WARNING] NUMA node preference is only supported on linux." << std::endl;
+#endif
+    return {};
+}
+
+std::vector<int> CpuAffinity::get_caller_cores() {
+    std::vector<int> cores;
+#if __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set) == 0) {
+        for (int core = 0; core < CPU_SETSIZE; ++core) {
+            if (CPU_ISSET(core, &cpu_set)) {
+                cores.push_back(core);
+            }
+        }
+    }
+    // The core an unpinned thread happens to run on says nothing about where it runs next
+    if (cores.size() >= get_online_cores().size()) {
+        cores.clear();
+    }
+#endif
+    return cores;
+}
+
+bool CpuAffinity::set_thread_affinity(std::thread::native_handle_type thread_native_handle, const std::vector<int>& cores) {
+    if (cores.empty()) {
+        return true;
+    }
+#if __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int core : cores) {
+        if (core >= 0 && core < CPU_SETSIZE) {
+            CPU_SET(core, &cpu_set);
+        }
+    }
+    int ret = pthread_setaffinity_np(thread_native_handle, sizeof(cpu_set_t), &cpu_set);
+    if (ret != 0) {
+        std::cerr << "[ERROR] Failed to set Thread CPU affinity. Error : " << ret << std::endl;
+        return false;
+    }
+    return true;
+#elif WIN32
+    DWORD_PTR mask = 0;
+    for (int core : cores) {
+        if (core >= 0 && core < (int) (sizeof(DWORD_PTR) * 8)) {
+            mask |= (DWORD_PTR) 1 << core;
+        }
+    }
+    if (SetThreadAffinityMask(thread_native_handle, mask) == 0) {
+        std::cerr << "[ERROR] Failed to set Thread CPU affinity. Error: " << GetLastError() << std::endl;
+        return false;
+    }
+    return true;
+#else
+    (void) thread_native_handle;
+    std::cout << "[WARNING] Setting the CPU affinity of threads is not supported on this platform." << std::endl;
+    return false;
+#endif
+}
+
+} // namespace anira
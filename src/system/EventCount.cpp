@@ -0,0 +1,107 @@
+#include <anira/system/EventCount.h>
+#include <thread>
+
+#if __linux__
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+    #include <ctime>
+    #include <climits>
+#elif WIN32
+    #include <windows.h>
+#endif
+
+namespace anira {
+
+uint32_t EventCount::prepare_wait() {
+    m_num_waiters.fetch_add(1, std::memory_order_seq_cst);
+    // Pairs with the fence in notify, so that either the waiter sees the new condition or the notifier sees the waiter
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return m_epoch.load(std::memory_order_acquire);
+}
+
+void EventCount::cancel_wait() {
+    m_num_waiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void EventCount::wait(uint32_t key) {
+#if __linux__
+    // The futex returns early on signals and spurious wake ups, so we check the epoch again
+    while (m_epoch.load(std::memory_order_acquire) == key) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_epoch), FUTEX_WAIT_PRIVATE, key, nullptr, nullptr, 0);
+    }
+#elif WIN32
+    while (m_epoch.load(std::memory_order_acquire) == key) {
+        WaitOnAddress(&m_epoch, &key, sizeof(key), INFINITE);
+    }
+#else
+    m_epoch.wait(key, std::memory_order_acquire);
+#endif
+    m_num_waiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool EventCount::wait_until(uint32_t key, std::chrono::steady_clock::time_point deadline) {
+    bool notified = true;
+    while (m_epoch.load(std::memory_order_acquire) == key) {
+        auto remaining = deadline - std::chrono::steady_clock::now();
+        if (remaining <= std::chrono::nanoseconds::zero()) {
+            notified = false;
+            break;
+        }
+#if __linux__
+        // FUTEX_WAIT takes a relative timeout on CLOCK_MONOTONIC, which is what steady_clock is based on
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+        timespec timeout;
+        timeout.tv_sec = (time_t) seconds.count();
+        timeout.tv_nsec = (long) std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - seconds).count();
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_epoch), FUTEX_WAIT_PRIVATE, key, &timeout, nullptr, 0);
+#elif WIN32
+        // Rounded up, so that we do not wake up right before the deadline and spin
+        auto milliseconds = std::chrono::ceil<std::chrono::milliseconds>(remaining);
+        WaitOnAddress(&m_epoch, &key, sizeof(key), (DWORD) milliseconds.count());
+#else
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(remaining, std::chrono::microseconds(50)));
+#endif
+    }
+    m_num_waiters.fetch_sub(1, std::memory_order_relaxed);
+    return notified;
+}
+
+bool EventCount::notify_one() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_num_waiters.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+    m_epoch.fetch_add(1, std::memory_order_release);
+    wake(false);
+    return true;
+}
+
+void EventCount::notify_all() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_num_waiters.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    m_epoch.fetch_add(1, std::memory_order_release);
+    wake(true);
+}
+
+void EventCount::wake(bool all) {
+#if __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_epoch), FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, nullptr, nullptr, 0);
+#elif WIN32
+    if (all) {
+        WakeByAddressAll(&m_epoch);
+    } else {
+        WakeByAddressSingle(&m_epoch);
+    }
+#else
+    if (all) {
+        m_epoch.notify_all();
+    } else {
+        m_epoch.notify_one();
+    }
+#endif
+}
+
+} // namespace anira
@@ -27,18 +27,27 @@ void HighPriorityThread::start() {
         #endif
 
         elevate_priority(m_thread.native_handle());
+        CpuAffinity::set_thread_affinity(m_thread.native_handle(), m_cpu_affinity);
         m_is_running = true;
     }
 }
 
 void HighPriorityThread::stop() {
     m_should_exit = true;
+    wake_up();
     if (m_thread.joinable()) {
         m_thread.join();
         m_is_running = false;
     }
 }   
 
+void HighPriorityThread::set_cpu_affinity(const std::vector<int>& cores) {
+    m_cpu_affinity = cores;
+    if (m_thread.joinable()) {
+        CpuAffinity::set_thread_affinity(m_thread.native_handle(), m_cpu_affinity);
+    }
+}
+
 void HighPriorityThread::elevate_priority(std::thread::native_handle_type thread_native_handle, bool is_main_process) {
 #if WIN32
     if (is_main_process) {
@@ -0,0 +1,179 @@
+#include <anira/system/RealtimeLogger.h>
+#include <anira/system/CacheLine.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+
+namespace anira {
+
+namespace {
+
+struct LogRecord {
+    LogLevel m_level;
+    const char* m_message;
+    int m_session_id;
+};
+
+// Bounded multi-producer single-consumer ring. Every slot carries a sequence that tells whether it is free for the producer or filled for the consumer at a given position.
+class LogRing {
+public:
+    LogRing() {
+        for (size_t i = 0; i < RealtimeLogger::CAPACITY; ++i) {
+            m_slots[i].m_sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool try_push(const LogRecord& record) {
+        size_t position = m_enqueue_position.load(std::memory_order_relaxed);
+        // The number of attempts is bounded, so that a producer never waits for the others
+        for (int attempt = 0; attempt < 8; ++attempt) {
+            Slot& slot = m_slots[position % RealtimeLogger::CAPACITY];
+            intptr_t difference = (intptr_t) slot.m_sequence.load(std::memory_order_acquire) - (intptr_t) position;
+            if (difference == 0) {
+                if (m_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.m_record = record;
+                    slot.m_sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false; // full
+            } else {
+                position = m_enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+        return false;
+    }
+
+    bool try_pop(LogRecord& record) {
+        Slot& slot = m_slots[m_dequeue_position % RealtimeLogger::CAPACITY];
+        if ((intptr_t) slot.m_sequence.load(std::memory_order_acquire) - (intptr_t) (m_dequeue_position + 1) < 0) {
+            return false;
+        }
+        record = slot.m_record;
+        slot.m_sequence.store(m_dequeue_position + RealtimeLogger::CAPACITY, std::memory_order_release);
+        m_dequeue_position++;
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> m_sequence;
+        LogRecord m_record;
+    };
+
+    std::array<Slot, RealtimeLogger::CAPACITY> m_slots;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_enqueue_position{0};
+    alignas(CACHE_LINE_SIZE) size_t m_dequeue_position = 0;
+};
+
+struct RateLimit {
+    std::chrono::steady_clock::time_point m_last_print;
+    size_t m_num_suppressed = 0;
+};
+
+using RecordKey = std::tuple<LogLevel, const char*, int>;
+
+LogRing log_ring;
+std::atomic<size_t> num_dropped_records{0};
+
+// Everything below is only touched by the draining thread, which holds the drain mutex
+std::mutex drain_mutex;
+std::map<RecordKey, RateLimit> rate_limits;
+
+std::mutex thread_mutex;
+std::thread drain_thread;
+std::atomic<bool> drain_thread_should_exit{false};
+
+void print(LogLevel level, const char* message, int session_id, size_t num_suppressed) {
+    std::ostream& stream = level == LogLevel::Error ? std::cerr : std::cout;
+    switch (level) {
+        case LogLevel::Info: stream << "[INFO] "; break;
+        case LogLevel::Warning: stream << "[WARNING] "; break;
+        case LogLevel::Error: stream << "[ERROR] "; break;
+    }
+    stream << message;
+    if (session_id >= 0) {
+        stream << " in session: " << session_id;
+    }
+    stream << "!";
+    if (num_suppressed > 0) {
+        stream << " (repeated " << num_suppressed << " times)";
+    }
+    stream << std::endl;
+}
+
+void drain(bool force) {
+    std::lock_guard<std::mutex> lock(drain_mutex);
+    auto now = std::chrono::steady_clock::now();
+
+    LogRecord record;
+    while (log_ring.try_pop(record)) {
+        RecordKey key = {record.m_level, record.m_message, record.m_session_id};
+        auto it = rate_limits.find(key);
+        if (it == rate_limits.end()) {
+            print(record.m_level, record.m_message, record.m_session_id, 0);
+            rate_limits[key] = {now, 0};
+        } else {
+            it->second.m_num_suppressed++;
+        }
+    }
+
+    // Once the interval of a message has passed, its suppressed repetitions are summarized and it may be printed again
+    for (auto it = rate_limits.begin(); it != rate_limits.end();) {
+        if (force || now - it->second.m_last_print >= RealtimeLogger::RATE_LIMIT_INTERVAL) {
+            if (it->second.m_num_suppressed > 0) {
+                print(std::get<0>(it->first), std::get<1>(it->first), std::get<2>(it->first), it->second.m_num_suppressed);
+            }
+            it = rate_limits.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    size_t num_dropped = num_dropped_records.exchange(0, std::memory_order_relaxed);
+    if (num_dropped > 0) {
+        std::cout << "[WARNING] " << num_dropped << " log messages were dropped, because the real-time log was full!" << std::endl;
+    }
+}
+
+} // namespace
+
+void RealtimeLogger::log(LogLevel level, const char* message, int session_id) {
+    if (!log_ring.try_push({level, message, session_id})) {
+        num_dropped_records.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void RealtimeLogger::start() {
+    std::lock_guard<std::mutex> lock(thread_mutex);
+    if (drain_thread.joinable()) {
+        return;
+    }
+    drain_thread_should_exit.store(false);
+    drain_thread = std::thread([]() {
+        while (!drain_thread_should_exit.load()) {
+            drain(false);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+}
+
+void RealtimeLogger::stop() {
+    std::lock_guard<std::mutex> lock(thread_mutex);
+    if (drain_thread.joinable()) {
+        drain_thread_should_exit.store(true);
+        drain_thread.join();
+    }
+    drain(true);
+}
+
+void RealtimeLogger::flush() {
+    drain(true);
+}
+
+} // namespace anira
@@ -0,0 +1,263 @@
+#include <anira/utils/Allocator.h>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+
+#if WIN32
+    #include <windows.h>
+    #include <malloc.h>
+#else
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace anira {
+
+namespace {
+
+std::atomic<bool> lock_memory{false};
+std::atomic<bool> use_huge_pages{false};
+
+void* aligned_malloc(size_t num_bytes, size_t alignment) {
+#if WIN32
+    return _aligned_malloc(num_bytes, alignment);
+#else
+    void* data = nullptr;
+    if (posix_memalign(&data, alignment, num_bytes) != 0) {
+        return nullptr;
+    }
+    return data;
+#endif
+}
+
+void aligned_free(void* data) {
+#if WIN32
+    _aligned_free(data);
+#else
+    free(data);
+#endif
+}
+
+void lock(void* data, size_t num_bytes) {
+#if WIN32
+    if (!VirtualLock(data, num_bytes)) {
+        std::cerr << "[ERROR] Failed to lock memory. Error: " << GetLastError() << std::endl;
+    }
+#else
+    if (mlock(data, num_bytes) != 0) {
+        std::cerr << "[ERROR] Failed to lock memory. Error : " << errno << std::endl;
+        std::cout << "[WARNING] Increase the memlock limit of the user, e.g. in /etc/security/limits.conf." << std::endl;
+    }
+#endif
+}
+
+void unlock(void* data, size_t num_bytes) {
+#if WIN32
+    VirtualUnlock(data, num_bytes);
+#else
+    munlock(data, num_bytes);
+#endif
+}
+
+size_t get_page_size() {
+#if WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (size_t) info.dwPageSize;
+#else
+    return (size_t) sysconf(_SC_PAGESIZE);
+#endif
+}
+
+// Every block starts with this header, so that it is freed the way it was allocated even if the options changed meanwhile
+struct BlockHeader {
+    size_t m_num_mapped_bytes; // 0 if the block was not mapped
+    size_t m_num_locked_bytes; // 0 if the block was not locked on its own pages
+    size_t m_num_arena_bytes; // 0 if the block was not carved out of the locked arena
+};
+static_assert(sizeof(BlockHeader) <= CACHE_LINE_SIZE);
+
+// Locking every small block on its own pages would count a whole page per block against the memlock limit. Instead, small locked blocks are carved out of chunks that are locked once.
+// The slots have power of two sizes, freed slots are kept in one free list per size and reused. The chunks stay locked until the process exits.
+class LockedArena {
+public:
+    static constexpr size_t MIN_SLOT_SIZE = 2 * CACHE_LINE_SIZE;
+    static constexpr size_t NUM_SLOT_SIZES = std::bit_width(MemoryOptions::LOCKED_ARENA_THRESHOLD / MIN_SLOT_SIZE);
+
+    // Never destroyed, so that static objects can still free their blocks at exit
+    static LockedArena& get_instance() {
+        static LockedArena* arena = new LockedArena();
+        return *arena;
+    }
+
+    static size_t get_slot_size(size_t num_bytes) {
+        return std::bit_ceil(num_bytes < MIN_SLOT_SIZE ? MIN_SLOT_SIZE : num_bytes);
+    }
+
+    void* allocate(size_t slot_size) {
+        size_t index = get_slot_index(slot_size);
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (m_free_slots[index] != nullptr) {
+            FreeSlot* slot = m_free_slots[index];
+            m_free_slots[index] = slot->m_next;
+            return slot;
+        }
+        if (m_chunk == nullptr || m_chunk_position + slot_size > MemoryOptions::LOCKED_ARENA_CHUNK_SIZE) {
+            // The rest of the previous chunk is left unused. Chunks are page aligned, so the slots of all sizes stay aligned to their size.
+            char* chunk = static_cast<char*>(aligned_malloc(MemoryOptions::LOCKED_ARENA_CHUNK_SIZE, get_page_size()));
+            if (chunk == nullptr) {
+                return nullptr;
+            }
+            lock(chunk, MemoryOptions::LOCKED_ARENA_CHUNK_SIZE);
+            m_chunk = chunk;
+            m_chunk_position = 0;
+        }
+        void* slot = m_chunk + m_chunk_position;
+        m_chunk_position += slot_size;
+        return slot;
+    }
+
+    void deallocate(void* data, size_t slot_size) {
+        size_t index = get_slot_index(slot_size);
+        std::lock_guard<std::mutex> guard(m_mutex);
+        FreeSlot* slot = static_cast<FreeSlot*>(data);
+        slot->m_next = m_free_slots[index];
+        m_free_slots[index] = slot;
+    }
+
+private:
+    struct FreeSlot {
+        FreeSlot* m_next;
+    };
+
+    static size_t get_slot_index(size_t slot_size) {
+        return (size_t) std::countr_zero(slot_size / MIN_SLOT_SIZE);
+    }
+
+    std::mutex m_mutex;
+    std::array<FreeSlot*, NUM_SLOT_SIZES> m_free_slots{};
+    char* m_chunk = nullptr;
+    size_t m_chunk_position = 0;
+};
+
+// The data follows the header after one cache line. mlock and munlock work on whole pages, so large locked blocks are page aligned and span whole pages. Otherwise unlocking a block would also unlock the neighbouring blocks on its first and last page.
+void* allocate_block(size_t num_bytes, bool allow_huge_pages) {
+    if (num_bytes == 0) {
+        return nullptr;
+    }
+    size_t num_total_bytes = num_bytes + CACHE_LINE_SIZE;
+    size_t alignment = CACHE_LINE_SIZE;
+    bool locked = MemoryOptions::get_lock_memory();
+    if (locked && num_total_bytes <= MemoryOptions::LOCKED_ARENA_THRESHOLD) {
+        size_t slot_size = LockedArena::get_slot_size(num_total_bytes);
+        void* block = LockedArena::get_instance().allocate(slot_size);
+        if (block == nullptr) {
+            std::cerr << "[ERROR] Failed to allocate memory!" << std::endl;
+            return nullptr;
+        }
+        *static_cast<BlockHeader*>(block) = {0, 0, slot_size};
+        return static_cast<char*>(block) + CACHE_LINE_SIZE;
+    }
+    if (locked) {
+        size_t page_size = get_page_size();
+        alignment = page_size > alignment ? page_size : alignment;
+        num_total_bytes = (num_total_bytes + alignment - 1) / alignment * alignment;
+    }
+    BlockHeader header = {0, locked ? num_total_bytes : 0, 0};
+    void* block = nullptr;
+
+#if __linux__
+    if (allow_huge_pages && MemoryOptions::get_use_huge_pages() && num_bytes >= HugePageAllocator::HUGE_PAGE_SIZE) {
+        size_t num_mapped_bytes = (num_total_bytes + HugePageAllocator::HUGE_PAGE_SIZE - 1) / HugePageAllocator::HUGE_PAGE_SIZE * HugePageAllocator::HUGE_PAGE_SIZE;
+        block = mmap(nullptr, num_mapped_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (block == MAP_FAILED) {
+            // No huge pages reserved, so we ask for transparent huge pages instead
+            block = mmap(nullptr, num_mapped_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (block != MAP_FAILED) {
+                madvise(block, num_mapped_bytes, MADV_HUGEPAGE);
+            }
+        }
+        if (block == MAP_FAILED) {
+            block = nullptr;
+        } else {
+            header.m_num_mapped_bytes = num_mapped_bytes;
+        }
+    }
+#else
+    (void) allow_huge_pages;
+#endif
+    if (block == nullptr) {
+        block = aligned_malloc(num_total_bytes, alignment);
+        if (block == nullptr) {
+            std::cerr << "[ERROR] Failed to allocate memory!" << std::endl;
+            return nullptr;
+        }
+    }
+
+    *static_cast<BlockHeader*>(block) = header;
+    if (header.m_num_locked_bytes > 0) {
+        lock(block, header.m_num_locked_bytes);
+    }
+    return static_cast<char*>(block) + CACHE_LINE_SIZE;
+}
+
+void deallocate_block(void* data) {
+    if (data == nullptr) {
+        return;
+    }
+    void* block = static_cast<char*>(data) - CACHE_LINE_SIZE;
+    BlockHeader header = *static_cast<BlockHeader*>(block);
+    if (header.m_num_arena_bytes > 0) {
+        LockedArena::get_instance().deallocate(block, header.m_num_arena_bytes);
+        return;
+    }
+    if (header.m_num_locked_bytes > 0) {
+        unlock(block, header.m_num_locked_bytes);
+    }
+#if __linux__
+    if (header.m_num_mapped_bytes > 0) {
+        munmap(block, header.m_num_mapped_bytes);
+        return;
+    }
+#endif
+    aligned_free(block);
+}
+
+} // namespace
+
+void MemoryOptions::set_lock_memory(bool lock) {
+    lock_memory.store(lock);
+}
+
+bool MemoryOptions::get_lock_memory() {
+    return lock_memory.load();
+}
+
+void MemoryOptions::set_use_huge_pages(bool use) {
+    use_huge_pages.store(use);
+}
+
+bool MemoryOptions::get_use_huge_pages() {
+    return use_huge_pages.load();
+}
+
+void* AlignedAllocator::allocate(size_t num_bytes) {
+    return allocate_block(num_bytes, false);
+}
+
+void AlignedAllocator::deallocate(void* data, size_t) {
+    deallocate_block(data);
+}
+
+void* HugePageAllocator::allocate(size_t num_bytes) {
+    return allocate_block(num_bytes, true);
+}
+
+void HugePageAllocator::deallocate(void* data, size_t) {
+    deallocate_block(data);
+}
+
+} // namespace anira
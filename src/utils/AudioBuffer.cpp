@@ -1,4 +1,5 @@
 #include <anira/utils/AudioBuffer.h>
 
 template class anira::AudioBuffer<float>;
-template class anira::AudioBuffer<int>;
\ No newline at end of file
+template class anira::AudioBuffer<int>;
+template class anira::AudioBuffer<float, anira::HugePageAllocator>;
\ No newline at end of file
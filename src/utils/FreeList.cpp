@@ -0,0 +1,60 @@
+#include <anira/utils/FreeList.h>
+#include <algorithm>
+#include <bit>
+#include <thread>
+
+namespace anira {
+
+FreeList::FreeList(size_t size) {
+    resize(size);
+}
+
+void FreeList::resize(size_t size) {
+    m_size = size;
+    m_words = std::vector<std::atomic<uint64_t>>((size + BITS_PER_WORD - 1) / BITS_PER_WORD);
+    for (size_t i = 0; i < m_words.size(); ++i) {
+        size_t num_bits = std::min(size - i * BITS_PER_WORD, BITS_PER_WORD);
+        m_words[i].store(num_bits == BITS_PER_WORD ? ~uint64_t(0) : (uint64_t(1) << num_bits) - 1, std::memory_order_relaxed);
+    }
+}
+
+size_t FreeList::get_size() const {
+    return m_size;
+}
+
+bool FreeList::try_acquire(size_t& index) {
+    for (size_t i = 0; i < m_words.size(); ++i) {
+        uint64_t word = m_words[i].load(std::memory_order_relaxed);
+        // A failed compare and swap reloads the word, so we retry with the bits that are still free
+        while (word != 0) {
+            int bit = std::countr_zero(word);
+            if (m_words[i].compare_exchange_weak(word, word & ~(uint64_t(1) << bit), std::memory_order::acquire, std::memory_order_relaxed)) {
+                index = i * BITS_PER_WORD + (size_t) bit;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+size_t FreeList::acquire() {
+    size_t index;
+    while (!try_acquire(index)) {
+        std::this_thread::yield();
+    }
+    return index;
+}
+
+void FreeList::acquire_index(size_t index) {
+    std::atomic<uint64_t>& word = m_words[index / BITS_PER_WORD];
+    uint64_t bit = uint64_t(1) << (index % BITS_PER_WORD);
+    while (!(word.fetch_and(~bit, std::memory_order::acquire) & bit)) {
+        std::this_thread::yield();
+    }
+}
+
+void FreeList::release(size_t index) {
+    m_words[index / BITS_PER_WORD].fetch_or(uint64_t(1) << (index % BITS_PER_WORD), std::memory_order::release);
+}
+
+} // namespace anira
@@ -0,0 +1,83 @@
+#include <anira/utils/LatencyHistogram.h>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace anira {
+
+void LatencyHistogram::record(std::chrono::nanoseconds duration) {
+    uint64_t value = (uint64_t) std::max<int64_t>(duration.count(), 0);
+    m_buckets[get_bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::get_count() const {
+    return (size_t) m_count.load(std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds LatencyHistogram::get_percentile(double percentile) const {
+    uint64_t total = 0;
+    for (auto& bucket : m_buckets) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return std::chrono::nanoseconds(0);
+    }
+    uint64_t target = std::max<uint64_t>((uint64_t) std::ceil(std::clamp(percentile, 0., 100.) / 100. * (double) total), 1);
+    uint64_t cumulated = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        cumulated += m_buckets[i].load(std::memory_order_relaxed);
+        if (cumulated >= target) {
+            // The largest recorded value is exact, so the bound of its bucket is never reported above it
+            return std::chrono::nanoseconds((int64_t) std::min(get_bucket_upper_bound(i), m_max.load(std::memory_order_relaxed)));
+        }
+    }
+    return std::chrono::nanoseconds((int64_t) m_max.load(std::memory_order_relaxed));
+}
+
+LatencyStatistics LatencyHistogram::get_statistics() const {
+    LatencyStatistics statistics;
+    statistics.m_count = get_count();
+    if (statistics.m_count > 0) {
+        statistics.m_mean = std::chrono::nanoseconds((int64_t) (m_sum.load(std::memory_order_relaxed) / statistics.m_count));
+    }
+    statistics.m_p50 = get_percentile(50.);
+    statistics.m_p90 = get_percentile(90.);
+    statistics.m_p99 = get_percentile(99.);
+    statistics.m_max = std::chrono::nanoseconds((int64_t) m_max.load(std::memory_order_relaxed));
+    return statistics;
+}
+
+size_t LatencyHistogram::get_bucket_index(uint64_t value) {
+    value = std::min<uint64_t>(value, (uint64_t(1) << MAX_EXPONENT) - 1);
+    if (value < SUB_BUCKETS) {
+        return (size_t) value;
+    }
+    // The highest bit selects the power of two, the following SUB_BUCKET_BITS bits the linear bucket within it
+    int shift = (int) std::bit_width(value) - 1 - SUB_BUCKET_BITS;
+    return (size_t) (shift + 1) * SUB_BUCKETS + (size_t) ((value >> shift) - SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::get_bucket_upper_bound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    int shift = (int) (index / SUB_BUCKETS) - 1;
+    uint64_t sub_bucket = index % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub_bucket + 1) << shift) - 1;
+}
+
+} // namespace anira
@@ -0,0 +1,125 @@
+#include <anira/utils/MirroredMemory.h>
+#include <anira/utils/Allocator.h>
+#include <iostream>
+#include <utility>
+
+#if __linux__
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace anira {
+
+MirroredMemory::~MirroredMemory() {
+    deallocate();
+}
+
+MirroredMemory::MirroredMemory(MirroredMemory&& other) noexcept :
+    m_data(std::exchange(other.m_data, nullptr)),
+    m_size(std::exchange(other.m_size, 0)),
+    m_locked(std::exchange(other.m_locked, false))
+{
+}
+
+MirroredMemory& MirroredMemory::operator=(MirroredMemory&& other) noexcept {
+    if (this != &other) {
+        deallocate();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_locked = std::exchange(other.m_locked, false);
+    }
+    return *this;
+}
+
+bool MirroredMemory::allocate(size_t num_bytes) {
+    deallocate();
+    if (num_bytes == 0) {
+        return true;
+    }
+#if __linux__
+    size_t page_size = get_page_size();
+    size_t size = (num_bytes + page_size - 1) / page_size * page_size;
+
+    int fd = memfd_create("anira_mirrored_memory", MFD_CLOEXEC);
+    if (fd == -1) {
+        std::cerr << "[ERROR] Failed to create the file of the mirrored memory. Error: " << errno << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, (off_t) size) != 0) {
+        std::cerr << "[ERROR] Failed to resize the file of the mirrored memory. Error: " << errno << std::endl;
+        close(fd);
+        return false;
+    }
+
+    // Reserve the address range of both mappings first, so that nothing else can be mapped in between
+    char* region = static_cast<char*>(mmap(nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    bool success = region != MAP_FAILED;
+    if (success) {
+        success = mmap(region, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED &&
+                  mmap(region + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+        if (!success) {
+            munmap(region, 2 * size);
+        }
+    }
+    // The mappings keep the file alive
+    close(fd);
+    if (!success) {
+        std::cerr << "[ERROR] Failed to map the mirrored memory. Error: " << errno << std::endl;
+        return false;
+    }
+
+    m_data = region;
+    m_size = size;
+    if (MemoryOptions::get_lock_memory()) {
+        if (mlock(m_data, 2 * m_size) == 0) {
+            m_locked = true;
+        } else {
+            std::cerr << "[ERROR] Failed to lock memory. Error : " << errno << std::endl;
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void MirroredMemory::deallocate() {
+    if (m_data == nullptr) {
+        return;
+    }
+#if __linux__
+    if (m_locked) {
+        munlock(m_data, 2 * m_size);
+    }
+    munmap(m_data, 2 * m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_locked = false;
+}
+
+void* MirroredMemory::data() const {
+    return m_data;
+}
+
+size_t MirroredMemory::get_size() const {
+    return m_size;
+}
+
+bool MirroredMemory::is_supported() {
+#if __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+size_t MirroredMemory::get_page_size() {
+#if __linux__
+    return (size_t) sysconf(_SC_PAGESIZE);
+#else
+    return 4096;
+#endif
+}
+
+} // namespace anira
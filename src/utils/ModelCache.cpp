@@ -0,0 +1,130 @@
+#include <anira/utils/ModelCache.h>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+namespace anira {
+
+namespace {
+
+// Different binary models must never share a key, so they are identified by a cryptographic digest instead of std::hash
+class Sha256 {
+public:
+    void update(const unsigned char* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            m_block[m_block_size++] = data[i];
+            if (m_block_size == m_block.size()) {
+                transform();
+                m_block_size = 0;
+            }
+        }
+        m_num_bits += (uint64_t) size * 8;
+    }
+
+    std::string hex_digest() {
+        uint64_t num_bits = m_num_bits;
+        unsigned char padding = 0x80;
+        update(&padding, 1);
+        padding = 0;
+        while (m_block_size != 56) {
+            update(&padding, 1);
+        }
+        for (int i = 7; i >= 0; --i) {
+            unsigned char byte = (unsigned char) (num_bits >> (8 * i));
+            update(&byte, 1);
+        }
+        std::ostringstream digest;
+        for (uint32_t value : m_state) {
+            digest << std::hex << std::setw(8) << std::setfill('0') << value;
+        }
+        return digest.str();
+    }
+
+private:
+    static uint32_t rotate_right(uint32_t value, int bits) {
+        return (value >> bits) | (value << (32 - bits));
+    }
+
+    void transform() {
+        static constexpr std::array<uint32_t, 64> k = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+        std::array<uint32_t, 64> w;
+        for (size_t i = 0; i < 16; ++i) {
+            w[i] = (uint32_t) m_block[4 * i] << 24 | (uint32_t) m_block[4 * i + 1] << 16 | (uint32_t) m_block[4 * i + 2] << 8 | (uint32_t) m_block[4 * i + 3];
+        }
+        for (size_t i = 16; i < 64; ++i) {
+            uint32_t s0 = rotate_right(w[i - 15], 7) ^ rotate_right(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotate_right(w[i - 2], 17) ^ rotate_right(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        std::array<uint32_t, 8> v = m_state;
+        for (size_t i = 0; i < 64; ++i) {
+            uint32_t s1 = rotate_right(v[4], 6) ^ rotate_right(v[4], 11) ^ rotate_right(v[4], 25);
+            uint32_t choice = (v[4] & v[5]) ^ (~v[4] & v[6]);
+            uint32_t temp1 = v[7] + s1 + choice + k[i] + w[i];
+            uint32_t s0 = rotate_right(v[0], 2) ^ rotate_right(v[0], 13) ^ rotate_right(v[0], 22);
+            uint32_t majority = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+            uint32_t temp2 = s0 + majority;
+            v = {temp1 + temp2, v[0], v[1], v[2], v[3] + temp1, v[4], v[5], v[6]};
+        }
+        for (size_t i = 0; i < 8; ++i) {
+            m_state[i] += v[i];
+        }
+    }
+
+    std::array<uint32_t, 8> m_state = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    std::array<unsigned char, 64> m_block{};
+    size_t m_block_size = 0;
+    uint64_t m_num_bits = 0;
+};
+
+} // namespace
+
+std::string ModelCache::get_key(InferenceConfig& inference_config, InferenceBackend backend) {
+    std::ostringstream key;
+    key << backend << "|";
+
+    const ModelData* model_data = inference_config.get_model_data(backend);
+    if (model_data != nullptr && model_data->m_is_binary) {
+        Sha256 sha256;
+        sha256.update(static_cast<const unsigned char*>(model_data->m_data), model_data->m_size);
+        key << "binary|" << model_data->m_size << "|" << sha256.hex_digest();
+    } else if (model_data != nullptr) {
+        // Hashing a large model file would take as long as loading it, so a changed file is detected by its modification time and size instead
+        std::string model_path = inference_config.get_model_path(backend);
+        key << "file|" << model_path;
+        std::error_code error;
+        auto last_write_time = std::filesystem::last_write_time(model_path, error);
+        if (!error) {
+            key << "|" << last_write_time.time_since_epoch().count();
+        }
+        auto file_size = std::filesystem::file_size(model_path, error);
+        if (!error) {
+            key << "|" << file_size;
+        }
+    }
+
+    for (const TensorShapeList& shapes : {inference_config.get_input_shape(backend), inference_config.get_output_shape(backend)}) {
+        key << "|";
+        for (const auto& shape : shapes) {
+            key << "[";
+            for (int64_t dimension : shape) {
+                key << dimension << ",";
+            }
+            key << "]";
+        }
+    }
+    return key.str();
+}
+
+} // namespace anira
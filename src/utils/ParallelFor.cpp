@@ -0,0 +1,44 @@
+#include <anira/utils/ParallelFor.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+namespace anira {
+
+void parallel_for(size_t count, const std::function<void(size_t index)>& task, unsigned int max_threads) {
+    std::atomic<size_t> next_index{0};
+    std::exception_ptr exception = nullptr;
+    std::mutex exception_mutex;
+
+    // The indices are handed out one by one, so that a slow task does not hold back the ones assigned to the same thread
+    auto work = [&]() {
+        for (size_t index = next_index.fetch_add(1); index < count; index = next_index.fetch_add(1)) {
+            try {
+                task(index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(exception_mutex);
+                if (exception == nullptr) {
+                    exception = std::current_exception();
+                }
+            }
+        }
+    };
+
+    size_t num_threads = std::min<size_t>(count, std::max(max_threads, 1u));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; ++i) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (exception != nullptr) {
+        std::rethrow_exception(exception);
+    }
+}
+
+} // namespace anira
@@ -0,0 +1,248 @@
+#include <anira/utils/Resampler.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+
+#if defined(__SSE__) || defined(_M_X64)
+    #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+    #include <arm_neon.h>
+#endif
+
+namespace anira {
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+int64_t floor_div(int64_t a, int64_t b) {
+    int64_t quotient = a / b;
+    return (a % b != 0 && a < 0) ? quotient - 1 : quotient;
+}
+
+#if defined(__SSE__) || defined(_M_X64)
+float horizontal_sum(__m128 sum4) {
+    sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+    sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 0x55));
+    return _mm_cvtss_f32(sum4);
+}
+
+float dot_product_sse(const float* a, const float* b, size_t size) {
+    size_t i = 0;
+    __m128 sum4 = _mm_setzero_ps();
+    for (; i + 4 <= size; i += 4) {
+        sum4 = _mm_add_ps(sum4, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    float result = horizontal_sum(sum4);
+    for (; i < size; ++i) {
+        result += a[i] * b[i];
+    }
+    return result;
+}
+
+// GCC and Clang compile this kernel for AVX and FMA regardless of the target flags, it is only called if the CPU supports both. MSVC can only use it when the whole build targets AVX2.
+#if defined(__GNUC__) || defined(__AVX2__)
+#if defined(__GNUC__)
+__attribute__((target("avx,fma")))
+#endif
+float dot_product_avx_fma(const float* a, const float* b, size_t size) {
+    size_t i = 0;
+    __m256 sum8 = _mm256_setzero_ps();
+    for (; i + 8 <= size; i += 8) {
+        sum8 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum8);
+    }
+    __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+    for (; i + 4 <= size; i += 4) {
+        sum4 = _mm_add_ps(sum4, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    float result = horizontal_sum(sum4);
+    for (; i < size; ++i) {
+        result += a[i] * b[i];
+    }
+    return result;
+}
+#define ANIRA_RESAMPLER_AVX_FMA
+#endif
+
+using DotProduct = float (*)(const float*, const float*, size_t);
+
+DotProduct select_dot_product() {
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx") && __builtin_cpu_supports("fma")) {
+        return dot_product_avx_fma;
+    }
+#elif defined(ANIRA_RESAMPLER_AVX_FMA)
+    return dot_product_avx_fma;
+#endif
+    return dot_product_sse;
+}
+#endif
+
+} // namespace
+
+bool Resampler::prepare(double input_sample_rate, double output_sample_rate, size_t num_channels, size_t max_num_input_samples) {
+    int64_t input_rate = std::llround(input_sample_rate);
+    int64_t output_rate = std::llround(output_sample_rate);
+    if (input_rate <= 0 || output_rate <= 0) {
+        std::cerr << "[ERROR] The sample rates of the resampler must be positive!" << std::endl;
+        return false;
+    }
+    int64_t divisor = std::gcd(input_rate, output_rate);
+    if (input_rate / divisor > MAX_FACTOR || output_rate / divisor > MAX_FACTOR) {
+        std::cerr << "[ERROR] Cannot resample from " << input_rate << " Hz to " << output_rate << " Hz, the ratio of the sample rates is too complex!" << std::endl;
+        return false;
+    }
+    m_up = output_rate / divisor;
+    m_down = input_rate / divisor;
+    m_num_channels = num_channels;
+    m_max_num_input_samples = std::max<size_t>(max_num_input_samples, 1);
+
+    // The upsampled signal has to be band limited to the lower of both Nyquist frequencies, so the filter gets longer for larger factors. The taps are rounded up to whole SIMD vectors.
+    int64_t max_factor = std::max(m_up, m_down);
+    m_num_taps = (size_t) ((2 * (int64_t) NUM_ZERO_CROSSINGS * max_factor + m_up - 1) / m_up);
+    m_num_taps = (m_num_taps + 3) / 4 * 4;
+    size_t length = m_num_taps * (size_t) m_up;
+    double cutoff = 0.5 * CUTOFF / (double) max_factor;
+    double center = (double) (length - 1) / 2.;
+
+    std::vector<double> prototype(length);
+    double sum = 0.;
+    for (size_t n = 0; n < length; ++n) {
+        double x = 2. * PI * cutoff * ((double) n - center);
+        double sinc = x == 0. ? 1. : std::sin(x) / x;
+        double phase = 2. * PI * (double) n / (double) (length - 1);
+        double blackman = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2. * phase);
+        prototype[n] = 2. * cutoff * sinc * blackman;
+        sum += prototype[n];
+    }
+    // Only every m_up-th sample of the upsampled signal is not zero, so each phase gets a gain of about one
+    double gain = (double) m_up / sum;
+
+    m_filters.resize((size_t) m_up * m_num_taps);
+    for (size_t phase_index = 0; phase_index < (size_t) m_up; ++phase_index) {
+        for (size_t tap = 0; tap < m_num_taps; ++tap) {
+            m_filters[phase_index * m_num_taps + tap] = (float) (prototype[phase_index + (m_num_taps - 1 - tap) * (size_t) m_up] * gain);
+        }
+    }
+
+    m_buffer.resize(num_channels, m_num_taps + m_max_num_input_samples);
+    reset();
+    return true;
+}
+
+void Resampler::reset() {
+    m_buffer.clear();
+    m_position = 0;
+}
+
+size_t Resampler::process(const float* const* input, size_t num_input_samples, float* const* output, size_t max_num_output_samples) {
+    size_t num_output_samples = 0;
+    size_t offset = 0;
+    // The history buffer holds at most m_max_num_input_samples new samples at once. Without input, outputs that only need the history are still produced.
+    do {
+        size_t num_block_samples = std::min(num_input_samples - offset, m_max_num_input_samples);
+        num_output_samples += process_block(input, offset, num_block_samples, output, num_output_samples, max_num_output_samples - num_output_samples);
+        offset += num_block_samples;
+    } while (offset < num_input_samples);
+    return num_output_samples;
+}
+
+size_t Resampler::process_block(const float* const* input, size_t input_offset, size_t num_input_samples, float* const* output, size_t output_offset, size_t max_num_output_samples) {
+    for (size_t channel = 0; channel < m_num_channels; ++channel) {
+        std::copy_n(input[channel] + input_offset, num_input_samples, m_buffer.get_write_pointer(channel, m_num_taps));
+    }
+
+    size_t num_output_samples = 0;
+    while (num_output_samples < max_num_output_samples) {
+        int64_t input_index = floor_div(m_position, m_up);
+        if (input_index >= (int64_t) num_input_samples) {
+            break;
+        }
+        const float* filter = m_filters.data() + (size_t) (m_position - input_index * m_up) * m_num_taps;
+        // The filter ends at the input sample, which lies behind the m_num_taps samples of history
+        size_t start = (size_t) (input_index + 1);
+        for (size_t channel = 0; channel < m_num_channels; ++channel) {
+            output[channel][output_offset + num_output_samples] = dot_product(filter, m_buffer.get_read_pointer(channel, start), m_num_taps);
+        }
+        num_output_samples++;
+        m_position += m_down;
+    }
+    m_position -= (int64_t) num_input_samples * m_up;
+    if (num_input_samples == 0) {
+        return num_output_samples;
+    }
+
+    for (size_t channel = 0; channel < m_num_channels; ++channel) {
+        float* data = m_buffer.get_write_pointer(channel);
+        std::copy(data + num_input_samples, data + num_input_samples + m_num_taps, data);
+    }
+    return num_output_samples;
+}
+
+size_t Resampler::get_num_output_samples(size_t num_input_samples) const {
+    int64_t end = (int64_t) num_input_samples * m_up;
+    if (end <= m_position) {
+        return 0;
+    }
+    return (size_t) ((end - m_position + m_down - 1) / m_down);
+}
+
+size_t Resampler::get_num_input_samples(size_t num_output_samples) const {
+    if (num_output_samples == 0) {
+        return 0;
+    }
+    int64_t last_input_index = floor_div(m_position + (int64_t) (num_output_samples - 1) * m_down, m_up);
+    return last_input_index < 0 ? 0 : (size_t) last_input_index + 1;
+}
+
+size_t Resampler::get_max_num_output_samples(size_t num_input_samples) const {
+    // The next output lies at most one input sample before the block
+    return (size_t) (((int64_t) (num_input_samples + 1) * m_up + m_down - 1) / m_down);
+}
+
+size_t Resampler::get_max_num_input_samples(size_t num_output_samples) const {
+    if (num_output_samples == 0) {
+        return 0;
+    }
+    // The next output lies less than m_down upsampled samples after the start of the block
+    return (size_t) (((int64_t) num_output_samples * m_down - 1) / m_up) + 1;
+}
+
+double Resampler::get_delay() const {
+    return (double) (m_num_taps * (size_t) m_up - 1) / (2. * (double) m_up);
+}
+
+int64_t Resampler::get_up_factor() const {
+    return m_up;
+}
+
+int64_t Resampler::get_down_factor() const {
+    return m_down;
+}
+
+float Resampler::dot_product(const float* a, const float* b, size_t size) {
+#if defined(__SSE__) || defined(_M_X64)
+    // Selected once on the first call
+    static const DotProduct dot_product_x86 = select_dot_product();
+    return dot_product_x86(a, b, size);
+#else
+    size_t i = 0;
+    float result = 0.f;
+#if defined(__ARM_NEON) || defined(__aarch64__)
+    float32x4_t sum4 = vdupq_n_f32(0.f);
+    for (; i + 4 <= size; i += 4) {
+        sum4 = vmlaq_f32(sum4, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    float32x2_t sum2 = vadd_f32(vget_low_f32(sum4), vget_high_f32(sum4));
+    result = vget_lane_f32(vpadd_f32(sum2, sum2), 0);
+#endif
+    for (; i < size; ++i) {
+        result += a[i] * b[i];
+    }
+    return result;
+#endif
+}
+
+} // namespace anira
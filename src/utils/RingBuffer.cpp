@@ -1,68 +1,231 @@
 #include <anira/utils/RingBuffer.h>
+#include <algorithm>
+#include <numeric>
 
 namespace anira {
 
 RingBuffer::RingBuffer() = default;
 
-void RingBuffer::initialize_with_positions(size_t num_channels, size_t num_samples) {
-    resize(num_channels, num_samples);
-    m_read_pos.resize(get_num_channels());
-    m_write_pos.resize(get_num_channels());
+void RingBuffer::initialize_with_positions(size_t num_channels, size_t num_samples, bool mirrored, size_t window_hop) {
+    m_mirrors.clear();
+    m_channels.clear();
+    if (mirrored && MirroredMemory::is_supported()) {
+        size_t multiple = std::lcm(std::max<size_t>(window_hop, 1), MirroredMemory::get_page_size() / sizeof(float));
+        num_samples = (num_samples + multiple - 1) / multiple * multiple;
+        m_mirrors.resize(num_channels);
+        for (auto& mirror : m_mirrors) {
+            if (!mirror.allocate(num_samples * sizeof(float))) {
+                m_mirrors.clear();
+                break;
+            }
+        }
+    }
 
-    for (size_t i = 0; i < m_read_pos.size(); i++) {
-        m_read_pos[i] = 0;
-        m_write_pos[i] = 0;
+    if (!m_mirrors.empty()) {
+        m_buffer.resize(0, 0);
+        m_capacity = m_mirrors[0].get_size() / sizeof(float);
+        for (auto& mirror : m_mirrors) {
+            m_channels.push_back(static_cast<float*>(mirror.data()));
+        }
+    } else {
+        if (mirrored) {
+            std::cout << "[WARNING] Mirrored ring buffers are not supported on this platform, falling back to a regular ring buffer." << std::endl;
+        }
+        m_buffer.resize(num_channels, num_samples);
+        m_capacity = num_samples;
+        for (size_t i = 0; i < num_channels; i++) {
+            m_channels.push_back(m_buffer.get_write_pointer(i));
+        }
     }
+    // std::atomic is neither copyable nor movable, so the positions are recreated instead of resized
+    m_read_pos = std::vector<Position>(num_channels);
+    m_write_pos = std::vector<Position>(num_channels);
 }
 
 void RingBuffer::clear_with_positions() {
     clear();
     for (size_t i = 0; i < m_read_pos.size(); i++) {
-        m_read_pos[i] = 0;
-        m_write_pos[i] = 0;
+        m_read_pos[i].m_value.store(0, std::memory_order_relaxed);
+        m_write_pos[i].m_value.store(0, std::memory_order_relaxed);
     }
 }
 
 void RingBuffer::push_sample(size_t channel, float sample) {
-    set_sample(channel, m_write_pos[channel], sample);
+    size_t write_pos = m_write_pos[channel].m_value.load(std::memory_order_relaxed);
+    m_channels[channel][write_pos] = sample;
+    m_write_pos[channel].m_value.store(advance(write_pos, 1), std::memory_order_release);
+}
 
-    ++m_write_pos[channel];
+float RingBuffer::pop_sample(size_t channel) {
+    size_t read_pos = m_read_pos[channel].m_value.load(std::memory_order_relaxed);
+    // Synchronizes with the producer, so that the sample is visible even if only another channel was checked
+    m_write_pos[channel].m_value.load(std::memory_order_acquire);
+    auto sample = m_channels[channel][read_pos];
+    m_read_pos[channel].m_value.store(advance(read_pos, 1), std::memory_order_release);
+    return sample;
+}
 
-    if (m_write_pos[channel] >= get_num_samples()) {
-        m_write_pos[channel] = 0;
+float RingBuffer::get_sample_from_tail (size_t channel, size_t offset) {
+    size_t read_pos = m_read_pos[channel].m_value.load(std::memory_order_relaxed);
+    if ((int) read_pos - (int) offset < 0) {
+        return m_channels[channel][m_capacity + read_pos - offset];
+    } else {
+        return m_channels[channel][read_pos - offset];
     }
 }
 
-float RingBuffer::pop_sample(size_t channel) {
-    auto sample = get_sample(channel, m_read_pos[channel]);
+size_t RingBuffer::get_available_samples(size_t channel) {
+    size_t read_pos = m_read_pos[channel].m_value.load(std::memory_order_acquire);
+    size_t write_pos = m_write_pos[channel].m_value.load(std::memory_order_acquire);
+
+    if (read_pos <= write_pos) {
+        return write_pos - read_pos;
+    } else {
+        return write_pos + m_capacity - read_pos;
+    }
+}
 
-    ++m_read_pos[channel];
+size_t RingBuffer::get_available_samples() {
+    if (m_read_pos.empty()) {
+        return 0;
+    }
+    size_t available_samples = get_available_samples(0);
+    for (size_t i = 1; i < m_read_pos.size(); i++) {
+        available_samples = std::min(available_samples, get_available_samples(i));
+    }
+    return available_samples;
+}
 
-    if (m_read_pos[channel] >= get_num_samples()) {
-        m_read_pos[channel] = 0;
+size_t RingBuffer::get_free_samples(size_t channel) {
+    // One sample always stays empty, otherwise a full buffer could not be distinguished from an empty one
+    return m_capacity - get_available_samples(channel) - 1;
+}
+
+void RingBuffer::push_block(size_t channel, const float* data, size_t num_samples) {
+    float* channel_ptr = m_channels[channel];
+    size_t write_pos = m_write_pos[channel].m_value.load(std::memory_order_relaxed);
+    while (num_samples > 0) {
+        size_t segment = get_segment(write_pos, num_samples);
+        std::memcpy(channel_ptr + write_pos, data, segment * sizeof(float));
+        write_pos = advance(write_pos, segment);
+        data += segment;
+        num_samples -= segment;
     }
+    m_write_pos[channel].m_value.store(write_pos, std::memory_order_release);
+}
 
-    return sample;
+void RingBuffer::push_zeros(size_t channel, size_t num_samples) {
+    float* channel_ptr = m_channels[channel];
+    size_t write_pos = m_write_pos[channel].m_value.load(std::memory_order_relaxed);
+    while (num_samples > 0) {
+        size_t segment = get_segment(write_pos, num_samples);
+        std::memset(channel_ptr + write_pos, 0, segment * sizeof(float));
+        write_pos = advance(write_pos, segment);
+        num_samples -= segment;
+    }
+    m_write_pos[channel].m_value.store(write_pos, std::memory_order_release);
 }
 
-float RingBuffer::get_sample_from_tail (size_t channel, size_t offset) {
-    if ((int) m_read_pos[channel] - (int) offset < 0) {
-        return get_sample(channel, get_num_samples() + m_read_pos[channel] - offset);
-    } else {
-        return get_sample(channel, m_read_pos[channel] - offset);
+void RingBuffer::pop_block(size_t channel, float* data, size_t num_samples) {
+    const float* channel_ptr = m_channels[channel];
+    size_t read_pos = m_read_pos[channel].m_value.load(std::memory_order_relaxed);
+    m_write_pos[channel].m_value.load(std::memory_order_acquire);
+    while (num_samples > 0) {
+        size_t segment = get_segment(read_pos, num_samples);
+        std::memcpy(data, channel_ptr + read_pos, segment * sizeof(float));
+        read_pos = advance(read_pos, segment);
+        data += segment;
+        num_samples -= segment;
     }
+    m_read_pos[channel].m_value.store(read_pos, std::memory_order_release);
 }
 
-size_t RingBuffer::get_available_samples(size_t channel) {
-    size_t return_value;
+void RingBuffer::discard_block(size_t channel, size_t num_samples) {
+    size_t read_pos = m_read_pos[channel].m_value.load(std::memory_order_relaxed);
+    m_read_pos[channel].m_value.store(advance(read_pos, num_samples % m_capacity), std::memory_order_release);
+}
 
-    if (m_read_pos[channel] <= m_write_pos[channel]) {
-        return_value = m_write_pos[channel] - m_read_pos[channel];
-    } else {
-        return_value = m_write_pos[channel] + get_num_samples() - m_read_pos[channel];
+void RingBuffer::peek_from_tail(size_t channel, float* data, size_t num_samples, size_t offset) {
+    const float* channel_ptr = m_channels[channel];
+    size_t read_pos = m_read_pos[channel].m_value.load(std::memory_order_relaxed);
+    size_t position = advance(read_pos, m_capacity - offset % m_capacity);
+    while (num_samples > 0) {
+        size_t segment = get_segment(position, num_samples);
+        std::memcpy(data, channel_ptr + position, segment * sizeof(float));
+        position = advance(position, segment);
+        data += segment;
+        num_samples -= segment;
     }
+}
+
+size_t RingBuffer::get_num_channels() const {
+    return m_channels.size();
+}
+
+const float* RingBuffer::get_read_pointer(size_t channel) const {
+    return m_channels[channel];
+}
+
+float* RingBuffer::get_write_pointer(size_t channel) {
+    return m_channels[channel];
+}
+
+void RingBuffer::clear() {
+    m_buffer.clear();
+    for (auto& mirror : m_mirrors) {
+        std::memset(mirror.data(), 0, mirror.get_size());
+    }
+}
+
+bool RingBuffer::is_mirrored() const {
+    return !m_mirrors.empty();
+}
+
+size_t RingBuffer::get_capacity() const {
+    return m_capacity;
+}
 
-    return return_value;
+size_t RingBuffer::get_num_samples() const {
+    return get_capacity();
+}
+
+const float* RingBuffer::get_window(size_t channel, size_t num_samples, size_t offset) {
+    size_t read_pos = m_read_pos[channel].m_value.load(std::memory_order_relaxed);
+    // Synchronizes with the producer like pop_block, since the window may hold samples that were only discarded
+    m_write_pos[channel].m_value.load(std::memory_order_acquire);
+    size_t position = advance(read_pos, m_capacity - offset % m_capacity);
+    if (get_segment(position, num_samples) < num_samples) {
+        return nullptr;
+    }
+    return m_channels[channel] + position;
+}
+
+size_t RingBuffer::get_window_position(size_t channel, const float* window) const {
+    const float* channel_ptr = m_channels[channel];
+    if (window < channel_ptr || window >= channel_ptr + m_capacity) {
+        return m_capacity;
+    }
+    return (size_t) (window - channel_ptr);
+}
+
+const float* RingBuffer::get_window_at_position(size_t channel, size_t position) const {
+    return m_channels[channel] + position % m_capacity;
+}
+
+size_t RingBuffer::advance(size_t position, size_t num_samples) const {
+    position += num_samples;
+    if (position >= m_capacity) {
+        position -= m_capacity;
+    }
+    return position;
+}
+
+size_t RingBuffer::get_segment(size_t position, size_t num_samples) const {
+    // The second mapping of a mirrored buffer continues behind the first one
+    if (is_mirrored()) {
+        return std::min(num_samples, m_capacity);
+    }
+    return std::min(num_samples, m_capacity - position);
 }
 
-} // namespace anira
\ No newline at end of file
+} // namespace anira
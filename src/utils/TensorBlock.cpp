@@ -0,0 +1,101 @@
+#include <anira/utils/TensorBlock.h>
+#include <cassert>
+#include <thread>
+
+namespace anira {
+
+TensorBlock::TensorBlock(size_t size) {
+    resize(size);
+}
+
+TensorBlock::TensorBlock(TensorBlock&& other) noexcept :
+    m_current(other.m_current.load(std::memory_order_relaxed)),
+    m_data(std::move(other.m_data)),
+    m_versions(other.m_versions),
+    m_last_write_offset(other.m_last_write_offset),
+    m_last_write_size(other.m_last_write_size)
+{
+    for (size_t i = 0; i < m_sequences.size(); ++i) {
+        m_sequences[i].store(other.m_sequences[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+TensorBlock& TensorBlock::operator=(TensorBlock&& other) noexcept {
+    if (this != &other) {
+        m_current.store(other.m_current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        for (size_t i = 0; i < m_sequences.size(); ++i) {
+            m_sequences[i].store(other.m_sequences[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        m_data = std::move(other.m_data);
+        m_versions = other.m_versions;
+        m_last_write_offset = other.m_last_write_offset;
+        m_last_write_size = other.m_last_write_size;
+    }
+    return *this;
+}
+
+void TensorBlock::resize(size_t size) {
+    for (auto& data : m_data) {
+        data.resize(size);
+        data.clear();
+    }
+    m_versions = {};
+    m_last_write_offset = 0;
+    m_last_write_size = 0;
+}
+
+size_t TensorBlock::size() const {
+    return m_data[0].size();
+}
+
+void TensorBlock::write(const float* data, size_t num_values, size_t offset) {
+    assert(("Range out of bounds" && offset + num_values <= size()));
+    bool writing = false;
+    // Another writer that got there first has to finish before
+    while (!m_writing.compare_exchange_weak(writing, true, std::memory_order_acquire, std::memory_order_relaxed)) {
+        writing = false;
+        std::this_thread::yield();
+    }
+
+    size_t current = m_current.load(std::memory_order_relaxed);
+    size_t next = 1 - current;
+    size_t sequence = m_sequences[next].load(std::memory_order_relaxed);
+    m_sequences[next].store(sequence + 1, std::memory_order_relaxed);
+    // Keeps the data stores behind the odd sequence
+    std::atomic_thread_fence(std::memory_order_release);
+    // Only the writers change the published copy, so it is stable while we bring the other copy up to date. Usually that copy only missed the previous write.
+    if (m_versions[next] + 1 == m_versions[current]) {
+        std::memcpy(m_data[next].data() + m_last_write_offset, m_data[current].data() + m_last_write_offset, m_last_write_size * sizeof(float));
+    } else if (m_versions[next] != m_versions[current]) {
+        std::memcpy(m_data[next].data(), m_data[current].data(), size() * sizeof(float));
+    }
+    std::memcpy(m_data[next].data() + offset, data, num_values * sizeof(float));
+    m_versions[next] = m_versions[current] + 1;
+    m_last_write_offset = offset;
+    m_last_write_size = num_values;
+    m_sequences[next].store(sequence + 2, std::memory_order_release);
+    m_current.store(next, std::memory_order_release);
+
+    m_writing.store(false, std::memory_order_release);
+}
+
+void TensorBlock::read(float* data, size_t num_values, size_t offset) const {
+    assert(("Range out of bounds" && offset + num_values <= size()));
+    // A writer only touches the published copy after it published the other one, so the copy is only discarded if two writes completed meanwhile
+    while (true) {
+        size_t current = m_current.load(std::memory_order_acquire);
+        size_t sequence = m_sequences[current].load(std::memory_order_acquire);
+        if (sequence & 1) {
+            // The other copy has been published since we loaded the index
+            continue;
+        }
+        std::memcpy(data, &m_data[current][offset], num_values * sizeof(float));
+        // Keeps the data loads before the second sequence load
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequences[current].load(std::memory_order_relaxed) == sequence) {
+            return;
+        }
+    }
+}
+
+} // namespace anira
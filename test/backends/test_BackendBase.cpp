@@ -0,0 +1,102 @@
+#include "gtest/gtest.h"
+#include <anira/anira.h>
+#include <thread>
+
+using namespace anira;
+
+// A processor with a single instance that the test holds and releases
+class SingleInstanceProcessor : public BackendBase {
+public:
+    SingleInstanceProcessor(InferenceConfig& inference_config) : BackendBase(inference_config), m_free_instances(1) {}
+
+    bool try_process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) override {
+        size_t index;
+        if (!m_free_instances.try_acquire(index)) {
+            return false;
+        }
+        BackendBase::process(input, output, session);
+        release_instance(m_free_instances, index);
+        return true;
+    }
+
+    void hold() {
+        m_index = m_free_instances.acquire();
+    }
+
+    void release() {
+        release_instance(m_free_instances, m_index);
+    }
+
+private:
+    FreeList m_free_instances;
+    size_t m_index = 0;
+};
+
+class BackendBaseTest : public ::testing::Test {
+protected:
+    // Lets an inference of session 0 wait for the held instance and fills the queue with inferences of session 1
+    void wait_with_full_queue() {
+        m_processor.hold();
+        // The inference threads count an inference as active before it reaches the processor
+        m_session_0->m_active_inferences.fetch_add(1);
+        EXPECT_FALSE(m_processor.try_process_or_wait(m_input, m_output, {m_session_0, nullptr, m_now, m_now}, m_queues));
+        while (m_queues.try_enqueue({m_session_1, nullptr, m_now + std::chrono::milliseconds(1), m_now})) {
+        }
+    }
+
+    std::vector<ModelData> m_model_data;
+    std::vector<TensorShape> m_tensor_shape = {TensorShape({{1, 64}}, {{1, 64}})};
+    InferenceConfig m_inference_config = InferenceConfig(m_model_data, m_tensor_shape, 1.f);
+    PrePostProcessor m_pp_processor;
+    std::shared_ptr<SessionElement> m_session_0 = std::make_shared<SessionElement>(0, m_pp_processor, m_inference_config);
+    std::shared_ptr<SessionElement> m_session_1 = std::make_shared<SessionElement>(1, m_pp_processor, m_inference_config);
+    std::chrono::steady_clock::time_point m_now = std::chrono::steady_clock::now();
+    SingleInstanceProcessor m_processor{m_inference_config};
+    WorkerQueues m_queues{1, 4};
+    AudioBufferF m_input{1, 64};
+    AudioBufferF m_output{1, 64};
+};
+
+TEST_F(BackendBaseTest, ResubmitToFullQueueOnInferenceThread){
+    m_queues.set_num_workers(1);
+    wait_with_full_queue();
+    size_t num_queued = m_queues.size_approx();
+
+    // The release on an inference thread hands the waiting inference over to that thread instead of keeping it waiting for a release that may never come
+    std::vector<InferenceData> unsubmitted_inferences;
+    BackendBase::set_unsubmitted_inferences(&unsubmitted_inferences);
+    m_processor.release();
+    BackendBase::set_unsubmitted_inferences(nullptr);
+    ASSERT_EQ(unsubmitted_inferences.size(), 1);
+    EXPECT_EQ(unsubmitted_inferences[0].m_session, m_session_0);
+    // It stays active until the thread processed it
+    EXPECT_EQ(m_session_0->m_active_inferences.load(), 1);
+
+    // It no longer waits, so the next release resubmits nothing
+    InferenceData inference_data;
+    ASSERT_TRUE(m_queues.try_dequeue(0, inference_data));
+    m_processor.hold();
+    m_processor.release();
+    EXPECT_EQ(m_queues.size_approx(), num_queued - 1);
+}
+
+TEST_F(BackendBaseTest, ResubmitToFullQueueOutsideInferenceThread){
+    m_queues.set_num_workers(1);
+    wait_with_full_queue();
+
+    // Outside of the inference threads the release resubmits once the queue has room again
+    std::thread releasing_thread([this] { m_processor.release(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(m_session_0->m_active_inferences.load(), 1);
+    InferenceData inference_data;
+    ASSERT_TRUE(m_queues.try_dequeue(0, inference_data));
+    EXPECT_EQ(inference_data.m_session, m_session_1);
+    releasing_thread.join();
+    EXPECT_EQ(m_session_0->m_active_inferences.load(), 0);
+
+    bool resubmitted = false;
+    while (m_queues.try_dequeue(0, inference_data)) {
+        resubmitted |= inference_data.m_session == m_session_0;
+    }
+    EXPECT_TRUE(resubmitted);
+}
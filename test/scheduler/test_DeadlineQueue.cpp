@@ -0,0 +1,106 @@
+#include "gtest/gtest.h"
+#include <anira/anira.h>
+#include <thread>
+
+using namespace anira;
+
+class DeadlineQueueTest : public ::testing::Test {
+protected:
+    std::vector<ModelData> m_model_data;
+    std::vector<TensorShape> m_tensor_shape = {TensorShape({{1, 64}}, {{1, 64}})};
+    InferenceConfig m_inference_config = InferenceConfig(m_model_data, m_tensor_shape, 1.f);
+    PrePostProcessor m_pp_processor;
+    std::shared_ptr<SessionElement> m_session_a = std::make_shared<SessionElement>(0, m_pp_processor, m_inference_config);
+    std::shared_ptr<SessionElement> m_session_b = std::make_shared<SessionElement>(1, m_pp_processor, m_inference_config);
+    std::chrono::steady_clock::time_point m_now = std::chrono::steady_clock::now();
+};
+
+TEST_F(DeadlineQueueTest, EarliestDeadlineFirst){
+    DeadlineQueue queue(64);
+    std::vector<int> offsets_ms = {40, 5, 30, 1, 20, 10};
+    for (int offset : offsets_ms) {
+        ASSERT_TRUE(queue.try_push({m_session_a, nullptr, m_now + std::chrono::milliseconds(offset), m_now}));
+    }
+    ASSERT_EQ(queue.size_approx(), offsets_ms.size());
+
+    std::sort(offsets_ms.begin(), offsets_ms.end());
+    InferenceData inference_data;
+    for (int offset : offsets_ms) {
+        ASSERT_TRUE(queue.try_dequeue(inference_data));
+        EXPECT_EQ(inference_data.m_deadline, m_now + std::chrono::milliseconds(offset));
+    }
+    EXPECT_FALSE(queue.try_dequeue(inference_data));
+}
+
+TEST_F(DeadlineQueueTest, FullQueue){
+    DeadlineQueue queue(3);
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(queue.try_push({m_session_a, nullptr, m_now, m_now}));
+    }
+    EXPECT_FALSE(queue.try_push({m_session_a, nullptr, m_now, m_now}));
+
+    // a dequeued slot is reused
+    InferenceData inference_data;
+    ASSERT_TRUE(queue.try_dequeue(inference_data));
+    EXPECT_TRUE(queue.try_push({m_session_b, nullptr, m_now, m_now}));
+    EXPECT_EQ(queue.size_approx(), 3);
+}
+
+TEST_F(DeadlineQueueTest, ShortDeadlineOvertakes){
+    DeadlineQueue queue(64);
+    InferenceData inference_data;
+    // a long block is already waiting in the queue when a short block arrives
+    ASSERT_TRUE(queue.try_push({m_session_a, nullptr, m_now + std::chrono::milliseconds(170), m_now}));
+    ASSERT_TRUE(queue.try_push({m_session_a, nullptr, m_now + std::chrono::milliseconds(180), m_now}));
+    ASSERT_TRUE(queue.try_dequeue(inference_data));
+    ASSERT_TRUE(queue.try_push({m_session_b, nullptr, m_now + std::chrono::microseconds(700), m_now}));
+
+    ASSERT_TRUE(queue.try_dequeue(inference_data));
+    EXPECT_EQ(inference_data.m_session, m_session_b);
+}
+
+TEST_F(DeadlineQueueTest, RemoveSession){
+    DeadlineQueue queue(64);
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(queue.try_push({(i % 2 == 0) ? m_session_a : m_session_b, nullptr, m_now + std::chrono::milliseconds(i), m_now}));
+    }
+    queue.remove_session(m_session_a);
+    EXPECT_EQ(queue.size_approx(), 5);
+
+    InferenceData inference_data;
+    while (queue.try_dequeue(inference_data)) {
+        EXPECT_EQ(inference_data.m_session, m_session_b);
+    }
+}
+
+TEST_F(DeadlineQueueTest, ConcurrentProducersAndConsumers){
+    DeadlineQueue queue(64);
+    size_t num_per_producer = 5000;
+    std::atomic<size_t> num_dequeued{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < 2; p++) {
+        threads.emplace_back([&, p]() {
+            for (size_t i = 0; i < num_per_producer; i++) {
+                while (!queue.try_push({(p == 0) ? m_session_a : m_session_b, nullptr, std::chrono::steady_clock::now(), m_now})) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < 2; c++) {
+        threads.emplace_back([&]() {
+            InferenceData inference_data;
+            while (num_dequeued.load() < 2 * num_per_producer) {
+                if (queue.try_dequeue(inference_data)) {
+                    num_dequeued.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(num_dequeued.load(), 2 * num_per_producer);
+    EXPECT_EQ(queue.size_approx(), 0);
+}
@@ -0,0 +1,115 @@
+#include "gtest/gtest.h"
+#include <anira/anira.h>
+#include <thread>
+
+using namespace anira;
+
+class WorkerQueuesTest : public ::testing::Test {
+protected:
+    std::vector<ModelData> m_model_data;
+    std::vector<TensorShape> m_tensor_shape = {TensorShape({{1, 64}}, {{1, 64}})};
+    InferenceConfig m_inference_config = InferenceConfig(m_model_data, m_tensor_shape, 1.f);
+    PrePostProcessor m_pp_processor;
+    std::shared_ptr<SessionElement> m_session_0 = std::make_shared<SessionElement>(0, m_pp_processor, m_inference_config);
+    std::shared_ptr<SessionElement> m_session_1 = std::make_shared<SessionElement>(1, m_pp_processor, m_inference_config);
+    std::chrono::steady_clock::time_point m_now = std::chrono::steady_clock::now();
+};
+
+TEST_F(WorkerQueuesTest, HomeWorkerFirst){
+    WorkerQueues queues(8, 64);
+    queues.set_num_workers(2);
+
+    // session 1 has the earlier deadline, but worker 0 prefers the inferences of its own session 0
+    ASSERT_TRUE(queues.try_enqueue({m_session_0, nullptr, m_now + std::chrono::milliseconds(10), m_now}));
+    ASSERT_TRUE(queues.try_enqueue({m_session_1, nullptr, m_now + std::chrono::milliseconds(1), m_now}));
+
+    InferenceData inference_data;
+    ASSERT_TRUE(queues.try_dequeue(0, inference_data));
+    EXPECT_EQ(inference_data.m_session, m_session_0);
+    ASSERT_TRUE(queues.try_dequeue(1, inference_data));
+    EXPECT_EQ(inference_data.m_session, m_session_1);
+    EXPECT_FALSE(queues.try_dequeue(0, inference_data));
+}
+
+TEST_F(WorkerQueuesTest, StealAfterGracePeriod){
+    WorkerQueues queues(8, 64);
+    queues.set_num_workers(2);
+
+    // the idle home worker gets the chance to take a fresh inference itself
+    auto now = std::chrono::steady_clock::now();
+    ASSERT_TRUE(queues.try_enqueue({m_session_0, nullptr, now, now}));
+    InferenceData inference_data;
+    EXPECT_FALSE(queues.try_dequeue(1, inference_data));
+    EXPECT_FALSE(queues.has_work(1));
+    EXPECT_TRUE(queues.has_work(0));
+
+    std::this_thread::sleep_for(2 * WorkerQueues::STEAL_GRACE_PERIOD);
+    EXPECT_TRUE(queues.has_work(1));
+    ASSERT_TRUE(queues.try_dequeue(1, inference_data));
+    EXPECT_EQ(inference_data.m_session, m_session_0);
+}
+
+TEST_F(WorkerQueuesTest, StealFromBusyWorker){
+    WorkerQueues queues(8, 64);
+    queues.set_num_workers(4);
+
+    auto now = std::chrono::steady_clock::now();
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(queues.try_enqueue({m_session_0, nullptr, now + std::chrono::milliseconds(i), now}));
+    }
+
+    // once the home worker processes an inference, the others take the rest right away
+    InferenceData inference_data;
+    ASSERT_TRUE(queues.try_dequeue(0, inference_data));
+    for (size_t worker = 1; worker < 4; worker++) {
+        ASSERT_TRUE(queues.try_dequeue(worker, inference_data));
+        EXPECT_EQ(inference_data.m_session, m_session_0);
+    }
+    EXPECT_EQ(queues.size_approx(), 0);
+}
+
+TEST_F(WorkerQueuesTest, ShrinkKeepsPendingInferences){
+    WorkerQueues queues(8, 64);
+    queues.set_num_workers(2);
+    auto now = std::chrono::steady_clock::now();
+    ASSERT_TRUE(queues.try_enqueue({m_session_1, nullptr, now, now}));
+
+    // worker 1 is stopped, new inferences of session 1 go to worker 0
+    queues.set_num_workers(1);
+    ASSERT_TRUE(queues.try_enqueue({m_session_1, nullptr, now, now}));
+
+    InferenceData inference_data;
+    ASSERT_TRUE(queues.try_dequeue(0, inference_data));
+    ASSERT_TRUE(queues.try_dequeue(0, inference_data));
+    EXPECT_FALSE(queues.try_dequeue(0, inference_data));
+}
+
+TEST_F(WorkerQueuesTest, FullQueueOverflows){
+    WorkerQueues queues(8, 2);
+    queues.set_num_workers(2);
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(queues.try_enqueue({m_session_0, nullptr, m_now, m_now}));
+    }
+    EXPECT_FALSE(queues.try_enqueue({m_session_0, nullptr, m_now, m_now}));
+
+    // the overflow is taken by worker 1 like its own inferences
+    InferenceData inference_data;
+    ASSERT_TRUE(queues.try_dequeue(1, inference_data));
+    ASSERT_TRUE(queues.try_dequeue(1, inference_data));
+}
+
+TEST_F(WorkerQueuesTest, RemoveSession){
+    WorkerQueues queues(8, 64);
+    queues.set_num_workers(2);
+    for (int i = 0; i < 6; i++) {
+        ASSERT_TRUE(queues.try_enqueue({(i % 2 == 0) ? m_session_0 : m_session_1, nullptr, m_now, m_now}));
+    }
+    queues.remove_session(m_session_1);
+    EXPECT_EQ(queues.size_approx(), 3);
+
+    InferenceData inference_data;
+    while (queues.try_dequeue(0, inference_data)) {
+        EXPECT_EQ(inference_data.m_session, m_session_0);
+    }
+    EXPECT_EQ(queues.size_approx(), 0);
+}
@@ -0,0 +1,64 @@
+#include "gtest/gtest.h"
+#include <anira/anira.h>
+#include <thread>
+#include <algorithm>
+
+using namespace anira;
+
+TEST(CpuAffinity, ParseCpuList){
+    EXPECT_EQ(CpuAffinity::parse_cpu_list("0-3,8,10-11\n"), std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(CpuAffinity::parse_cpu_list("5,1-2,2"), std::vector<int>({1, 2, 5}));
+    EXPECT_TRUE(CpuAffinity::parse_cpu_list("").empty());
+    EXPECT_TRUE(CpuAffinity::parse_cpu_list("a-b").empty());
+}
+
+TEST(CpuAffinity, OnlineCores){
+    std::vector<int> cores = CpuAffinity::get_online_cores();
+    ASSERT_FALSE(cores.empty());
+    EXPECT_TRUE(std::is_sorted(cores.begin(), cores.end()));
+}
+
+#if __linux__
+TEST(CpuAffinity, PinThread){
+    // The caller may be restricted to some cores, so we pin to one of those
+    std::vector<int> allowed_cores = CpuAffinity::get_caller_cores();
+    if (allowed_cores.empty()) {
+        allowed_cores = CpuAffinity::get_online_cores();
+    }
+    ASSERT_FALSE(allowed_cores.empty());
+    int core = allowed_cores.back();
+
+    std::atomic<bool> pinned{false};
+    std::atomic<int> running_core{-1};
+    std::thread thread([&]() {
+        while (!pinned.load()) {
+            std::this_thread::yield();
+        }
+        std::this_thread::yield();
+        running_core.store(sched_getcpu());
+    });
+    EXPECT_TRUE(CpuAffinity::set_thread_affinity(thread.native_handle(), {core}));
+    pinned.store(true);
+    thread.join();
+    EXPECT_EQ(running_core.load(), core);
+}
+
+TEST(CpuAffinity, CallerCoresOfPinnedThread){
+    std::vector<int> allowed_cores = CpuAffinity::get_caller_cores();
+    if (allowed_cores.empty()) {
+        allowed_cores = CpuAffinity::get_online_cores();
+    }
+    int core = allowed_cores.front();
+
+    std::vector<int> caller_cores;
+    std::thread thread([&]() {
+        CpuAffinity::set_thread_affinity(pthread_self(), {core});
+        caller_cores = CpuAffinity::get_caller_cores();
+    });
+    thread.join();
+    // a single online core counts as not pinned
+    if (CpuAffinity::get_online_cores().size() > 1) {
+        EXPECT_EQ(caller_cores, std::vector<int>({core}));
+    }
+}
+#endif
@@ -0,0 +1,100 @@
+#include "gtest/gtest.h"
+#include <anira/anira.h>
+#include <thread>
+
+using namespace anira;
+
+TEST(EventCount, NotifyWakesWaiter){
+    EventCount event_count;
+    std::atomic<bool> ready{false};
+    std::atomic<bool> woken{false};
+
+    std::thread waiter([&]() {
+        while (!ready.load()) {
+            uint32_t key = event_count.prepare_wait();
+            if (ready.load()) {
+                event_count.cancel_wait();
+                break;
+            }
+            event_count.wait(key);
+        }
+        woken.store(true);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_FALSE(woken.load());
+    ready.store(true);
+    event_count.notify_one();
+    waiter.join();
+    EXPECT_TRUE(woken.load());
+}
+
+TEST(EventCount, NoLostWakeUps){
+    EventCount event_count;
+    std::atomic<int> num_items{0};
+    int num_produced = 20000;
+    std::atomic<int> num_consumed{0};
+
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < 3; c++) {
+        consumers.emplace_back([&]() {
+            while (num_consumed.load() < num_produced) {
+                int items = num_items.load();
+                if (items > 0) {
+                    if (num_items.compare_exchange_weak(items, items - 1)) {
+                        num_consumed.fetch_add(1);
+                    }
+                    continue;
+                }
+                uint32_t key = event_count.prepare_wait();
+                if (num_items.load() > 0 || num_consumed.load() >= num_produced) {
+                    event_count.cancel_wait();
+                    continue;
+                }
+                event_count.wait(key);
+            }
+            event_count.notify_all();
+        });
+    }
+
+    for (int i = 0; i < num_produced; i++) {
+        num_items.fetch_add(1);
+        event_count.notify_one();
+    }
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+    EXPECT_EQ(num_consumed.load(), num_produced);
+}
+
+TEST(EventCount, WaitUntil){
+    EventCount event_count;
+
+    // Without a notification the wait ends at the deadline
+    auto start = std::chrono::steady_clock::now();
+    uint32_t key = event_count.prepare_wait();
+    EXPECT_FALSE(event_count.wait_until(key, start + std::chrono::milliseconds(20)));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+
+    // A notification ends it early
+    std::atomic<bool> waiting{false};
+    std::atomic<bool> notified{false};
+    std::thread waiter([&]() {
+        uint32_t key = event_count.prepare_wait();
+        waiting.store(true);
+        notified.store(event_count.wait_until(key, std::chrono::steady_clock::now() + std::chrono::seconds(10)));
+    });
+    while (!waiting.load()) {
+        std::this_thread::yield();
+    }
+    start = std::chrono::steady_clock::now();
+    event_count.notify_one();
+    waiter.join();
+    EXPECT_TRUE(notified.load());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+
+    // An outdated key returns right away, even after the deadline
+    key = event_count.prepare_wait();
+    event_count.notify_all();
+    EXPECT_TRUE(event_count.wait_until(key, start));
+}
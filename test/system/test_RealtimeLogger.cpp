@@ -0,0 +1,75 @@
+#include "gtest/gtest.h"
+#include <anira/anira.h>
+#include <thread>
+
+using namespace anira;
+
+static size_t count_occurrences(const std::string& text, const std::string& pattern) {
+    size_t count = 0;
+    for (size_t position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + 1)) {
+        count++;
+    }
+    return count;
+}
+
+TEST(RealtimeLogger, PrintsFromFlush){
+    testing::internal::CaptureStdout();
+    RealtimeLogger::log(LogLevel::Warning, "Logger test message", 3);
+    RealtimeLogger::log(LogLevel::Info, "Logger test info");
+    RealtimeLogger::flush();
+    std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_EQ(count_occurrences(output, "[WARNING] Logger test message in session: 3!"), 1);
+    EXPECT_EQ(count_occurrences(output, "[INFO] Logger test info!"), 1);
+}
+
+TEST(RealtimeLogger, RateLimitsRepetitions){
+    testing::internal::CaptureStdout();
+    for (int i = 0; i < 100; ++i) {
+        RealtimeLogger::log(LogLevel::Warning, "Logger test repetition", 1);
+        RealtimeLogger::log(LogLevel::Warning, "Logger test repetition", 2);
+    }
+    RealtimeLogger::flush();
+    std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_EQ(count_occurrences(output, "Logger test repetition in session: 1!\n"), 1);
+    EXPECT_EQ(count_occurrences(output, "Logger test repetition in session: 1! (repeated 99 times)"), 1);
+    EXPECT_EQ(count_occurrences(output, "Logger test repetition in session: 2! (repeated 99 times)"), 1);
+}
+
+TEST(RealtimeLogger, ConcurrentLogging){
+    const int num_threads = 4;
+    const int num_logs = 200;
+
+    testing::internal::CaptureStdout();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < num_logs; ++i) {
+                RealtimeLogger::log(LogLevel::Warning, "Logger test concurrent", t);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    RealtimeLogger::flush();
+    std::string output = testing::internal::GetCapturedStdout();
+
+    // The ring holds all records, so none are dropped and every session is printed once plus its repetitions
+    EXPECT_EQ(count_occurrences(output, "dropped"), 0);
+    for (int t = 0; t < num_threads; ++t) {
+        EXPECT_EQ(count_occurrences(output, "Logger test concurrent in session: " + std::to_string(t) + "! (repeated " + std::to_string(num_logs - 1) + " times)"), 1);
+    }
+}
+
+TEST(RealtimeLogger, CountsDroppedRecords){
+    testing::internal::CaptureStdout();
+    for (size_t i = 0; i < RealtimeLogger::CAPACITY + 10; ++i) {
+        RealtimeLogger::log(LogLevel::Warning, "Logger test overflow");
+    }
+    RealtimeLogger::flush();
+    std::string output = testing::internal::GetCapturedStdout();
+
+    EXPECT_EQ(count_occurrences(output, "[WARNING] 10 log messages were dropped"), 1);
+}
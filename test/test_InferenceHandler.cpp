@@ -1,6 +1,7 @@
 #include <thread>
 #include <stdint.h>
 #include <chrono>
+#include <map>
 
 #include "gtest/gtest.h"
 #include <anira/anira.h>
@@ -22,6 +23,7 @@ struct InferenceTestParams{
     size_t reference_data_offset;
     float epsilon_rel = 1e-6f;
     float epsilon_abs = 1e-7f;
+    bool offload_pre_post_processing = false;
 };
 
 std::ostream& operator<<(std::ostream& stream, const InferenceTestParams& params)
@@ -56,6 +58,7 @@ std::ostream& operator<<(std::ostream& stream, const InferenceTestParams& params
     stream << "backend = " << backend;
     stream << ", buffersize = " << params.audio_config.m_host_buffer_size;
     stream << ", samplerate = " << params.audio_config.m_host_sample_rate;
+    stream << ", offload = " << params.offload_pre_post_processing;
     stream << " }";
 
     return stream;
@@ -88,6 +91,7 @@ TEST_P(InferenceTest, Simple){
     // setup inference
     ContextConfig anira_context_config;
     InferenceConfig inference_config = hybridnn_config;
+    inference_config.m_offload_pre_post_processing = test_params.offload_pre_post_processing;
     HybridNNPrePostProcessor pp_processor;
     HybridNNBypassProcessor bypass_processor(inference_config);
 
@@ -192,6 +196,32 @@ INSTANTIATE_TEST_SUITE_P(
     build_test_name
 );
 
+INSTANTIATE_TEST_SUITE_P(
+    InferenceBypassOffloaded, InferenceTest, ::testing::Values(
+        InferenceTestParams{
+            anira::CUSTOM,
+            HostAudioConfig(1024, 44100),
+            string(GUITARLSTM_MODELS_PATH_PYTORCH) + "/model_0/x_test.wav",
+            string(GUITARLSTM_MODELS_PATH_PYTORCH) + "/model_0/x_test.wav",
+            0,
+            FLT_EPSILON,
+            0,
+            true
+        },
+        InferenceTestParams{
+            anira::CUSTOM,
+            HostAudioConfig(256, 44100),
+            string(GUITARLSTM_MODELS_PATH_PYTORCH) + "/model_0/x_test.wav",
+            string(GUITARLSTM_MODELS_PATH_PYTORCH) + "/model_0/x_test.wav",
+            0,
+            FLT_EPSILON,
+            0,
+            true
+        }
+    ),
+    build_test_name
+);
+
 #ifdef USE_LIBTORCH
 INSTANTIATE_TEST_SUITE_P(
     InferenceLibtorch, InferenceTest, ::testing::Values(
@@ -324,6 +354,497 @@ INSTANTIATE_TEST_SUITE_P(
 );
 #endif
 
+// Custom backend that takes a configurable time per inference
+class SleepingProcessor : public BackendBase {
+public:
+    SleepingProcessor(InferenceConfig& inference_config) : BackendBase(inference_config) {}
+
+    void process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) override {
+        m_num_inferences.fetch_add(1);
+        auto chunk_inference_time_us = m_chunk_inference_time_us.find(output.get_num_samples());
+        int inference_time_us = chunk_inference_time_us != m_chunk_inference_time_us.end() ? chunk_inference_time_us->second.load() : m_inference_time_us.load();
+        std::this_thread::sleep_for(std::chrono::microseconds(inference_time_us));
+        BackendBase::process(input, output, session);
+    }
+
+    std::atomic<int> m_inference_time_us{1000};
+    // Time per inference of the chunk sizes with an entry, which are added before the processor is used
+    std::map<size_t, std::atomic<int>> m_chunk_inference_time_us;
+    std::atomic<int> m_num_inferences{0};
+};
+
+// Sessions on a custom processor, by default with tensors of 256 samples and a host buffer of 256 samples at 48 kHz
+class InferenceHandlerTest : public ::testing::Test {
+protected:
+    std::unique_ptr<InferenceHandler> create_inference_handler(BackendBase& processor, HostAudioConfig host_config = HostAudioConfig(256, 48000), bool non_realtime = false, unsigned int num_threads = 2) {
+        auto inference_handler = std::make_unique<InferenceHandler>(m_pp_processor, m_inference_config, processor, ContextConfig(num_threads));
+        inference_handler->set_inference_backend(CUSTOM);
+        inference_handler->set_non_realtime(non_realtime);
+        inference_handler->prepare(host_config);
+        return inference_handler;
+    }
+
+    // Processes the block in place and appends it to the output. Instead of pacing the blocks with the wall clock, it waits until the receive buffer holds the samples that the next block of the same size pops, so that no block is missed however slow the machine is. The latency covers at least one host buffer of inference time, so these samples were submitted by earlier blocks, even if the chunk is larger than the block and this block submitted no inference.
+    static void process_block(InferenceHandler& inference_handler, AudioBufferF& block, std::vector<float>* output = nullptr) {
+        InferenceManager& inference_manager = inference_handler.get_inference_manager();
+        inference_handler.process(block.get_array_of_write_pointers(), block.get_num_samples());
+        auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(INFERENCE_TIMEOUT_S);
+        // The non-realtime mode already waits for the results of the block
+        while (!inference_handler.is_non_realtime() && inference_manager.get_num_received_samples() < block.get_num_samples()) {
+            if (std::chrono::steady_clock::now() > timeout) {
+                ADD_FAILURE() << "Timeout while waiting for block to be processed";
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+        }
+        if (output != nullptr) {
+            output->insert(output->end(), block.get_read_pointer(0), block.get_read_pointer(0) + block.get_num_samples());
+        }
+    }
+
+    std::vector<ModelData> m_model_data;
+    std::vector<TensorShape> m_tensor_shape = {{{{1, 256}}, {{1, 256}}}};
+    InferenceConfig m_inference_config = InferenceConfig(m_model_data, m_tensor_shape, 5.f);
+    PrePostProcessor m_pp_processor;
+};
+
+TEST_F(InferenceHandlerTest, Calibration){
+    // The configured inference time is far above the actual one
+    m_inference_config.m_max_inference_time = 20.f;
+    SleepingProcessor sleeping_processor(m_inference_config);
+    auto inference_handler = create_inference_handler(sleeping_processor);
+    int configured_latency = inference_handler->get_latency();
+
+    m_inference_config.m_calibration_runs = 20;
+    std::atomic<int> requested_latency{-1};
+    inference_handler->set_latency_change_callback([&requested_latency](int latency) {
+        requested_latency.store(latency);
+    });
+    inference_handler->prepare(HostAudioConfig(256, 48000));
+    int calibrated_latency = inference_handler->get_latency();
+
+    EXPECT_LT(calibrated_latency, configured_latency);
+    // The calibration runs are not part of the statistics
+    EXPECT_EQ(inference_handler->get_stats().m_inference_time.m_count, 0);
+
+    // The model slows down at runtime, so the monitor requests a higher latency. The monitor needs a window of one second with enough inferences, which the blocks deliver as fast as the inferences finish.
+    sleeping_processor.m_inference_time_us.store(8000);
+    AudioBufferF test_buffer(1, 256);
+    test_buffer.clear();
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(INFERENCE_TIMEOUT_S + 3);
+    while (requested_latency.load() < 0 && std::chrono::steady_clock::now() < timeout) {
+        process_block(*inference_handler, test_buffer);
+    }
+    EXPECT_GT(requested_latency.load(), calibrated_latency);
+}
+
+// Custom backend that outputs a constant value
+class ConstantProcessor : public BackendBase {
+public:
+    ConstantProcessor(InferenceConfig& inference_config, float value) : BackendBase(inference_config), m_value(value) {}
+
+    void process([[maybe_unused]] AudioBufferF& input, AudioBufferF& output, [[maybe_unused]] std::shared_ptr<SessionElement> session) override {
+        for (size_t channel = 0; channel < output.get_num_channels(); ++channel) {
+            std::fill_n(output.get_write_pointer(channel), output.get_num_samples(), m_value);
+        }
+    }
+
+    float m_value;
+};
+
+TEST_F(InferenceHandlerTest, HotSwap){
+    ConstantProcessor previous_processor(m_inference_config, 0.f);
+    ConstantProcessor next_processor(m_inference_config, 1.f);
+    auto inference_handler = create_inference_handler(previous_processor);
+
+    size_t crossfade_samples = 1024;
+    std::vector<float> output;
+    AudioBufferF test_buffer(1, 256);
+    test_buffer.clear();
+    for (int i = 0; i < 10; ++i) {
+        process_block(*inference_handler, test_buffer, &output);
+    }
+    EXPECT_TRUE(inference_handler->set_custom_processor_async(next_processor, crossfade_samples));
+    // Only one swap can be in progress
+    EXPECT_FALSE(inference_handler->set_custom_processor_async(previous_processor));
+
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(INFERENCE_TIMEOUT_S);
+    while (inference_handler->is_swapping_model() && std::chrono::steady_clock::now() < timeout) {
+        process_block(*inference_handler, test_buffer, &output);
+    }
+    EXPECT_FALSE(inference_handler->is_swapping_model());
+    for (int i = 0; i < 10; ++i) {
+        process_block(*inference_handler, test_buffer, &output);
+    }
+
+    // The output rises from the previous to the next processor without jumps
+    ASSERT_EQ(inference_handler->get_stats().m_missed_blocks, 0);
+    for (size_t i = 1; i < output.size(); ++i) {
+        EXPECT_GE(output[i], output[i - 1]);
+        EXPECT_LE(output[i] - output[i - 1], 1.f / (float) crossfade_samples + 1e-6f);
+    }
+    EXPECT_FLOAT_EQ(output.back(), 1.f);
+}
+
+TEST_F(InferenceHandlerTest, ChainedHotSwaps){
+    ConstantProcessor first_processor(m_inference_config, 0.f);
+    ConstantProcessor second_processor(m_inference_config, 1.f);
+    ConstantProcessor third_processor(m_inference_config, 2.f);
+    auto inference_handler = create_inference_handler(first_processor);
+
+    AudioBufferF test_buffer(1, 256);
+    auto process_silence = [&]() {
+        test_buffer.clear();
+        process_block(*inference_handler, test_buffer);
+    };
+
+    // The second swap replaces the processor of the first one, which is released once no inference uses it anymore
+    for (ConstantProcessor* processor : {&second_processor, &third_processor}) {
+        EXPECT_TRUE(inference_handler->set_custom_processor_async(*processor, 512));
+        auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(INFERENCE_TIMEOUT_S);
+        while (inference_handler->is_swapping_model() && std::chrono::steady_clock::now() < timeout) {
+            process_silence();
+        }
+        EXPECT_FALSE(inference_handler->is_swapping_model());
+    }
+    for (int i = 0; i < 10; ++i) {
+        process_silence();
+    }
+    EXPECT_FLOAT_EQ(test_buffer.get_read_pointer(0)[255], 2.f);
+
+    // Preparing the session again drops the replaced swap
+    inference_handler->prepare(HostAudioConfig(256, 48000));
+    for (int i = 0; i < 10; ++i) {
+        process_silence();
+    }
+    EXPECT_FLOAT_EQ(test_buffer.get_read_pointer(0)[255], 2.f);
+}
+
+// Custom backend with a single instance, which is busy for a while on every inference
+class BusyProcessor : public ConstantProcessor {
+public:
+    BusyProcessor(InferenceConfig& inference_config) : ConstantProcessor(inference_config, 1.f), m_free_instances(1) {}
+
+    void process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) override {
+        size_t index = m_free_instances.acquire();
+        busy_process(input, output, session);
+        release_instance(m_free_instances, index);
+    }
+
+    bool try_process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) override {
+        m_attempts.fetch_add(1);
+        size_t index;
+        if (!m_free_instances.try_acquire(index)) {
+            m_busy_attempts.fetch_add(1);
+            return false;
+        }
+        busy_process(input, output, session);
+        release_instance(m_free_instances, index);
+        return true;
+    }
+
+    std::atomic<int> m_attempts{0};
+    std::atomic<int> m_busy_attempts{0};
+
+private:
+    void busy_process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        ConstantProcessor::process(input, output, session);
+    }
+
+    FreeList m_free_instances;
+};
+
+TEST_F(InferenceHandlerTest, RequeueBusyProcessor){
+    BusyProcessor busy_processor(m_inference_config);
+    // Every block submits four inferences at once, so the second thread finds the instance busy
+    auto inference_handler = create_inference_handler(busy_processor, HostAudioConfig(1024, 48000));
+
+    AudioBufferF test_buffer(1, 1024);
+    for (int i = 0; i < 50; ++i) {
+        test_buffer.clear();
+        process_block(*inference_handler, test_buffer);
+    }
+
+    // The busy inferences waited for the instance and were processed later instead of being lost
+    EXPECT_GT(busy_processor.m_busy_attempts.load(), 0);
+    EXPECT_EQ(inference_handler->get_stats().m_missed_blocks, 0);
+    EXPECT_FLOAT_EQ(test_buffer.get_read_pointer(0)[1023], 1.f);
+    // Every release resubmits at most one waiting inference, so the threads do not retry while the instance is busy
+    int num_inferences = busy_processor.m_attempts.load() - busy_processor.m_busy_attempts.load();
+    EXPECT_LE(busy_processor.m_busy_attempts.load(), 2 * num_inferences);
+}
+
+TEST_F(InferenceHandlerTest, NonRealtime){
+    SleepingProcessor sleeping_processor(m_inference_config);
+    HostAudioConfig host_config(2400, 48000);
+    auto inference_handler = create_inference_handler(sleeping_processor, host_config);
+    int realtime_latency = inference_handler->get_latency();
+    inference_handler->set_non_realtime(true);
+    inference_handler->prepare(host_config);
+    EXPECT_TRUE(inference_handler->is_non_realtime());
+    int latency = inference_handler->get_latency();
+    EXPECT_LT(latency, realtime_latency);
+
+    // An inference of 256 samples takes 10 ms, longer than the 5.3 ms of audio it processes, which the real-time mode could only answer with missed blocks
+    sleeping_processor.m_inference_time_us.store(10000);
+    // The blocks are larger than the prepared host buffer size
+    std::vector<float> input(19200);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = std::sin((float) i * 0.01f);
+    }
+    std::vector<float> output(input.size());
+    for (size_t offset = 0; offset < input.size(); offset += 4800) {
+        const float* input_ptr = input.data() + offset;
+        float* output_ptr = output.data() + offset;
+        inference_handler->process(&input_ptr, &output_ptr, 4800);
+    }
+
+    // Nothing was dropped or zero filled, the output is the input delayed by the latency
+    EXPECT_EQ(inference_handler->get_stats().m_missed_blocks, 0);
+    for (size_t i = 0; i < output.size(); ++i) {
+        float expected = i < (size_t) latency ? 0.f : input[i - latency];
+        ASSERT_FLOAT_EQ(output[i], expected) << "i=" << i;
+    }
+}
+
+TEST_F(InferenceHandlerTest, RingBufferCapacityTooSmall){
+    // Far below a host buffer, the session raises it to the capacity it needs
+    m_inference_config.m_ring_buffer_capacity = 64;
+    SleepingProcessor sleeping_processor(m_inference_config);
+    sleeping_processor.m_inference_time_us.store(0);
+    auto inference_handler = create_inference_handler(sleeping_processor, HostAudioConfig(1024, 48000), true);
+    int latency = inference_handler->get_latency();
+
+    std::vector<float> output;
+    AudioBufferF test_buffer(1, 1024);
+    float next_sample = 1.f;
+    for (int block = 0; block < 8; ++block) {
+        for (size_t i = 0; i < 1024; ++i) {
+            test_buffer.get_write_pointer(0)[i] = next_sample++;
+        }
+        process_block(*inference_handler, test_buffer, &output);
+    }
+    for (size_t i = 0; i < output.size(); ++i) {
+        float expected = i < (size_t) latency ? 0.f : (float) (i - latency + 1);
+        ASSERT_FLOAT_EQ(output[i], expected) << "i=" << i;
+    }
+}
+
+TEST_F(InferenceHandlerTest, ChunkSizeSelection){
+    m_tensor_shape = {{{{1, 2048}}, {{1, 2048}}}};
+    m_inference_config = InferenceConfig(m_model_data, m_tensor_shape, 5.f);
+    // Only the 256 sample chunks are fast. The selection is deterministic, since a sleep only ever overshoots and the 256 sample chunks keep up unless an inference takes seven times as long.
+    SleepingProcessor sleeping_processor(m_inference_config);
+    sleeping_processor.m_inference_time_us.store(4000);
+    sleeping_processor.m_chunk_inference_time_us[256].store(500);
+    int full_size_latency = create_inference_handler(sleeping_processor)->get_latency();
+
+    // With a host buffer of 5.3 ms, the 64 and 128 sample chunks need too many inferences per buffer
+    m_inference_config.m_chunk_sizes = {512, 64, 256, 128};
+    auto inference_handler = create_inference_handler(sleeping_processor);
+    EXPECT_EQ(inference_handler->get_chunk_size(), 256);
+    int latency = inference_handler->get_latency();
+    EXPECT_LT(latency, full_size_latency);
+    // The config of the user keeps its shapes
+    EXPECT_EQ(m_inference_config.get_chunk_size(), 2048);
+    EXPECT_EQ(m_inference_config.get_input_shape()[0], std::vector<int64_t>({1, 2048}));
+
+    // Every prepare of another host config selects again from all candidates. If the 256 sample chunks slow down too, none keeps up and the largest one is used.
+    sleeping_processor.m_chunk_inference_time_us[256].store(4000);
+    inference_handler->prepare(HostAudioConfig(128, 48000));
+    EXPECT_EQ(inference_handler->get_chunk_size(), 512);
+    sleeping_processor.m_chunk_inference_time_us[256].store(500);
+    // The selection for a host config is kept, so preparing for it again does not benchmark the candidates
+    int num_inferences = sleeping_processor.m_num_inferences.load();
+    inference_handler->prepare(HostAudioConfig(256, 48000));
+    EXPECT_EQ(sleeping_processor.m_num_inferences.load(), num_inferences);
+    EXPECT_EQ(inference_handler->get_chunk_size(), 256);
+    EXPECT_EQ(inference_handler->get_latency(), latency);
+
+    // The session runs with the resized tensors, the output is the input delayed by the latency
+    std::vector<float> output;
+    AudioBufferF test_buffer(1, 256);
+    float next_sample = 1.f;
+    for (int block = 0; block < 50; ++block) {
+        for (size_t i = 0; i < 256; ++i) {
+            test_buffer.get_write_pointer(0)[i] = next_sample++;
+        }
+        process_block(*inference_handler, test_buffer, &output);
+    }
+    EXPECT_EQ(inference_handler->get_stats().m_missed_blocks, 0);
+    for (size_t i = 0; i < output.size(); ++i) {
+        float expected = i < (size_t) latency ? 0.f : (float) (i - latency + 1);
+        ASSERT_FLOAT_EQ(output[i], expected) << "i=" << i;
+    }
+}
+
+TEST(InferenceHandler, ChunkSizeTimeAxis){
+    std::vector<ModelData> model_data;
+    // 64 channels of 32 samples, the channel dimension is the larger one
+    std::vector<TensorShape> tensor_shape = {{{{1, 64, 40}}, {{1, 64, 32}}}};
+    InferenceConfig inference_config(model_data, tensor_shape, 5.f, 0, 0, {0, 0}, {64, 64});
+    EXPECT_EQ(inference_config.get_chunk_size(), 32);
+
+    // The last dimension is the default time axis, the input keeps its 8 past samples
+    EXPECT_TRUE(inference_config.set_chunk_size(16));
+    EXPECT_EQ(inference_config.get_input_shape()[0], std::vector<int64_t>({1, 64, 24}));
+    EXPECT_EQ(inference_config.get_output_shape()[0], std::vector<int64_t>({1, 64, 16}));
+
+    // Samples first, the channels keep their number
+    std::vector<TensorShape> samples_first_shape = {{{{1, 24, 64}}, {{1, 16, 64}}}};
+    InferenceConfig samples_first_config(model_data, samples_first_shape, 5.f, 0, 0, {0, 0}, {64, 64});
+    samples_first_config.m_time_axis = {1, 1};
+    EXPECT_TRUE(samples_first_config.set_chunk_size(32));
+    EXPECT_EQ(samples_first_config.get_input_shape()[0], std::vector<int64_t>({1, 40, 64}));
+    EXPECT_EQ(samples_first_config.get_output_shape()[0], std::vector<int64_t>({1, 32, 64}));
+
+    // An axis outside of the tensor keeps the shapes
+    samples_first_config.m_time_axis = {3, 1};
+    EXPECT_FALSE(samples_first_config.set_chunk_size(16));
+    EXPECT_EQ(samples_first_config.get_output_shape()[0], std::vector<int64_t>({1, 32, 64}));
+}
+
+// Custom backend that counts the inferences of a session in its state tensor and outputs the count
+class CountingProcessor : public BackendBase {
+public:
+    CountingProcessor(InferenceConfig& inference_config) : BackendBase(inference_config) {}
+
+    void process([[maybe_unused]] AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) override {
+        float state;
+        session->get_input_tensor(&state, 1);
+        // Inferences that overlap would read the same state
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        state += 1.f;
+        std::fill_n(output.get_write_pointer(0), output.get_num_samples(), state);
+        session->set_output_tensor(&state, 1);
+    }
+};
+
+TEST_F(InferenceHandlerTest, StatefulSharedProcessor){
+    m_tensor_shape = {{{{1, 256}, {1, 1}}, {{1, 256}, {1, 1}}}};
+    m_inference_config = InferenceConfig(m_model_data, m_tensor_shape, 5.f);
+    m_inference_config.m_state_indices = {{1, 1}};
+    CountingProcessor counting_processor(m_inference_config);
+    // Both sessions share the processor, each block submits two inferences per session
+    std::vector<std::unique_ptr<InferenceHandler>> inference_handlers;
+    for (int i = 0; i < 2; ++i) {
+        inference_handlers.push_back(create_inference_handler(counting_processor, HostAudioConfig(512, 48000), false, 4));
+    }
+
+    std::vector<std::vector<float>> outputs(inference_handlers.size());
+    AudioBufferF test_buffer(1, 512);
+    for (int block = 0; block < 50; ++block) {
+        for (size_t i = 0; i < inference_handlers.size(); ++i) {
+            test_buffer.clear();
+            process_block(*inference_handlers[i], test_buffer, &outputs[i]);
+        }
+    }
+
+    // Every session counts its own inferences one after another
+    for (size_t i = 0; i < inference_handlers.size(); ++i) {
+        EXPECT_EQ(inference_handlers[i]->get_stats().m_missed_blocks, 0);
+        size_t latency = (size_t) inference_handlers[i]->get_latency();
+        for (size_t n = 0; n < outputs[i].size(); ++n) {
+            float expected = n < latency ? 0.f : (float) ((n - latency) / 256 + 1);
+            ASSERT_FLOAT_EQ(outputs[i][n], expected) << "session " << i << " n=" << n;
+        }
+    }
+}
+
+TEST_F(InferenceHandlerTest, StatefulHotSwap){
+    m_tensor_shape = {{{{1, 256}, {1, 1}}, {{1, 256}, {1, 1}}}};
+    m_inference_config = InferenceConfig(m_model_data, m_tensor_shape, 5.f);
+    m_inference_config.m_state_indices = {{1, 1}};
+    CountingProcessor previous_processor(m_inference_config);
+    CountingProcessor next_processor(m_inference_config);
+    auto inference_handler = create_inference_handler(previous_processor, HostAudioConfig(256, 48000), true);
+    size_t latency = (size_t) inference_handler->get_latency();
+
+    std::vector<float> output;
+    AudioBufferF test_buffer(1, 256);
+    auto process_silence = [&]() {
+        test_buffer.clear();
+        process_block(*inference_handler, test_buffer, &output);
+    };
+    for (int i = 0; i < 10; ++i) {
+        process_silence();
+    }
+    size_t num_crossfade_inferences = 4;
+    EXPECT_TRUE(inference_handler->set_custom_processor_async(next_processor, num_crossfade_inferences * 256));
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(INFERENCE_TIMEOUT_S);
+    while (inference_handler->is_swapping_model() && std::chrono::steady_clock::now() < timeout) {
+        process_silence();
+    }
+    EXPECT_FALSE(inference_handler->is_swapping_model());
+    for (int i = 0; i < 10; ++i) {
+        process_silence();
+    }
+
+    // Last sample of every inference, the previous processor counts from the first inference and the next one from the swap
+    std::vector<float> counts;
+    for (size_t n = latency + 255; n < output.size(); n += 256) {
+        counts.push_back(output[n]);
+    }
+    size_t swap_index = counts.size() - (size_t) counts.back();
+    ASSERT_GT(swap_index, 0u);
+    for (size_t k = 0; k < counts.size(); ++k) {
+        float previous_count = (float) (k + 1);
+        float next_count = (float) (k - swap_index + 1);
+        float expected = previous_count;
+        if (k >= swap_index + num_crossfade_inferences - 1) {
+            expected = next_count;
+        } else if (k >= swap_index) {
+            float gain = (float) (k - swap_index + 1) / (float) num_crossfade_inferences;
+            expected = previous_count + gain * (next_count - previous_count);
+        }
+        ASSERT_FLOAT_EQ(counts[k], expected) << "k=" << k;
+    }
+}
+
+// Custom backend that passes the audio through and counts the inferences
+class PassThroughProcessor : public BackendBase {
+public:
+    PassThroughProcessor(InferenceConfig& inference_config) : BackendBase(inference_config) {}
+
+    void process(AudioBufferF& input, AudioBufferF& output, std::shared_ptr<SessionElement> session) override {
+        m_num_inferences.fetch_add(1);
+        BackendBase::process(input, output, session);
+    }
+
+    std::atomic<int> m_num_inferences{0};
+};
+
+TEST_F(InferenceHandlerTest, ModelSampleRate){
+    m_inference_config.m_max_inference_time = 2.f;
+    m_inference_config.m_model_sample_rate = 16000.;
+    PassThroughProcessor pass_through_processor(m_inference_config);
+    // A block of 480 samples is 160 samples at the model sample rate, so only some blocks complete an inference. The non-realtime mode waits for them whenever a block needs their results.
+    auto inference_handler = create_inference_handler(pass_through_processor, HostAudioConfig(480, 48000), true);
+    int latency = inference_handler->get_latency();
+
+    // One second of a 440 Hz sine
+    const double phase_increment = 2. * 3.14159265358979323846 * 440. / 48000.;
+    std::vector<float> output;
+    AudioBufferF test_buffer(1, 480);
+    size_t num_samples = 0;
+    for (int block = 0; block < 100; ++block) {
+        for (size_t i = 0; i < 480; ++i) {
+            test_buffer.get_write_pointer(0)[i] = (float) std::sin(phase_increment * (double) num_samples++);
+        }
+        process_block(*inference_handler, test_buffer, &output);
+    }
+    EXPECT_EQ(inference_handler->get_stats().m_missed_blocks, 0);
+
+    // The model only processed one second at 16 kHz
+    EXPECT_LE(pass_through_processor.m_num_inferences.load(), 16000 / 256 + 1);
+    // The output is the sine delayed by the latency, which is rounded to whole samples. The resampler starts from silence.
+    for (size_t i = (size_t) latency + 200; i < output.size(); ++i) {
+        float expected = (float) std::sin(phase_increment * (double) (i - latency));
+        ASSERT_NEAR(output[i], expected, 0.05f) << "i=" << i;
+    }
+}
+
 // TODO fix this test
 // TEST(InferenceTest, BufferNotFull){
 
@@ -1,5 +1,8 @@
 #include "gtest/gtest.h"
 #include <anira/anira.h>
+#include <fstream>
+#include <memory>
+#include <string>
 
 using namespace anira;
 TEST(AudioBuffer, SimpleWrite){
@@ -140,4 +143,94 @@ TEST(AudioBuffer, InvalidChannelsSwap){
 
 //     // TODO assert something here?
 
-// }
\ No newline at end of file
+// }
+
+TEST(AudioBuffer, AlignedAllocation){
+    AudioBufferF buffer(2, 33);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer.data()) % AlignedAllocator::ALIGNMENT, 0);
+
+    // resizing keeps the data like realloc
+    MemoryBlock<float> block(5);
+    for (size_t i = 0; i < block.size(); i++){
+        block[i] = (float) i;
+    }
+    block.resize(1000);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(block.data()) % AlignedAllocator::ALIGNMENT, 0);
+    for (size_t i = 0; i < 5; i++){
+        EXPECT_FLOAT_EQ(block[i], (float) i);
+    }
+}
+
+TEST(AudioBuffer, HugePageAllocation){
+    // Falls back to transparent huge pages or aligned allocation when no huge pages are available
+    MemoryOptions::set_use_huge_pages(true);
+    MemoryBlock<float, HugePageAllocator> block(HugePageAllocator::HUGE_PAGE_SIZE);
+    MemoryBlock<float, HugePageAllocator> small_block(16);
+    MemoryOptions::set_use_huge_pages(false);
+
+    ASSERT_NE(block.data(), nullptr);
+    ASSERT_NE(small_block.data(), nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(block.data()) % HugePageAllocator::ALIGNMENT, 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(small_block.data()) % HugePageAllocator::ALIGNMENT, 0);
+    for (size_t i = 0; i < block.size(); i++){
+        block[i] = (float) i;
+    }
+    // the options changed since the allocation, the block is still freed the way it was allocated
+    block.resize(8);
+    for (size_t i = 0; i < block.size(); i++){
+        EXPECT_FLOAT_EQ(block[i], (float) i);
+    }
+}
+
+#if __linux__
+namespace {
+
+size_t get_locked_kilobytes() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmLck:", 0) == 0) {
+            return std::stoul(line.substr(6));
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+TEST(AudioBuffer, LockedAllocation){
+    size_t block_size = MemoryOptions::LOCKED_ARENA_THRESHOLD / sizeof(float);
+    size_t locked_before = get_locked_kilobytes();
+    MemoryOptions::set_lock_memory(true);
+    auto first_block = std::make_unique<MemoryBlock<float>>(block_size);
+    MemoryBlock<float> second_block(block_size);
+    size_t locked_blocks = get_locked_kilobytes() - locked_before;
+
+    // small blocks share the locked chunks of the arena instead of locking a page each
+    std::vector<std::unique_ptr<MemoryBlock<float>>> small_blocks;
+    for (size_t i = 0; i < 100; i++){
+        small_blocks.emplace_back(std::make_unique<MemoryBlock<float>>(10));
+    }
+    MemoryOptions::set_lock_memory(false);
+    if (locked_blocks == 0) {
+        GTEST_SKIP() << "The memlock limit does not allow locking memory";
+    }
+    size_t locked_small_blocks = get_locked_kilobytes() - locked_before - locked_blocks;
+    EXPECT_LE(locked_small_blocks, MemoryOptions::LOCKED_ARENA_CHUNK_SIZE / 1024);
+    for (auto& small_block : small_blocks){
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(small_block->data()) % AlignedAllocator::ALIGNMENT, 0);
+    }
+    // freed small blocks are reused
+    float* freed_data = small_blocks.back()->data();
+    small_blocks.back().reset();
+    MemoryOptions::set_lock_memory(true);
+    MemoryBlock<float> reused_block(10);
+    MemoryOptions::set_lock_memory(false);
+    EXPECT_EQ(reused_block.data(), freed_data);
+
+    // every large locked block has its own pages, so freeing one does not unlock the other, even though the option changed meanwhile
+    first_block.reset();
+    EXPECT_EQ(get_locked_kilobytes() - locked_before - locked_small_blocks, locked_blocks / 2);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(second_block.data()) % AlignedAllocator::ALIGNMENT, 0);
+}
+#endif
@@ -0,0 +1,104 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include <anira/anira.h>
+
+using namespace anira;
+
+TEST(FreeList, AcquiresLowestFreeIndex){
+    FreeList free_list(3);
+    size_t index;
+    ASSERT_TRUE(free_list.try_acquire(index));
+    EXPECT_EQ(index, 0u);
+    ASSERT_TRUE(free_list.try_acquire(index));
+    EXPECT_EQ(index, 1u);
+    ASSERT_TRUE(free_list.try_acquire(index));
+    EXPECT_EQ(index, 2u);
+    EXPECT_FALSE(free_list.try_acquire(index));
+
+    free_list.release(1);
+    ASSERT_TRUE(free_list.try_acquire(index));
+    EXPECT_EQ(index, 1u);
+    EXPECT_FALSE(free_list.try_acquire(index));
+}
+
+TEST(FreeList, SpansSeveralWords){
+    FreeList free_list(130);
+    std::vector<bool> acquired(130, false);
+    size_t index;
+    for (size_t i = 0; i < 130; ++i) {
+        ASSERT_TRUE(free_list.try_acquire(index));
+        ASSERT_LT(index, 130u);
+        EXPECT_FALSE(acquired[index]);
+        acquired[index] = true;
+    }
+    EXPECT_FALSE(free_list.try_acquire(index));
+
+    free_list.release(129);
+    ASSERT_TRUE(free_list.try_acquire(index));
+    EXPECT_EQ(index, 129u);
+
+    free_list.resize(2);
+    EXPECT_EQ(free_list.get_size(), 2u);
+    EXPECT_EQ(free_list.acquire(), 0u);
+    EXPECT_EQ(free_list.acquire(), 1u);
+    EXPECT_FALSE(free_list.try_acquire(index));
+}
+
+TEST(FreeList, AcquireIndex){
+    FreeList free_list(3);
+    free_list.acquire_index(1);
+    size_t index;
+    ASSERT_TRUE(free_list.try_acquire(index));
+    EXPECT_EQ(index, 0u);
+    ASSERT_TRUE(free_list.try_acquire(index));
+    EXPECT_EQ(index, 2u);
+    EXPECT_FALSE(free_list.try_acquire(index));
+
+    std::atomic<bool> acquired{false};
+    std::thread waiter([&]() {
+        free_list.acquire_index(2);
+        acquired.store(true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_FALSE(acquired.load());
+    free_list.release(2);
+    waiter.join();
+    EXPECT_TRUE(acquired.load());
+}
+
+TEST(FreeList, ConcurrentAcquireRelease){
+    constexpr size_t num_indices = 3;
+    constexpr int num_threads = 8;
+    constexpr int num_iterations = 20000;
+    FreeList free_list(num_indices);
+    std::vector<std::atomic<int>> users(num_indices);
+    std::atomic<bool> overlap{false};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < num_iterations; ++i) {
+                size_t index = free_list.acquire();
+                // No other thread may hold the same index
+                if (users[index].fetch_add(1) != 0) {
+                    overlap.store(true);
+                }
+                users[index].fetch_sub(1);
+                free_list.release(index);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_FALSE(overlap.load());
+    size_t index;
+    for (size_t i = 0; i < num_indices; ++i) {
+        EXPECT_TRUE(free_list.try_acquire(index));
+    }
+    EXPECT_FALSE(free_list.try_acquire(index));
+}
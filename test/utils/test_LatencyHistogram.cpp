@@ -0,0 +1,71 @@
+#include "gtest/gtest.h"
+#include <anira/anira.h>
+#include <thread>
+
+using namespace anira;
+
+TEST(LatencyHistogram, Percentiles){
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.get_percentile(99.).count(), 0);
+
+    // 1us to 1000us in steps of 1us
+    for (int i = 1; i <= 1000; ++i) {
+        histogram.record(std::chrono::microseconds(i));
+    }
+
+    LatencyStatistics statistics = histogram.get_statistics();
+    EXPECT_EQ(statistics.m_count, 1000);
+    EXPECT_EQ(statistics.m_mean.count(), 500500);
+    EXPECT_EQ(statistics.m_max.count(), 1000000);
+
+    // Percentiles are the upper bound of their bucket, which is at most 1 / SUB_BUCKETS above the value
+    double tolerance = 1. / LatencyHistogram::SUB_BUCKETS;
+    EXPECT_GE(statistics.m_p50.count(), 500000);
+    EXPECT_LE(statistics.m_p50.count(), 500000 * (1. + tolerance));
+    EXPECT_GE(statistics.m_p90.count(), 900000);
+    EXPECT_LE(statistics.m_p90.count(), 900000 * (1. + tolerance));
+    EXPECT_GE(statistics.m_p99.count(), 990000);
+    EXPECT_LE(statistics.m_p99.count(), 1000000);
+    EXPECT_EQ(histogram.get_percentile(100.).count(), 1000000);
+}
+
+TEST(LatencyHistogram, SmallAndLargeValues){
+    LatencyHistogram histogram;
+    for (size_t i = 0; i < LatencyHistogram::SUB_BUCKETS; ++i) {
+        histogram.record(std::chrono::nanoseconds(i));
+    }
+    // Small values are counted exactly
+    EXPECT_EQ(histogram.get_percentile(50.).count(), LatencyHistogram::SUB_BUCKETS / 2 - 1);
+
+    // Durations beyond the range end up in the last bucket
+    histogram.record(std::chrono::hours(1));
+    histogram.record(std::chrono::nanoseconds(-5));
+    EXPECT_EQ(histogram.get_count(), LatencyHistogram::SUB_BUCKETS + 2);
+    EXPECT_EQ(histogram.get_statistics().m_max, std::chrono::hours(1));
+
+    histogram.reset();
+    EXPECT_EQ(histogram.get_count(), 0);
+    EXPECT_EQ(histogram.get_statistics().m_max.count(), 0);
+}
+
+TEST(LatencyHistogram, ConcurrentRecording){
+    const int num_threads = 4;
+    const int num_records = 10000;
+    LatencyHistogram histogram;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&histogram, t]() {
+            for (int i = 0; i < num_records; ++i) {
+                histogram.record(std::chrono::microseconds(t + 1));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(histogram.get_count(), num_threads * num_records);
+    EXPECT_EQ(histogram.get_statistics().m_max, std::chrono::microseconds(num_threads));
+    EXPECT_EQ(histogram.get_statistics().m_mean.count(), 2500);
+}
@@ -0,0 +1,128 @@
+#include "gtest/gtest.h"
+#include <anira/anira.h>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using namespace anira;
+
+struct TestModel {
+    int m_value;
+};
+
+TEST(ModelCache, SharesModels){
+    int num_loads = 0;
+    auto load = [&num_loads]() {
+        num_loads++;
+        return std::make_shared<TestModel>(TestModel{num_loads});
+    };
+
+    std::shared_ptr<TestModel> model_a = ModelCache::get<TestModel>("a", load);
+    std::shared_ptr<TestModel> model_a_again = ModelCache::get<TestModel>("a", load);
+    std::shared_ptr<TestModel> model_b = ModelCache::get<TestModel>("b", load);
+
+    EXPECT_EQ(model_a, model_a_again);
+    EXPECT_NE(model_a, model_b);
+    EXPECT_EQ(num_loads, 2);
+    EXPECT_EQ(ModelCache::get_num_models<TestModel>(), 2);
+
+    // Models are released with their last user and loaded again afterwards
+    model_a.reset();
+    model_a_again.reset();
+    EXPECT_EQ(ModelCache::get_num_models<TestModel>(), 1);
+    model_a = ModelCache::get<TestModel>("a", load);
+    EXPECT_EQ(num_loads, 3);
+    EXPECT_EQ(model_a->m_value, 3);
+}
+
+TEST(ModelCache, BinaryModelKey){
+    std::vector<char> bytes = {1, 2, 3, 4};
+    std::vector<char> same_bytes = bytes;
+    std::vector<char> other_bytes = {1, 2, 3, 5};
+    std::vector<TensorShape> tensor_shape = {{{{1, 64}}, {{1, 64}}}};
+
+    InferenceConfig config({{bytes.data(), bytes.size(), CUSTOM}}, tensor_shape, 5.f);
+    // The key only depends on the model and the shapes, not on the rest of the config
+    InferenceConfig same_config({{same_bytes.data(), same_bytes.size(), CUSTOM}}, tensor_shape, 10.f, 0, 3);
+    InferenceConfig other_model_config({{other_bytes.data(), other_bytes.size(), CUSTOM}}, tensor_shape, 5.f);
+    InferenceConfig other_shape_config({{bytes.data(), bytes.size(), CUSTOM}}, {{{{1, 128}}, {{1, 128}}}}, 5.f);
+
+    std::string key = ModelCache::get_key(config, CUSTOM);
+    EXPECT_EQ(key, ModelCache::get_key(same_config, CUSTOM));
+    EXPECT_NE(key, ModelCache::get_key(other_model_config, CUSTOM));
+    EXPECT_NE(key, ModelCache::get_key(other_shape_config, CUSTOM));
+}
+
+TEST(ModelCache, LoadsDifferentModelsInParallel){
+    std::atomic<bool> started_a{false};
+    std::atomic<bool> loaded_b{false};
+    // Loading a only finishes after b was loaded, which would never happen if a blocked the cache
+    std::thread thread_a([&]() {
+        ModelCache::get<TestModel>("parallel_a", [&]() {
+            started_a.store(true);
+            while (!loaded_b.load()) {
+                std::this_thread::yield();
+            }
+            return std::make_shared<TestModel>(TestModel{1});
+        });
+    });
+    while (!started_a.load()) {
+        std::this_thread::yield();
+    }
+    std::shared_ptr<TestModel> model_b = ModelCache::get<TestModel>("parallel_b", []() {
+        return std::make_shared<TestModel>(TestModel{2});
+    });
+    loaded_b.store(true);
+    thread_a.join();
+    EXPECT_EQ(model_b->m_value, 2);
+}
+
+TEST(ModelCache, WaitsForModelThatIsLoading){
+    std::atomic<int> num_loads{0};
+    std::atomic<bool> release{false};
+    auto load = [&]() {
+        num_loads++;
+        while (!release.load()) {
+            std::this_thread::yield();
+        }
+        return std::make_shared<TestModel>(TestModel{num_loads.load()});
+    };
+    std::shared_ptr<TestModel> model_a, model_b;
+    std::thread thread_a([&]() { model_a = ModelCache::get<TestModel>("waiting", load); });
+    while (num_loads.load() == 0) {
+        std::this_thread::yield();
+    }
+    std::thread thread_b([&]() { model_b = ModelCache::get<TestModel>("waiting", load); });
+    release.store(true);
+    thread_a.join();
+    thread_b.join();
+    EXPECT_EQ(num_loads.load(), 1);
+    EXPECT_EQ(model_a, model_b);
+}
+
+TEST(ModelCache, BinaryModelKeyIsSha256){
+    std::vector<char> bytes = {'a', 'b', 'c'};
+    InferenceConfig config({{bytes.data(), bytes.size(), CUSTOM}}, {{{{1, 64}}, {{1, 64}}}}, 5.f);
+    EXPECT_NE(ModelCache::get_key(config, CUSTOM).find("|3|ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad|"), std::string::npos);
+}
+
+TEST(ModelCache, ModelFileKey){
+    std::filesystem::path model_path = std::filesystem::temp_directory_path() / "anira_test_model_cache.bin";
+    {
+        std::ofstream file(model_path);
+        file << "model";
+    }
+    std::vector<TensorShape> tensor_shape = {{{{1, 64}}, {{1, 64}}}};
+    InferenceConfig config({{model_path.string(), CUSTOM}}, tensor_shape, 5.f);
+    std::string key = ModelCache::get_key(config, CUSTOM);
+    EXPECT_EQ(key, ModelCache::get_key(config, CUSTOM));
+
+    // A rewritten model file is a different model
+    {
+        std::ofstream file(model_path);
+        file << "changed model";
+    }
+    EXPECT_NE(key, ModelCache::get_key(config, CUSTOM));
+
+    std::filesystem::remove(model_path);
+}
@@ -0,0 +1,61 @@
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include <anira/anira.h>
+
+using namespace anira;
+
+TEST(ParallelFor, CallsEveryIndexOnce){
+    std::vector<std::atomic<int>> calls(100);
+    parallel_for(calls.size(), [&calls](size_t index) {
+        calls[index].fetch_add(1);
+    }, 4);
+    for (auto& call : calls) {
+        EXPECT_EQ(call.load(), 1);
+    }
+
+    // Nothing to do and a single thread are valid too
+    parallel_for(0, [](size_t) { FAIL(); });
+    int sum = 0;
+    parallel_for(10, [&sum](size_t index) { sum += (int) index; }, 1);
+    EXPECT_EQ(sum, 45);
+}
+
+TEST(ParallelFor, RunsConcurrently){
+    std::mutex mutex;
+    std::set<std::thread::id> thread_ids;
+    std::atomic<int> running{0};
+    std::atomic<int> max_running{0};
+    parallel_for(4, [&](size_t) {
+        int now_running = running.fetch_add(1) + 1;
+        int max = max_running.load();
+        while (now_running > max && !max_running.compare_exchange_weak(max, now_running)) {
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            thread_ids.insert(std::this_thread::get_id());
+        }
+        // Long enough for the other threads to pick up their tasks, also on a loaded machine
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        running.fetch_sub(1);
+    }, 4);
+    EXPECT_EQ(thread_ids.size(), 4u);
+    EXPECT_EQ(max_running.load(), 4);
+    EXPECT_TRUE(thread_ids.count(std::this_thread::get_id()));
+}
+
+TEST(ParallelFor, RethrowsException){
+    std::atomic<int> calls{0};
+    EXPECT_THROW(parallel_for(8, [&calls](size_t index) {
+        calls.fetch_add(1);
+        if (index == 3) {
+            throw std::runtime_error("task failed");
+        }
+    }, 2), std::runtime_error);
+    // The other tasks still run
+    EXPECT_EQ(calls.load(), 8);
+}
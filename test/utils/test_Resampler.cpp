@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include <anira/anira.h>
+
+using namespace anira;
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+std::vector<float> sine(double frequency, double sample_rate, size_t num_samples) {
+    std::vector<float> signal(num_samples);
+    for (size_t i = 0; i < num_samples; ++i) {
+        signal[i] = (float) std::sin(2. * PI * frequency * (double) i / sample_rate);
+    }
+    return signal;
+}
+
+std::vector<float> resample(Resampler& resampler, const std::vector<float>& input, const std::vector<size_t>& block_sizes) {
+    std::vector<float> output;
+    std::vector<float> block(resampler.get_max_num_output_samples(*std::max_element(block_sizes.begin(), block_sizes.end())));
+    size_t offset = 0;
+    for (size_t i = 0; offset < input.size(); ++i) {
+        size_t num_samples = std::min(block_sizes[i % block_sizes.size()], input.size() - offset);
+        const float* input_pointer = input.data() + offset;
+        float* output_pointer = block.data();
+        size_t expected_num_samples = resampler.get_num_output_samples(num_samples);
+        size_t num_output_samples = resampler.process(&input_pointer, num_samples, &output_pointer);
+        EXPECT_EQ(num_output_samples, expected_num_samples);
+        EXPECT_LE(num_output_samples, resampler.get_max_num_output_samples(num_samples));
+        output.insert(output.end(), block.begin(), block.begin() + num_output_samples);
+        offset += num_samples;
+    }
+    return output;
+}
+
+} // namespace
+
+TEST(Resampler, DotProductMatchesScalar){
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    for (size_t size = 0; size < 40; ++size) {
+        std::vector<float> a(size), b(size);
+        float expected = 0.f;
+        for (size_t i = 0; i < size; ++i) {
+            a[i] = distribution(generator);
+            b[i] = distribution(generator);
+            expected += a[i] * b[i];
+        }
+        EXPECT_NEAR(Resampler::dot_product(a.data(), b.data(), size), expected, 1e-5f);
+    }
+}
+
+TEST(Resampler, SineIsDelayedByReportedDelay){
+    const std::vector<std::array<double, 2>> rates = {{48000., 16000.}, {16000., 48000.}, {44100., 48000.}, {96000., 44100.}};
+    for (const auto& [input_rate, output_rate] : rates) {
+        Resampler resampler;
+        ASSERT_TRUE(resampler.prepare(input_rate, output_rate, 1, 512));
+        double frequency = 1000.;
+        std::vector<float> output = resample(resampler, sine(frequency, input_rate, 48000), {512});
+
+        double delay = resampler.get_delay() / input_rate;
+        // The filter starts from silence, so the first output samples are skipped
+        size_t start = (size_t) std::ceil(4. * delay * output_rate);
+        ASSERT_GT(output.size(), start + 1000);
+        for (size_t i = start; i < output.size(); ++i) {
+            double expected = std::sin(2. * PI * frequency * ((double) i / output_rate - delay));
+            ASSERT_NEAR(output[i], expected, 2e-3) << input_rate << " Hz to " << output_rate << " Hz, sample " << i;
+        }
+    }
+}
+
+TEST(Resampler, RemovesFrequenciesAboveNyquist){
+    Resampler resampler;
+    ASSERT_TRUE(resampler.prepare(48000., 16000., 1, 512));
+    // Would alias to 4 kHz
+    std::vector<float> output = resample(resampler, sine(12000., 48000., 48000), {512});
+    for (size_t i = output.size() / 2; i < output.size(); ++i) {
+        ASSERT_NEAR(output[i], 0.f, 1e-3);
+    }
+}
+
+TEST(Resampler, OutputDoesNotDependOnBlockSize){
+    std::vector<float> input = sine(440., 44100., 20000);
+    Resampler fixed, varying;
+    ASSERT_TRUE(fixed.prepare(44100., 48000., 1, 256));
+    ASSERT_TRUE(varying.prepare(44100., 48000., 1, 256));
+    std::vector<float> expected = resample(fixed, input, {256});
+    // Blocks larger than the maximum are split internally
+    std::vector<float> output = resample(varying, input, {1, 7, 256, 100, 1000, 3});
+    ASSERT_EQ(output.size(), expected.size());
+    for (size_t i = 0; i < output.size(); ++i) {
+        ASSERT_FLOAT_EQ(output[i], expected[i]);
+    }
+}
+
+TEST(Resampler, ProducesRequestedNumberOfOutputSamples){
+    for (double output_rate : {16000., 44100., 96000.}) {
+        Resampler resampler;
+        ASSERT_TRUE(resampler.prepare(48000., output_rate, 2, 128));
+        std::vector<float> input(512, 0.5f);
+        std::vector<float> output(2 * 128);
+        const float* input_pointers[2] = {input.data(), input.data()};
+        float* output_pointers[2] = {output.data(), output.data() + 128};
+        for (size_t num_output_samples : {128, 1, 37, 128, 64, 0, 100}) {
+            size_t num_input_samples = resampler.get_num_input_samples(num_output_samples);
+            EXPECT_LE(num_input_samples, resampler.get_max_num_input_samples(num_output_samples));
+            EXPECT_EQ(resampler.process(input_pointers, num_input_samples, output_pointers, num_output_samples), num_output_samples);
+        }
+    }
+}
+
+TEST(Resampler, RejectsComplexRatio){
+    Resampler resampler;
+    EXPECT_FALSE(resampler.prepare(48000., 44099., 1, 512));
+    EXPECT_TRUE(resampler.prepare(48000., 44100., 1, 512));
+    EXPECT_EQ(resampler.get_up_factor(), 147);
+    EXPECT_EQ(resampler.get_down_factor(), 160);
+}
@@ -0,0 +1,258 @@
+#include "gtest/gtest.h"
+#include <anira/anira.h>
+#include <thread>
+
+using namespace anira;
+
+TEST(RingBuffer, BlockPushPop){
+    RingBuffer ring_buffer;
+    ring_buffer.initialize_with_positions(1, 10);
+
+    std::vector<float> block = {1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f};
+    std::vector<float> result(block.size());
+
+    // push and pop twice so that the second block wraps around the end of the buffer
+    for (int repeat = 0; repeat < 2; repeat++){
+        ring_buffer.push_block(0, block.data(), block.size());
+        ASSERT_EQ(ring_buffer.get_available_samples(0), block.size());
+
+        ring_buffer.pop_block(0, result.data(), result.size());
+        ASSERT_EQ(ring_buffer.get_available_samples(0), 0);
+
+        for (size_t i = 0; i < block.size(); i++){
+            EXPECT_FLOAT_EQ(result[i], block[i]);
+        }
+    }
+}
+
+TEST(RingBuffer, BlockMatchesSampleWise){
+    RingBuffer block_buffer;
+    RingBuffer sample_buffer;
+    block_buffer.initialize_with_positions(2, 13);
+    sample_buffer.initialize_with_positions(2, 13);
+    // the first peeks reach behind the first pushed sample, so the history has to be initialized
+    block_buffer.clear_with_positions();
+    sample_buffer.clear_with_positions();
+
+    std::vector<float> block(5);
+    std::vector<float> result(5);
+    float value = 0.f;
+
+    for (int repeat = 0; repeat < 10; repeat++){
+        for (size_t channel = 0; channel < 2; channel++){
+            for (size_t i = 0; i < block.size(); i++){
+                block[i] = value++;
+                sample_buffer.push_sample(channel, block[i]);
+            }
+            block_buffer.push_block(channel, block.data(), block.size());
+            ASSERT_EQ(block_buffer.get_available_samples(channel), sample_buffer.get_available_samples(channel));
+
+            block_buffer.pop_block(channel, result.data(), result.size());
+            for (size_t i = 0; i < result.size(); i++){
+                EXPECT_FLOAT_EQ(result[i], sample_buffer.pop_sample(channel));
+            }
+
+            // the history behind the read position must match as well
+            block_buffer.peek_from_tail(channel, result.data(), result.size(), 8);
+            for (size_t i = 0; i < result.size(); i++){
+                EXPECT_FLOAT_EQ(result[i], sample_buffer.get_sample_from_tail(channel, 8 - i));
+            }
+        }
+    }
+}
+
+TEST(RingBuffer, ZerosAndDiscard){
+    RingBuffer ring_buffer;
+    ring_buffer.initialize_with_positions(1, 8);
+
+    std::vector<float> block = {1.f, 2.f, 3.f, 4.f, 5.f, 6.f};
+    ring_buffer.push_block(0, block.data(), block.size());
+    ring_buffer.discard_block(0, 4);
+    ring_buffer.push_zeros(0, 4);
+    ASSERT_EQ(ring_buffer.get_available_samples(0), 6);
+
+    std::vector<float> expected = {5.f, 6.f, 0.f, 0.f, 0.f, 0.f};
+    for (size_t i = 0; i < expected.size(); i++){
+        EXPECT_FLOAT_EQ(ring_buffer.pop_sample(0), expected[i]);
+    }
+}
+
+TEST(RingBuffer, PopSamplesWithHistory){
+    size_t num_new_samples = 4;
+    size_t num_old_samples = 6;
+    RingBuffer ring_buffer;
+    ring_buffer.initialize_with_positions(1, 16);
+    AudioBufferF output(1, num_new_samples + num_old_samples);
+    PrePostProcessor pp_processor;
+
+    float value = 1.f;
+    for (int repeat = 0; repeat < 8; repeat++){
+        for (size_t i = 0; i < num_new_samples; i++){
+            ring_buffer.push_sample(0, value++);
+        }
+        pp_processor.pop_samples_from_buffer(ring_buffer, output, num_new_samples, num_old_samples);
+
+        // the output holds the last num_new_samples + num_old_samples samples from oldest to newest
+        for (size_t i = 0; i < output.get_num_samples(); i++){
+            float expected = value - (float) (output.get_num_samples() - i);
+            if (expected < 1.f) {
+                continue; // samples before the first push are not initialized
+            }
+            EXPECT_FLOAT_EQ(output.get_sample(0, i), expected) << "repeat=" << repeat << ", i=" << i;
+        }
+    }
+}
+
+TEST(RingBuffer, MirroredWindow){
+    if (!MirroredMemory::is_supported()) {
+        GTEST_SKIP() << "Mirrored memory is not supported on this platform";
+    }
+    RingBuffer ring_buffer;
+    ring_buffer.initialize_with_positions(2, 100, true);
+    ring_buffer.clear_with_positions();
+    ASSERT_TRUE(ring_buffer.is_mirrored());
+    // the capacity is rounded up to the page size
+    size_t capacity = ring_buffer.get_capacity();
+    ASSERT_GE(capacity, 100);
+    ASSERT_EQ(capacity * sizeof(float) % MirroredMemory::get_page_size(), 0);
+
+    size_t block_size = capacity / 3 + 1;
+    size_t window_size = capacity / 2;
+    std::vector<float> block(block_size);
+    std::vector<float> expected(window_size);
+    float value = 0.f;
+
+    // the pushes, pops and windows cross the end of the buffer several times
+    for (int repeat = 0; repeat < 10; repeat++){
+        for (size_t channel = 0; channel < 2; channel++){
+            for (size_t i = 0; i < block_size; i++){
+                block[i] = value++;
+            }
+            ring_buffer.push_block(channel, block.data(), block_size);
+            ring_buffer.pop_block(channel, block.data(), block_size);
+
+            const float* window = ring_buffer.get_window(channel, window_size, window_size);
+            ASSERT_NE(window, nullptr);
+            size_t position = ring_buffer.get_window_position(channel, window);
+            ASSERT_LT(position, capacity);
+            EXPECT_EQ(ring_buffer.get_window_at_position(channel, position), window);
+            ring_buffer.peek_from_tail(channel, expected.data(), window_size, window_size);
+            for (size_t i = 0; i < window_size; i++){
+                EXPECT_FLOAT_EQ(window[i], expected[i]) << "repeat=" << repeat << ", i=" << i;
+            }
+        }
+    }
+}
+
+TEST(RingBuffer, MirroredWindowHop){
+    if (!MirroredMemory::is_supported()) {
+        GTEST_SKIP() << "Mirrored memory is not supported on this platform";
+    }
+    RingBuffer ring_buffer;
+    ring_buffer.initialize_with_positions(1, 1000, true, 300);
+    size_t capacity = ring_buffer.get_capacity();
+    ASSERT_GE(capacity, 1000);
+    EXPECT_EQ(capacity % 300, 0);
+    EXPECT_EQ(capacity * sizeof(float) % MirroredMemory::get_page_size(), 0);
+}
+
+TEST(RingBuffer, ChannelAccess){
+    // Both layouts expose their samples through the same channel methods
+    for (bool mirrored : {false, true}){
+        RingBuffer ring_buffer;
+        ring_buffer.initialize_with_positions(2, 100, mirrored);
+        ASSERT_EQ(ring_buffer.get_num_channels(), 2);
+        size_t capacity = ring_buffer.get_capacity();
+
+        std::vector<float> block = {1.f, 2.f, 3.f};
+        ring_buffer.push_block(1, block.data(), block.size());
+        for (size_t i = 0; i < block.size(); i++){
+            EXPECT_FLOAT_EQ(ring_buffer.get_read_pointer(1)[i], block[i]) << "mirrored=" << mirrored;
+        }
+        ring_buffer.get_write_pointer(1)[capacity - 1] = 4.f;
+        EXPECT_FLOAT_EQ(ring_buffer.get_sample_from_tail(1, 1), 4.f);
+
+        // Clearing zeroes the samples, but the pushed ones stay available
+        ring_buffer.clear();
+        EXPECT_EQ(ring_buffer.get_available_samples(1), block.size());
+        for (size_t i = 0; i < capacity; i++){
+            ASSERT_FLOAT_EQ(ring_buffer.get_read_pointer(1)[i], 0.f) << "mirrored=" << mirrored << ", i=" << i;
+        }
+    }
+}
+
+TEST(RingBuffer, PopSamplesAsView){
+    if (!MirroredMemory::is_supported()) {
+        GTEST_SKIP() << "Mirrored memory is not supported on this platform";
+    }
+    size_t num_new_samples = 400;
+    size_t num_old_samples = 600;
+    RingBuffer ring_buffer;
+    ring_buffer.initialize_with_positions(1, 1500, true);
+    ring_buffer.clear_with_positions();
+    AudioBufferF output(1, num_new_samples + num_old_samples);
+    PrePostProcessor pp_processor;
+
+    float value = 1.f;
+    for (int repeat = 0; repeat < 20; repeat++){
+        for (size_t i = 0; i < num_new_samples; i++){
+            ring_buffer.push_sample(0, value++);
+        }
+        pp_processor.pop_samples_from_buffer(ring_buffer, output, num_new_samples, num_old_samples);
+        ASSERT_TRUE(output.is_view());
+        ASSERT_EQ(output.data(), output.get_read_pointer(0));
+
+        for (size_t i = 0; i < output.get_num_samples(); i++){
+            float expected = std::max(value - (float) (output.get_num_samples() - i), 0.f);
+            EXPECT_FLOAT_EQ(output.get_sample(0, i), expected) << "repeat=" << repeat << ", i=" << i;
+        }
+    }
+
+    // other pops copy into the own data again
+    for (size_t i = 0; i < output.get_num_samples(); i++){
+        ring_buffer.push_sample(0, value++);
+    }
+    pp_processor.pop_samples_from_buffer(ring_buffer, output);
+    EXPECT_FALSE(output.is_view());
+    EXPECT_FLOAT_EQ(output.get_sample(0, 0), value - (float) output.get_num_samples());
+}
+
+TEST(RingBuffer, ConcurrentProducerConsumer){
+    size_t num_channels = 2;
+    size_t block_size = 7;
+    size_t num_blocks = 20000;
+    RingBuffer ring_buffer;
+    ring_buffer.initialize_with_positions(num_channels, 64);
+
+    std::thread producer([&]() {
+        std::vector<float> block(block_size);
+        float value = 0.f;
+        for (size_t n = 0; n < num_blocks; n++){
+            for (size_t i = 0; i < block_size; i++){
+                block[i] = value++;
+            }
+            for (size_t channel = 0; channel < num_channels; channel++){
+                while (ring_buffer.get_free_samples(channel) < block_size){
+                    std::this_thread::yield();
+                }
+                ring_buffer.push_block(channel, block.data(), block_size);
+            }
+        }
+    });
+
+    std::vector<float> result(block_size);
+    float expected = 0.f;
+    for (size_t n = 0; n < num_blocks; n++){
+        while (ring_buffer.get_available_samples() < block_size){
+            std::this_thread::yield();
+        }
+        for (size_t channel = 0; channel < num_channels; channel++){
+            ring_buffer.pop_block(channel, result.data(), block_size);
+            for (size_t i = 0; i < block_size; i++){
+                ASSERT_FLOAT_EQ(result[i], expected + (float) i);
+            }
+        }
+        expected += (float) block_size;
+    }
+    producer.join();
+}
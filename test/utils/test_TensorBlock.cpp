@@ -0,0 +1,77 @@
+#include "gtest/gtest.h"
+#include <anira/anira.h>
+#include <thread>
+
+using namespace anira;
+
+TEST(TensorBlock, WriteRead){
+    TensorBlock tensor_block(6);
+    std::vector<float> result(6);
+
+    // a new tensor is zero initialized
+    tensor_block.read(result.data(), result.size());
+    for (float value : result) {
+        EXPECT_FLOAT_EQ(value, 0.f);
+    }
+
+    std::vector<float> data = {1.f, 2.f, 3.f, 4.f, 5.f, 6.f};
+    tensor_block.write(data.data(), data.size());
+    float value = 7.f;
+    tensor_block.write(&value, 1, 2);
+
+    tensor_block.read(result.data(), result.size());
+    std::vector<float> expected = {1.f, 2.f, 7.f, 4.f, 5.f, 6.f};
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_FLOAT_EQ(result[i], expected[i]);
+    }
+}
+
+TEST(TensorBlock, ValueByValue){
+    size_t size = 9;
+    TensorBlock tensor_block(size);
+    std::vector<float> result(size);
+
+    // every write only brings the range of the previous one into the other copy, so all earlier values have to survive
+    for (int repeat = 0; repeat < 3; repeat++) {
+        for (size_t i = 0; i < size; i++) {
+            float value = (float) (repeat * size + i);
+            tensor_block.write(&value, 1, i);
+        }
+        tensor_block.read(result.data(), size);
+        for (size_t i = 0; i < size; i++) {
+            EXPECT_FLOAT_EQ(result[i], (float) (repeat * size + i)) << "repeat=" << repeat << ", i=" << i;
+        }
+    }
+}
+
+TEST(TensorBlock, ConsistentSnapshots){
+    size_t size = 1024;
+    size_t num_writes = 2000;
+    TensorBlock tensor_block(size);
+
+    // Every write fills the whole tensor with one value, so a snapshot that mixes two writes contains different values
+    auto writer = [&](float sign) {
+        std::vector<float> data(size);
+        for (size_t n = 1; n <= num_writes; n++) {
+            std::fill(data.begin(), data.end(), sign * (float) n);
+            tensor_block.write(data.data(), size);
+        }
+    };
+    std::thread first_writer(writer, 1.f);
+    std::thread second_writer(writer, -1.f);
+
+    std::vector<float> result(size);
+    size_t torn_snapshots = 0;
+    for (size_t n = 0; n < num_writes; n++) {
+        tensor_block.read(result.data(), size);
+        for (size_t i = 1; i < size; i++) {
+            if (result[i] != result[0]) {
+                torn_snapshots++;
+                break;
+            }
+        }
+    }
+    first_writer.join();
+    second_writer.join();
+    EXPECT_EQ(torn_snapshots, 0);
+}